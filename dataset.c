@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dataset.h"
+
+void datasetHeaderInit(datasetHeader *aHeader)
+{
+    memset(aHeader, 0, sizeof(*aHeader));
+
+    memcpy(aHeader->mMagic, DATASET_MAGIC, DATASET_MAGIC_LEN);
+
+    aHeader->mVersion    = DATASET_VERSION;
+    aHeader->mHeaderSize = sizeof(datasetHeader);
+    aHeader->mKeyType    = DATASET_KEY_UINT32;
+}
+
+/*
+ * Returns 1 if aBuffer starts with the magic of a binary dataset.
+ */
+int32_t datasetHasMagic(const void *aBuffer, size_t aSize)
+{
+    if (aSize < DATASET_MAGIC_LEN) return 0;
+
+    return memcmp(aBuffer, DATASET_MAGIC, DATASET_MAGIC_LEN) == 0 ? 1 : 0;
+}
+
+/*
+ * Returns NULL if the header describes a dataset that fits in aFileSize bytes,
+ * otherwise the reason it does not.
+ */
+const char *datasetCheckHeader(const datasetHeader *aHeader, size_t aFileSize)
+{
+    if (aFileSize < sizeof(datasetHeader) || datasetHasMagic(aHeader->mMagic, DATASET_MAGIC_LEN) == 0)
+    {
+        return "not a binary dataset";
+    }
+    else
+    {
+    }
+
+    if (aHeader->mVersion != DATASET_VERSION)
+    {
+        return "unsupported version or byte order";
+    }
+    else
+    {
+    }
+
+    if (aHeader->mHeaderSize < sizeof(datasetHeader) || aHeader->mHeaderSize > aFileSize)
+    {
+        return "invalid header size";
+    }
+    else
+    {
+    }
+
+    if (aHeader->mKeyType != DATASET_KEY_UINT32)
+    {
+        return "unsupported key type";
+    }
+    else
+    {
+    }
+
+    if (aHeader->mCount > (aFileSize - aHeader->mHeaderSize) / sizeof(uint32_t))
+    {
+        return "file is shorter than the count in its header";
+    }
+    else
+    {
+    }
+
+    return NULL;
+}
+
+/*
+ * Maps aFileName read-only. Returns 0 on success, -1 with errno set otherwise.
+ * The header is not checked, see datasetCheckHeader().
+ */
+int32_t datasetMapFile(const char *aFileName, datasetMap *aMap)
+{
+    struct stat  sStat;
+    void        *sBase;
+    int          sFd;
+    int          sErrno;
+
+    sFd = open(aFileName, O_RDONLY);
+
+    if (sFd < 0) return -1;
+
+    if (fstat(sFd, &sStat) != 0)
+    {
+        sErrno = errno;
+        (void)close(sFd);
+        errno  = sErrno;
+        return -1;
+    }
+    else
+    {
+    }
+
+    if (sStat.st_size < (off_t)sizeof(datasetHeader))
+    {
+        (void)close(sFd);
+        errno = EINVAL;
+        return -1;
+    }
+    else
+    {
+    }
+
+    sBase = mmap(NULL, sStat.st_size, PROT_READ, MAP_PRIVATE, sFd, 0);
+    sErrno = errno;
+
+    /* the mapping stays valid after close */
+    (void)close(sFd);
+
+    if (sBase == MAP_FAILED)
+    {
+        errno = sErrno;
+        return -1;
+    }
+    else
+    {
+    }
+
+    /* the keys are read once, front to back */
+    (void)madvise(sBase, sStat.st_size, MADV_SEQUENTIAL);
+
+    aMap->mBase   = sBase;
+    aMap->mSize   = sStat.st_size;
+    aMap->mHeader = (const datasetHeader *)sBase;
+    aMap->mKey    = (const uint32_t *)((const uint8_t *)sBase + aMap->mHeader->mHeaderSize);
+
+    return 0;
+}
+
+void datasetUnmapFile(datasetMap *aMap)
+{
+    (void)munmap(aMap->mBase, aMap->mSize);
+
+    aMap->mBase   = NULL;
+    aMap->mSize   = 0;
+    aMap->mHeader = NULL;
+    aMap->mKey    = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef __DATA_SET_H__
+#define __DATA_SET_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Binary dataset written by gendata and read by perf.
+ *
+ *      +----------------+------------------------------------+
+ *      | datasetHeader  | mCount keys, uint32_t, host order  |
+ *      +----------------+------------------------------------+
+ *      0                mHeaderSize
+ *
+ * The keys are laid out exactly as perf keeps them in memory,
+ * so loading is one mmap and one copy instead of parsing a line per key.
+ * A file written on a host of the other byte order is rejected (mVersion does not match).
+ */
+#define DATASET_MAGIC               "TIMSDATA"
+#define DATASET_MAGIC_LEN           8
+#define DATASET_VERSION             1
+#define DATASET_PATTERN_LEN         16
+
+typedef enum
+{
+    DATASET_KEY_NONE   = 0,
+    DATASET_KEY_UINT32 = 1
+} datasetKeyType;
+
+typedef struct datasetHeader
+{
+    char      mMagic[DATASET_MAGIC_LEN];        /* DATASET_MAGIC, not NUL terminated */
+    uint32_t  mVersion;
+    uint32_t  mHeaderSize;                      /* offset of the first key */
+
+    uint64_t  mCount;
+    uint64_t  mSeed;                            /* seed the generator was started with */
+
+    uint32_t  mKeyType;                         /* datasetKeyType */
+    uint32_t  mWidth;                           /* element width the data is meant for, 0 if not specified */
+    uint32_t  mKeyOffset;                       /* offset of the key inside an element */
+    uint32_t  mParam;                           /* pattern parameter (gendata -a), 0 if none */
+
+    char      mPattern[DATASET_PATTERN_LEN];    /* gendata pattern name, NUL padded */
+} datasetHeader;
+
+/*
+ * A dataset file mapped read-only
+ */
+typedef struct datasetMap
+{
+    void                 *mBase;
+    size_t                mSize;
+
+    const datasetHeader  *mHeader;
+    const uint32_t       *mKey;
+} datasetMap;
+
+void        datasetHeaderInit(datasetHeader *aHeader);
+int32_t     datasetHasMagic(const void *aBuffer, size_t aSize);
+const char *datasetCheckHeader(const datasetHeader *aHeader, size_t aFileSize);
+
+int32_t     datasetMapFile(const char *aFileName, datasetMap *aMap);
+void        datasetUnmapFile(datasetMap *aMap);
+
+#endif
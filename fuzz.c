@@ -0,0 +1,779 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "timsort.h"
+#include "timsort1.h"
+#include "pattern.h"
+
+/*
+ * Differential fuzzer of the sort engines.
+ *
+ * An input is decoded into a case : element count, width, gendata pattern,
+ * how many low bits of the keys are kept (few bits, many ties) and the way the
+ * comparator reports its result. Every engine sorts the same elements and has to
+ * come up with exactly the bytes of the reference, qsort() by (key, original index).
+ * Each element carries its original index and a payload derived from it, so a result
+ * that is ordered but not stable, or has lost or duplicated an element, fails too.
+ *
+ *      make fuzz         standalone driver, random inputs or files given as arguments
+ *      make libfuzzer    LLVMFuzzerTestOneInput() for clang -fsanitize=fuzzer
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Engines
+ * -----------------------------------------------------------------------------
+ */
+typedef int  fuzzCmpFunc(const void *, const void *);
+typedef void fuzzSortFunc(void *, size_t, size_t, fuzzCmpFunc *);
+
+typedef struct fuzzEngine
+{
+    const char    *mName;
+    fuzzSortFunc  *mSortFunc;
+} fuzzEngine;
+
+/*
+ * The smallest settings timConfCheck() takes : short runs, many merges,
+ * galloping at once and merge memory allocated by every merge
+ */
+static const timConf gSmallConf =
+{
+    TIM_CONF_MIN_MIN_MERGE, 1, 1,
+    TIM_CONF_DEFAULT_ADDRESSING, TIM_CONF_DEFAULT_MOVE, TIM_CONF_DEFAULT_MERGE,
+    TIM_CONF_DEFAULT_RUN_BLOCK, TIM_CONF_DEFAULT_BUFFER,
+    TIM_CONF_DEFAULT_HUGE_PAGE, TIM_CONF_DEFAULT_HUGE_TLB,
+    TIM_CONF_DEFAULT_STREAM, 0
+};
+
+static void fuzzTimsortSmall(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &gSmallConf, NULL);
+}
+
+static void fuzzTimsort1Small(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    (void)timsort1Conf(aArray, aElementCnt, aWidth, aCmpCb, &gSmallConf, NULL);
+}
+
+/*
+ * Blocks of 1 KiB, that is formed of a few short runs each
+ */
+static void fuzzTimsortRunBlock(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mRunBlock = 1;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+/*
+ * Merges between the array and a buffer of n elements
+ */
+static void fuzzTimsortPingPong(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mBuffer = TIM_BUFFER_PINGPONG;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+/*
+ * Merge memory of huge pages from 1 KiB, hugetlbfs ones if there are any
+ */
+static void fuzzTimsortHugePage(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mHugePage = 1;
+    sConf.mHugeTlb  = 1;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+/*
+ * Streaming stores for every merge, in place and ping-pong
+ */
+static void fuzzTimsortStream(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mStream = 1;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+static void fuzzStreamPingPong(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mStream = 1;
+    sConf.mBuffer = TIM_BUFFER_PINGPONG;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+/*
+ * Pointers sorted and the elements permuted, whatever their width
+ */
+static void fuzzTimsortTag(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb)
+{
+    timConf sConf = gSmallConf;
+
+    sConf.mTag = 1;
+
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);
+}
+
+/*
+ * Every build of timsort.c and both merge policies, with the small settings
+ */
+#define FUZZ_POLICY_ENGINE(_aFunc, _aAddressing, _aMove, _aMerge)                           \
+    static void _aFunc(void *aArray, size_t aElementCnt, size_t aWidth, fuzzCmpFunc *aCmpCb) \
+    {                                                                                       \
+        timConf sConf = gSmallConf;                                                         \
+                                                                                            \
+        sConf.mAddressing = (_aAddressing);                                                 \
+        sConf.mMove       = (_aMove);                                                       \
+        sConf.mMerge      = (_aMerge);                                                      \
+                                                                                            \
+        (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, &sConf, NULL);               \
+    }
+
+FUZZ_POLICY_ENGINE(fuzzIndexBytesGallop,   TIM_ADDRESSING_INDEX,   TIM_MOVE_BYTES, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzIndexBytesLinear,   TIM_ADDRESSING_INDEX,   TIM_MOVE_BYTES, TIM_MERGE_LINEAR)
+FUZZ_POLICY_ENGINE(fuzzIndexBlockGallop,   TIM_ADDRESSING_INDEX,   TIM_MOVE_BLOCK, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzIndexBlockLinear,   TIM_ADDRESSING_INDEX,   TIM_MOVE_BLOCK, TIM_MERGE_LINEAR)
+FUZZ_POLICY_ENGINE(fuzzIndexFixedGallop,   TIM_ADDRESSING_INDEX,   TIM_MOVE_FIXED, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzIndexFixedLinear,   TIM_ADDRESSING_INDEX,   TIM_MOVE_FIXED, TIM_MERGE_LINEAR)
+FUZZ_POLICY_ENGINE(fuzzPointerBytesGallop, TIM_ADDRESSING_POINTER, TIM_MOVE_BYTES, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzPointerBytesLinear, TIM_ADDRESSING_POINTER, TIM_MOVE_BYTES, TIM_MERGE_LINEAR)
+FUZZ_POLICY_ENGINE(fuzzPointerBlockGallop, TIM_ADDRESSING_POINTER, TIM_MOVE_BLOCK, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzPointerBlockLinear, TIM_ADDRESSING_POINTER, TIM_MOVE_BLOCK, TIM_MERGE_LINEAR)
+FUZZ_POLICY_ENGINE(fuzzPointerFixedGallop, TIM_ADDRESSING_POINTER, TIM_MOVE_FIXED, TIM_MERGE_GALLOP)
+FUZZ_POLICY_ENGINE(fuzzPointerFixedLinear, TIM_ADDRESSING_POINTER, TIM_MOVE_FIXED, TIM_MERGE_LINEAR)
+
+/*
+ * Checked against the reference. Specialized variants are to be added here.
+ */
+static const fuzzEngine gEngine[] =
+{
+    { "timsort",              timsort                },
+    { "timsort1",             timsort1               },
+    { "timsort-small",        fuzzTimsortSmall       },
+    { "timsort1-small",       fuzzTimsort1Small      },
+    { "timsort-runblock",     fuzzTimsortRunBlock    },
+    { "timsort-pingpong",     fuzzTimsortPingPong    },
+    { "timsort-hugepage",     fuzzTimsortHugePage    },
+    { "timsort-stream",       fuzzTimsortStream      },
+    { "timsort-stream-pp",    fuzzStreamPingPong     },
+    { "timsort-tag",          fuzzTimsortTag         },
+    { "index-bytes-gallop",   fuzzIndexBytesGallop   },
+    { "index-bytes-linear",   fuzzIndexBytesLinear   },
+    { "index-block-gallop",   fuzzIndexBlockGallop   },
+    { "index-block-linear",   fuzzIndexBlockLinear   },
+    { "index-fixed-gallop",   fuzzIndexFixedGallop   },
+    { "index-fixed-linear",   fuzzIndexFixedLinear   },
+    { "pointer-bytes-gallop", fuzzPointerBytesGallop },
+    { "pointer-bytes-linear", fuzzPointerBytesLinear },
+    { "pointer-block-gallop", fuzzPointerBlockGallop },
+    { "pointer-block-linear", fuzzPointerBlockLinear },
+    { "pointer-fixed-gallop", fuzzPointerFixedGallop },
+    { "pointer-fixed-linear", fuzzPointerFixedLinear },
+    { NULL,                   NULL                   }
+};
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Comparators
+ * -----------------------------------------------------------------------------
+ */
+static uint32_t fuzzGetKey(const void *aElem)
+{
+    uint32_t sKey;
+
+    /* odd widths leave the key unaligned */
+    memcpy(&sKey, aElem, sizeof(sKey));
+
+    return sKey;
+}
+
+static int fuzzCompareUnit(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1 = fuzzGetKey(aElem1);
+    uint32_t sKey2 = fuzzGetKey(aElem2);
+
+    return (sKey1 > sKey2) - (sKey1 < sKey2);
+}
+
+/*
+ * Any magnitude, as strcmp() or a subtraction would return.
+ * Derived from the keys, so that the same pair always gets the same answer.
+ */
+static int fuzzCompareMagnitude(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1      = fuzzGetKey(aElem1);
+    uint32_t sKey2      = fuzzGetKey(aElem2);
+    int      sMagnitude = 1 + (int)(((sKey1 ^ sKey2) * 2654435761u) % INT_MAX);
+
+    if (sKey1 == sKey2) return 0;
+
+    return sKey1 > sKey2 ? sMagnitude : -sMagnitude;
+}
+
+static int fuzzCompareExtreme(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1 = fuzzGetKey(aElem1);
+    uint32_t sKey2 = fuzzGetKey(aElem2);
+
+    if (sKey1 == sKey2) return 0;
+
+    return sKey1 > sKey2 ? INT_MAX : INT_MIN;
+}
+
+static const struct
+{
+    const char   *mName;
+    fuzzCmpFunc  *mCompareFunc;
+} gComparator[] =
+{
+    { "unit",      fuzzCompareUnit      },      /* -1, 0, 1 */
+    { "magnitude", fuzzCompareMagnitude },      /* anything but 0 for unequal keys */
+    { "extreme",   fuzzCompareExtreme   }       /* INT_MIN, 0, INT_MAX */
+};
+
+#define FUZZ_COMPARATOR_CNT     (sizeof(gComparator) / sizeof(gComparator[0]))
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Decoding A Case
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Widths below 8 have no room for the original index, only the keys are compared.
+ * Odd ones exercise the byte by byte copies.
+ */
+static const size_t gWidth[] = { 4, 8, 9, 12, 16, 24, 33, 64 };
+
+#define FUZZ_WIDTH_CNT          (sizeof(gWidth) / sizeof(gWidth[0]))
+#define FUZZ_INDEX_OFFSET       4
+#define FUZZ_PAYLOAD_OFFSET     8
+
+typedef struct fuzzCase
+{
+    uint32_t    mCount;
+    size_t      mWidth;
+    patternId   mPattern;
+    uint32_t    mParam;
+    uint32_t    mKeyBits;       /* keys are cut to their low mKeyBits bits */
+    uint32_t    mComparator;    /* index of gComparator */
+    uint64_t    mSeed;
+} fuzzCase;
+
+/*
+ * Reads the input a byte at a time, zeros past its end,
+ * so that any input, even an empty one, is a valid case.
+ */
+typedef struct fuzzReader
+{
+    const uint8_t *mData;
+    size_t         mSize;
+    size_t         mPos;
+} fuzzReader;
+
+static uint64_t fuzzRead(fuzzReader *aReader, uint32_t aByteCnt)
+{
+    uint64_t sValue = 0;
+    uint32_t i;
+
+    for (i = 0; i < aByteCnt; i++)
+    {
+        sValue <<= 8;
+
+        if (aReader->mPos < aReader->mSize)
+        {
+            sValue |= aReader->mData[aReader->mPos];
+        }
+        else
+        {
+        }
+
+        aReader->mPos++;
+    }
+
+    return sValue;
+}
+
+/*
+ * Counts up to 65535 : enough for several runs of minrun, long merges and galloping.
+ * Most cases are small though, where the boundaries are.
+ */
+static void fuzzDecode(const uint8_t *aData, size_t aSize, fuzzCase *aCase)
+{
+    static const uint32_t sCountLimit[] = { 16, 256, 4096, 65536 };
+
+    fuzzReader sReader = { aData, aSize, 0 };
+    uint32_t   sDefault;
+    uint32_t   sMin;
+    uint32_t   sBits;
+
+    aCase->mCount      = (uint32_t)fuzzRead(&sReader, 2) % sCountLimit[fuzzRead(&sReader, 1) % 4];
+    aCase->mWidth      = gWidth[fuzzRead(&sReader, 1) % FUZZ_WIDTH_CNT];
+    aCase->mPattern    = (patternId)(PATTERN_NONE + 1 + fuzzRead(&sReader, 1) % (PATTERN_MAX - 1));
+    aCase->mParam      = (uint32_t)fuzzRead(&sReader, 2);
+    aCase->mComparator = (uint32_t)fuzzRead(&sReader, 1) % FUZZ_COMPARATOR_CNT;
+
+    /* half of the cases keep the keys whole */
+    sBits              = (uint32_t)fuzzRead(&sReader, 1);
+    aCase->mKeyBits    = (sBits & 0x80) != 0 ? 32 : sBits % 33;
+
+    aCase->mSeed       = fuzzRead(&sReader, 8);
+
+    if (patternTakesParam(aCase->mPattern, aCase->mCount, &sDefault, &sMin) == 1)
+    {
+        /* around the default, which may be far off for a small count */
+        aCase->mParam = sMin + aCase->mParam % (2 * sDefault + 1);
+
+        if (aCase->mPattern == PATTERN_SORTED_TAIL && aCase->mParam > aCase->mCount)
+        {
+            aCase->mParam = aCase->mCount;
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+        aCase->mParam = 0;
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Running A Case
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * (key, original index) : unique, so any correct sort by it, qsort() included,
+ * gives the one stable order
+ */
+typedef struct fuzzRef
+{
+    uint32_t mKey;
+    uint32_t mIndex;
+} fuzzRef;
+
+static int fuzzCompareRef(const void *aElem1, const void *aElem2)
+{
+    const fuzzRef *sRef1 = aElem1;
+    const fuzzRef *sRef2 = aElem2;
+
+    if (sRef1->mKey != sRef2->mKey)
+    {
+        return sRef1->mKey > sRef2->mKey ? 1 : -1;
+    }
+    else
+    {
+        return (sRef1->mIndex > sRef2->mIndex) - (sRef1->mIndex < sRef2->mIndex);
+    }
+}
+
+static void fuzzBuildElement(uint8_t *aElem, size_t aWidth, uint32_t aKey, uint32_t aIndex)
+{
+    size_t j;
+
+    memcpy(aElem, &aKey, sizeof(aKey));
+
+    if (aWidth >= FUZZ_PAYLOAD_OFFSET)
+    {
+        memcpy(aElem + FUZZ_INDEX_OFFSET, &aIndex, sizeof(aIndex));
+
+        for (j = FUZZ_PAYLOAD_OFFSET; j < aWidth; j++)
+        {
+            aElem[j] = (uint8_t)(aIndex * 131 + j);
+        }
+    }
+    else
+    {
+    }
+}
+
+static void fuzzPrintCase(FILE *aFileHandle, const fuzzCase *aCase)
+{
+    (void)fprintf(aFileHandle, "count %u, width %zu, pattern %s:%u, key bits %u, comparator %s, seed %llu\n",
+                  aCase->mCount, aCase->mWidth, patternName(aCase->mPattern), aCase->mParam,
+                  aCase->mKeyBits, gComparator[aCase->mComparator].mName,
+                  (unsigned long long)aCase->mSeed);
+}
+
+/*
+ * Set by the standalone driver, to save the input of a failing case
+ */
+static const uint8_t *gInput     = NULL;
+static size_t         gInputSize = 0;
+
+#define FUZZ_CRASH_FILE_NAME    "fuzz-crash.bin"
+
+static void fuzzFail(const fuzzCase  *aCase,
+                     const char      *aEngine,
+                     const uint8_t   *aExpected,
+                     const uint8_t   *aActual,
+                     uint32_t         aPos)
+{
+    const uint8_t *sExpected = aExpected + aPos * aCase->mWidth;
+    const uint8_t *sActual   = aActual + aPos * aCase->mWidth;
+    uint32_t       sIndex[2] = { 0, 0 };
+    FILE          *sFileHandle;
+
+    if (aCase->mWidth >= FUZZ_PAYLOAD_OFFSET)
+    {
+        memcpy(&sIndex[0], sExpected + FUZZ_INDEX_OFFSET, sizeof(uint32_t));
+        memcpy(&sIndex[1], sActual + FUZZ_INDEX_OFFSET, sizeof(uint32_t));
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "\nFAIL : %s differs from the reference at element %u\n", aEngine, aPos);
+    (void)fprintf(stderr, "       expected key %u index %u, got key %u index %u\n",
+                  fuzzGetKey(sExpected), sIndex[0], fuzzGetKey(sActual), sIndex[1]);
+    (void)fprintf(stderr, "       ");
+    fuzzPrintCase(stderr, aCase);
+
+    if (gInput != NULL)
+    {
+        sFileHandle = fopen(FUZZ_CRASH_FILE_NAME, "wb");
+
+        if (sFileHandle != NULL && fwrite(gInput, 1, gInputSize, sFileHandle) == gInputSize)
+        {
+            (void)fprintf(stderr, "       input saved to '%s'\n", FUZZ_CRASH_FILE_NAME);
+        }
+        else
+        {
+        }
+
+        if (sFileHandle != NULL) (void)fclose(sFileHandle);
+    }
+    else
+    {
+    }
+
+    abort();
+}
+
+static void fuzzRunCase(const fuzzCase *aCase)
+{
+    patternGen  sGen;
+    uint32_t   *sKey;
+    fuzzRef    *sRef;
+    uint8_t    *sSource;
+    uint8_t    *sExpected;
+    uint8_t    *sActual;
+    size_t      sSize    = (size_t)aCase->mCount * aCase->mWidth;
+    uint32_t    sKeyMask = aCase->mKeyBits >= 32 ? UINT32_MAX : ((uint32_t)1 << aCase->mKeyBits) - 1;
+    uint32_t    i;
+    uint32_t    j;
+
+    /* + 1 : malloc(0) may return NULL */
+    sKey      = malloc(sizeof(uint32_t) * aCase->mCount + 1);
+    sRef      = malloc(sizeof(fuzzRef) * aCase->mCount + 1);
+    sSource   = malloc(sSize + 1);
+    sExpected = malloc(sSize + 1);
+    sActual   = malloc(sSize + 1);
+    assert(sKey != NULL && sRef != NULL && sSource != NULL && sExpected != NULL && sActual != NULL);
+
+    if (patternInit(&sGen, aCase->mPattern, aCase->mCount, aCase->mParam, aCase->mSeed) != 0)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    patternFill(&sGen, 0, aCase->mCount, sKey);
+    patternDestroy(&sGen);
+
+    for (i = 0; i < aCase->mCount; i++)
+    {
+        sRef[i].mKey   = sKey[i] & sKeyMask;
+        sRef[i].mIndex = i;
+
+        fuzzBuildElement(sSource + (size_t)i * aCase->mWidth, aCase->mWidth, sRef[i].mKey, i);
+    }
+
+    qsort(sRef, aCase->mCount, sizeof(fuzzRef), fuzzCompareRef);
+
+    for (i = 0; i < aCase->mCount; i++)
+    {
+        fuzzBuildElement(sExpected + (size_t)i * aCase->mWidth, aCase->mWidth, sRef[i].mKey, sRef[i].mIndex);
+    }
+
+    for (j = 0; gEngine[j].mName != NULL; j++)
+    {
+        memcpy(sActual, sSource, sSize);
+
+        (*gEngine[j].mSortFunc)(sActual, aCase->mCount, aCase->mWidth, gComparator[aCase->mComparator].mCompareFunc);
+
+        if (memcmp(sActual, sExpected, sSize) != 0)
+        {
+            for (i = 0; i < aCase->mCount; i++)
+            {
+                if (memcmp(sActual + (size_t)i * aCase->mWidth,
+                           sExpected + (size_t)i * aCase->mWidth,
+                           aCase->mWidth) != 0)
+                {
+                    break;
+                }
+                else
+                {
+                }
+            }
+
+            fuzzFail(aCase, gEngine[j].mName, sExpected, sActual, i);
+        }
+        else
+        {
+        }
+    }
+
+    free(sKey);
+    free(sRef);
+    free(sSource);
+    free(sExpected);
+    free(sActual);
+}
+
+/*
+ * libFuzzer entry point
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *aData, size_t aSize)
+{
+    fuzzCase sCase;
+
+    fuzzDecode(aData, aSize, &sCase);
+    fuzzRunCase(&sCase);
+
+    return 0;
+}
+
+#ifndef TIM_FUZZ_LIBFUZZER
+/*
+ * -----------------------------------------------------------------------------
+ *  Standalone Driver
+ * -----------------------------------------------------------------------------
+ */
+#define FUZZ_DEFAULT_ITERATION_CNT  10000
+#define FUZZ_INPUT_SIZE             17          /* bytes fuzzDecode() reads */
+#define FUZZ_MAX_INPUT_SIZE         4096
+
+typedef struct fuzzConf
+{
+    int64_t     mIterationCnt;
+    int64_t     mSeed;              /* -1 : time */
+    int32_t     mVerbose;
+    int32_t     mFileCnt;
+    char      **mFileName;          /* inputs to replay instead of random ones */
+} fuzzConf;
+
+/*
+ * splitmix64, as in pattern.c
+ */
+static uint64_t fuzzMix(uint64_t aValue)
+{
+    aValue += 0x9e3779b97f4a7c15ULL;
+    aValue  = (aValue ^ (aValue >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    aValue  = (aValue ^ (aValue >> 27)) * 0x94d049bb133111ebULL;
+
+    return aValue ^ (aValue >> 31);
+}
+
+static void fuzzRunInput(const fuzzConf *aConf, const uint8_t *aData, size_t aSize)
+{
+    fuzzCase sCase;
+
+    gInput     = aData;
+    gInputSize = aSize;
+
+    fuzzDecode(aData, aSize, &sCase);
+
+    if (aConf->mVerbose == 1) fuzzPrintCase(stderr, &sCase);
+
+    fuzzRunCase(&sCase);
+}
+
+static void fuzzReplayFile(const fuzzConf *aConf, const char *aFileName)
+{
+    uint8_t  sData[FUZZ_MAX_INPUT_SIZE];
+    size_t   sSize;
+    FILE    *sFileHandle;
+
+    sFileHandle = fopen(aFileName, "rb");
+
+    if (sFileHandle == NULL)
+    {
+        (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n", aFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    sSize = fread(sData, 1, sizeof(sData), sFileHandle);
+    (void)fclose(sFileHandle);
+
+    (void)fprintf(stderr, "%s : ", aFileName);
+    fuzzRunInput(aConf, sData, sSize);
+    (void)fprintf(stderr, "OK\n");
+}
+
+static void fuzzRunRandom(const fuzzConf *aConf)
+{
+    uint8_t  sData[FUZZ_INPUT_SIZE];
+    uint64_t sRandom = 0;
+    int64_t  i;
+    uint32_t j;
+
+    for (i = 0; i < aConf->mIterationCnt; i++)
+    {
+        for (j = 0; j < FUZZ_INPUT_SIZE; j++)
+        {
+            if (j % 8 == 0) sRandom = fuzzMix((uint64_t)aConf->mSeed * 0x100000000ULL + i * 4 + j / 8);
+
+            sData[j] = (uint8_t)sRandom;
+            sRandom >>= 8;
+        }
+
+        fuzzRunInput(aConf, sData, sizeof(sData));
+
+        if ((i + 1) % 10000 == 0)
+        {
+            (void)fprintf(stderr, "%lld cases OK\n", (long long)(i + 1));
+        }
+        else
+        {
+        }
+    }
+}
+
+static void printUsageAndExit(char *aProgramName)
+{
+    (void)fprintf(stderr, "Usage : %s [ options ] [ input_file ... ]\n"
+                          "  -n NUM      random cases to run (default %d)\n"
+                          "  -s NUM      seed of the random cases (default : current time)\n"
+                          "  -v          print every case\n"
+                          "  input_file  run these inputs instead, e.g. %s or crashes saved by libFuzzer\n",
+                          aProgramName, FUZZ_DEFAULT_ITERATION_CNT, FUZZ_CRASH_FILE_NAME);
+    exit(1);
+}
+
+static int64_t processArgGetInteger(char *aProgramName, char *aOption, char *aValue)
+{
+    long long  sValue;
+    char      *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtoll(aValue, &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue < 0 || *sEndPtr != '\0' || sEndPtr == aValue)
+    {
+        (void)fprintf(stderr, "error : option '%s' accepts a non-negative integer.\n", aOption);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return sValue;
+}
+
+static void processArg(int32_t aArgc, char *aArgv[], fuzzConf *aConf)
+{
+    int32_t i;
+
+    aConf->mIterationCnt = FUZZ_DEFAULT_ITERATION_CNT;
+    aConf->mSeed         = -1;
+    aConf->mVerbose      = 0;
+    aConf->mFileCnt      = 0;
+    aConf->mFileName     = NULL;
+
+    for (i = 1; i < aArgc; i++)
+    {
+        char *sValue = (i + 1 < aArgc) ? aArgv[i + 1] : NULL;
+
+        if (strcmp(aArgv[i], "-n") == 0)
+        {
+            aConf->mIterationCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-s") == 0)
+        {
+            aConf->mSeed = processArgGetInteger(aArgv[0], aArgv[i], sValue);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-v") == 0)
+        {
+            aConf->mVerbose = 1;
+        }
+        else if (aArgv[i][0] == '-')
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+        else
+        {
+            /* the rest are input files */
+            aConf->mFileCnt  = aArgc - i;
+            aConf->mFileName = &aArgv[i];
+            break;
+        }
+    }
+
+    if (aConf->mSeed < 0) aConf->mSeed = (int64_t)time(NULL);
+}
+
+int32_t main(int32_t aArgc, char *aArgv[])
+{
+    fuzzConf sConf;
+    int32_t  i;
+
+    processArg(aArgc, aArgv, &sConf);
+
+    if (sConf.mFileCnt > 0)
+    {
+        for (i = 0; i < sConf.mFileCnt; i++)
+        {
+            fuzzReplayFile(&sConf, sConf.mFileName[i]);
+        }
+    }
+    else
+    {
+        (void)fprintf(stderr, "Running %lld random cases, seed %lld\n",
+                      (long long)sConf.mIterationCnt, (long long)sConf.mSeed);
+
+        fuzzRunRandom(&sConf);
+
+        (void)fprintf(stderr, "All %lld cases OK\n", (long long)sConf.mIterationCnt);
+    }
+
+    return 0;
+}
+#endif
@@ -6,246 +6,358 @@
 #include <time.h>
 #include <stdint.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "dataset.h"
+#include "pattern.h"
 
 /*
  * -----------------------------------------------------------------------------
  *  Configure
  * -----------------------------------------------------------------------------
  */
-static const char *gPatternName[] = 
-{
-    "None",
-    "random",
-    "sorted",
-    "reversed",
-    "sinwave1",
-    "chainsaw",
-    "identical",
-    NULL
-};
-
 typedef enum
 {
-    GEN_DATA_ORDER_ASCENDING,
-    GEN_DATA_ORDER_DESCENDING
-} genDataOrder;
-
-typedef enum
-{
-    GEN_DATA_PATTERN_NONE,
-    GEN_DATA_PATTERN_RANDOM,
-    GEN_DATA_PATTERN_SORTED,
-    GEN_DATA_PATTERN_SORTED_REVERSE,
-    GEN_DATA_PATTERN_SINWAVE1,
-    GEN_DATA_PATTERN_CHAINSAW,
-    GEN_DATA_PATTERN_IDENTICAL,
-    /* GEN_DATA_PATTERN_ALMOST, */
-    GEN_DATA_PATTERN_MAX,
-} genDataPattern;
+    GEN_DATA_FORMAT_NONE,
+    GEN_DATA_FORMAT_BINARY,
+    GEN_DATA_FORMAT_TEXT
+} genDataFormat;
 
 typedef struct genDataConf
 {
-    int32_t         mCount;
-    genDataPattern  mPattern;
+    int64_t         mCount;         /* at most GEN_DATA_MAX_COUNT */
+    patternId       mPattern;
+
+    /*
+     * Element layout the data is meant for. Written to the header so that
+     * perf builds elements of mWidth bytes with the key at mKeyOffset.
+     * -1 : not specified
+     */
+    int32_t         mWidth;
+    int32_t         mKeyOffset;
+
+    genDataFormat   mFormat;
+    int32_t         mSeed;          /* for the random based patterns, recorded in the binary header. -1 : time */
+    int32_t         mParam;         /* -a, pattern specific. -1 : pattern default */
+
+    char           *mFileName;      /* -f, NULL : stdout */
+    int32_t         mThreadCnt;     /* -t, -1 : online cpus */
 } genDataConf;
 
 static void genDataConfInit(genDataConf *aConf)
 {
-    aConf->mCount   = -1;
-    aConf->mPattern = GEN_DATA_PATTERN_NONE;
+    aConf->mCount     = -1;
+    aConf->mPattern   = PATTERN_NONE;
+    aConf->mWidth     = -1;
+    aConf->mKeyOffset = -1;
+    aConf->mFormat    = GEN_DATA_FORMAT_NONE;
+    aConf->mSeed      = -1;
+    aConf->mParam     = -1;
+    aConf->mFileName  = NULL;
+    aConf->mThreadCnt = -1;
 }
 
 /*
  * -----------------------------------------------------------------------------
- *  Already Sorted Array
+ *  Output
  * -----------------------------------------------------------------------------
  */
-static int genCmpInt(const void *a, const void *b)
-{
-    return (*(uint32_t *)a - *(uint32_t *)b);
-}
+#define GEN_DATA_BUFFER_SIZE    (1024 * 1024)
+#define GEN_DATA_MAX_DIGIT_CNT  10                  /* UINT32_MAX */
+#define GEN_DATA_CHUNK_CNT      (256 * 1024)        /* elements generated at a time */
+#define GEN_DATA_MAX_COUNT      ((int64_t)1 << 40)  /* -c, 4 TiB of keys */
 
-static void genDataMakeSortedArray(uint32_t *aArray, uint32_t aSize)
+/*
+ * Text lines are collected here and written to stdout a buffer at a time
+ */
+typedef struct genDataOutput
 {
-    uint32_t i;
-    char     sRandState[256];
+    size_t         mUsed;
+    char           mBuffer[GEN_DATA_BUFFER_SIZE];
+} genDataOutput;
 
-    (void)initstate(time(NULL), sRandState, 256);
+static genDataOutput gOutput;
 
-    for (i = 0; i < aSize; i++)
+static void genDataWrite(const void *aData, size_t aSize)
+{
+    if (fwrite(aData, 1, aSize, stdout) != aSize)
+    {
+        (void)fprintf(stderr, "error : cannot write output. %s (errno %d)\n", strerror(errno), errno);
+        exit(1);
+    }
+    else
     {
-        aArray[i] = (uint32_t)random();
     }
-
-    qsort(aArray, aSize, sizeof(uint32_t), genCmpInt);
 }
 
-static void genDataGenerateSorted(uint32_t aSampleCnt, genDataOrder aOrder)
+static void genDataFlush(void)
 {
-    uint32_t  i;
-    uint32_t  sStart = 0;
-    int32_t   sDelta = 0;
-    uint32_t  sIndex;
+    genDataWrite(gOutput.mBuffer, gOutput.mUsed);
+    gOutput.mUsed = 0;
 
-    uint32_t *sArray = NULL;
-
-    sArray = malloc(sizeof(uint32_t) * aSampleCnt);
-    assert(sArray != NULL);
+    if (fflush(stdout) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot write output. %s (errno %d)\n", strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+}
 
-    genDataMakeSortedArray(sArray, aSampleCnt);
+static void genDataEmitText(uint32_t aValue)
+{
+    char     sDigit[GEN_DATA_MAX_DIGIT_CNT];
+    uint32_t sDigitCnt = 0;
 
-    switch (aOrder)
+    if (gOutput.mUsed + GEN_DATA_MAX_DIGIT_CNT + 1 > GEN_DATA_BUFFER_SIZE)
+    {
+        genDataFlush();
+    }
+    else
     {
-        case GEN_DATA_ORDER_ASCENDING:
-            sStart = 0;
-            sDelta = 1;
-            break;
-        case GEN_DATA_ORDER_DESCENDING:
-            sStart = aSampleCnt - 1;
-            sDelta = -1;
-            break;
     }
 
-    sIndex = sStart;
+    do
+    {
+        sDigit[sDigitCnt++] = '0' + aValue % 10;
+        aValue /= 10;
+    } while (aValue != 0);
 
-    for (i = 0; i < aSampleCnt; i++)
+    while (sDigitCnt > 0)
     {
-        (void)fprintf(stdout, "%u\n", sArray[sIndex]);
-        sIndex += sDelta;
+        gOutput.mBuffer[gOutput.mUsed++] = sDigit[--sDigitCnt];
     }
 
-    free(sArray);
+    gOutput.mBuffer[gOutput.mUsed++] = '\n';
 }
 
-/*
- * -----------------------------------------------------------------------------
- *  Almost Sorted Array with 0.1 * N permutations
- * -----------------------------------------------------------------------------
- */
-#if 0
-static void genDataGenerateAlmostSorted(uint32_t aSampleCnt)
+static void genDataMakeHeader(const genDataConf *aConf, datasetHeader *aHeader)
 {
-    uint32_t *sArray = NULL;
-
-    sArray = malloc(sizeof(uint32_t) * aSampleCnt);
-    assert(sArray != NULL);
+    datasetHeaderInit(aHeader);
 
-    genDataMakeSortedArray(sArray, aSampleCnt);
+    aHeader->mCount     = (uint64_t)aConf->mCount;
+    aHeader->mSeed      = aConf->mSeed;
+    aHeader->mWidth     = aConf->mWidth >= 0 ? aConf->mWidth : 0;
+    aHeader->mKeyOffset = aConf->mKeyOffset >= 0 ? aConf->mKeyOffset : 0;
+    aHeader->mParam     = aConf->mParam;
 
-    free(sArray);
+    (void)strncpy(aHeader->mPattern, patternName(aConf->mPattern), DATASET_PATTERN_LEN - 1);
 }
-#endif
 
 /*
- * -----------------------------------------------------------------------------
- *  Sine wave type 1
- * -----------------------------------------------------------------------------
+ * One thread, one buffer, written where it belongs. Stops at the first error.
  */
-static void genDataGenerateSinWave1(uint32_t aSampleCnt, uint32_t aCycleCount)
+static void genDataPwrite(int aFd, const void *aData, size_t aSize, off_t aOffset)
 {
-    uint32_t  i;
+    ssize_t sWritten;
 
-    double    x = 0;
-    double    sValue;
-    double    sDelta;
-
-    sDelta = 2 * aCycleCount * M_PI / aSampleCnt;
-
-    for (i = 0; i < aSampleCnt; i++)
+    while (aSize > 0)
     {
-        x += sDelta;
+        sWritten = pwrite(aFd, aData, aSize, aOffset);
 
-        sValue  = (sin(x) + 1) * 100000 * x;
+        if (sWritten < 0)
+        {
+            if (errno == EINTR) continue;
 
-        (void)fprintf(stdout, "%u\n", 0xFFFFFFFF - (uint32_t)sValue);
-        // sArray[i] = (uint32_t)sValue;
+            (void)fprintf(stderr, "error : cannot write output. %s (errno %d)\n", strerror(errno), errno);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aData    = (const uint8_t *)aData + sWritten;
+        aSize   -= sWritten;
+        aOffset += sWritten;
     }
 }
 
-/*
- * -----------------------------------------------------------------------------
- *  Sine wave type 2
- * -----------------------------------------------------------------------------
- */
-#if 0
-static void genDataGenerateSinWave2(uint32_t aSampleCnt, uint32_t aCycleCount)
+typedef struct genDataThread
 {
-    uint32_t  i;
-
-    double    x = 0;
-    double    sValue;
-    double    sDelta;
+    const patternGen *mGen;
+    int               mFd;
+    off_t             mOffset;      /* where element 0 is in the file */
+    uint64_t          mBegin;       /* elements of this thread */
+    uint64_t          mEnd;
+    pthread_t         mThread;
+} genDataThread;
+
+static void *genDataThreadMain(void *aArg)
+{
+    genDataThread *sThread = (genDataThread *)aArg;
+    uint32_t      *sBuffer;
+    uint64_t       sCount;
+    uint64_t       i;
 
-    sDelta = 2 * aCycleCount * M_PI / aSampleCnt;
+    sBuffer = malloc(sizeof(uint32_t) * GEN_DATA_CHUNK_CNT);
+    assert(sBuffer != NULL);
 
-    for (i = 0; i < aSampleCnt; i++)
+    for (i = sThread->mBegin; i < sThread->mEnd; i += sCount)
     {
-        x += sDelta;
+        sCount = sThread->mEnd - i < GEN_DATA_CHUNK_CNT ? sThread->mEnd - i : GEN_DATA_CHUNK_CNT;
 
-        sValue  = (sin(x) + 1) * 10000000;
-        sValue += (cos(M_PI * x) + 1) * 10000000;
+        patternFill(sThread->mGen, i, i + sCount, sBuffer);
 
-        (void)fprintf(stdout, "%u\n", (uint32_t)sValue);
+        genDataPwrite(sThread->mFd,
+                      sBuffer,
+                      sizeof(uint32_t) * sCount,
+                      sThread->mOffset + (off_t)sizeof(uint32_t) * i);
     }
+
+    free(sBuffer);
+
+    return NULL;
 }
-#endif
 
 /*
- * -----------------------------------------------------------------------------
- *  Chainsaw (monotonic sinwave)
- * -----------------------------------------------------------------------------
+ * Returns 1 if stdout is a file binary data can be written to at any offset.
+ * A pipe, or a file opened for appending (>>), has to be written in order.
  */
-static void genDataGenerateChainsaw(uint32_t aSampleCnt, uint32_t aCycleCount)
+static int32_t genDataCanPwrite(int aFd, off_t *aStart)
 {
-    uint32_t  i;
+    struct stat sStat;
+    int         sFlags;
 
-    double    x = 0;
-    double    sValue;
-    double    sDelta;
+    if (fstat(aFd, &sStat) != 0 || S_ISREG(sStat.st_mode) == 0) return 0;
 
-    sDelta = 2 * aCycleCount * M_PI / aSampleCnt;
+    sFlags = fcntl(aFd, F_GETFL);
 
-    for (i = 0; i < aSampleCnt; i++)
-    {
-        x += sDelta;
+    if (sFlags < 0 || (sFlags & O_APPEND) != 0) return 0;
 
-        sValue  = (sin(x) + 1) * 100000;
+    *aStart = lseek(aFd, 0, SEEK_CUR);
 
-        (void)fprintf(stdout, "%u\n", 0xFFFFFFFF - (uint32_t)sValue);
-    }
+    return *aStart >= 0 ? 1 : 0;
 }
 
 /*
- * -----------------------------------------------------------------------------
- *  Identical Values
- * -----------------------------------------------------------------------------
+ * Binary data with aConf->mThreadCnt threads, each writing its own slice with pwrite
  */
-static void genDataGenerateIdentical(uint32_t aSampleCnt)
+static void genDataGenerateParallel(const genDataConf *aConf, const patternGen *aGen, int aFd, off_t aStart)
 {
-    uint32_t  i;
+    genDataThread *sThread;
+    datasetHeader  sHeader;
+    uint64_t       sCount     = (uint64_t)aConf->mCount;
+    uint32_t       sThreadCnt = aConf->mThreadCnt;
+    uint64_t       sSliceLen;
+    off_t          sEnd;
+    uint32_t       i;
+
+    if (sThreadCnt > sCount / GEN_DATA_CHUNK_CNT + 1)
+    {
+        /* not worth a thread */
+        sThreadCnt = (uint32_t)(sCount / GEN_DATA_CHUNK_CNT + 1);
+    }
+    else
+    {
+    }
+
+    sThread = calloc(sThreadCnt, sizeof(genDataThread));
+    assert(sThread != NULL);
+
+    genDataMakeHeader(aConf, &sHeader);
 
-    for (i = 0; i < aSampleCnt; i++)
+    sEnd = aStart + sizeof(sHeader) + (off_t)sizeof(uint32_t) * sCount;
+
+    /* the file gets its final size at once, instead of growing with every write */
+    if (ftruncate(aFd, sEnd) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot size output. %s (errno %d)\n", strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    genDataPwrite(aFd, &sHeader, sizeof(sHeader), aStart);
+
+    sSliceLen = (sCount + sThreadCnt - 1) / sThreadCnt;
+
+    for (i = 0; i < sThreadCnt; i++)
+    {
+        sThread[i].mGen    = aGen;
+        sThread[i].mFd     = aFd;
+        sThread[i].mOffset = aStart + sizeof(sHeader);
+        sThread[i].mBegin  = i * sSliceLen < sCount ? i * sSliceLen : sCount;
+        sThread[i].mEnd    = sThread[i].mBegin + sSliceLen < sCount ? sThread[i].mBegin + sSliceLen : sCount;
+
+        if (pthread_create(&sThread[i].mThread, NULL, genDataThreadMain, &sThread[i]) != 0)
+        {
+            (void)fprintf(stderr, "error : cannot create thread.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+
+    for (i = 0; i < sThreadCnt; i++)
     {
-        (void)fprintf(stdout, "1234567\n");
+        (void)pthread_join(sThread[i].mThread, NULL);
     }
+
+    /* as if written in order, for whatever writes to stdout next */
+    (void)lseek(aFd, sEnd, SEEK_SET);
+
+    free(sThread);
 }
 
 /*
- * -----------------------------------------------------------------------------
- *  Random
- * -----------------------------------------------------------------------------
+ * Text, or binary data to a pipe
  */
-static void genDataGenerateRandom(uint32_t aSampleCnt)
+static void genDataGenerateSerial(const genDataConf *aConf, const patternGen *aGen)
 {
-    uint32_t  i;
-    char      sRandState[256];
+    uint32_t *sBuffer;
+    uint64_t  sTotal = (uint64_t)aConf->mCount;
+    uint64_t  sCount;
+    uint64_t  i;
+    uint32_t  j;
 
-    (void)initstate(time(NULL), sRandState, 256);
+    sBuffer = malloc(sizeof(uint32_t) * GEN_DATA_CHUNK_CNT);
+    assert(sBuffer != NULL);
 
-    for (i = 0; i < aSampleCnt; i++)
+    if (aConf->mFormat == GEN_DATA_FORMAT_BINARY)
     {
-        (void)fprintf(stdout, "%u\n", (uint32_t)random());
+        datasetHeader sHeader;
+
+        genDataMakeHeader(aConf, &sHeader);
+        genDataWrite(&sHeader, sizeof(sHeader));
+    }
+    else if (aConf->mWidth >= 0)
+    {
+        /* count, and element layout if specified */
+        (void)fprintf(stdout, "#%llu %d %d\n", (unsigned long long)sTotal, aConf->mWidth, aConf->mKeyOffset);
     }
+    else
+    {
+        (void)fprintf(stdout, "#%llu\n", (unsigned long long)sTotal);
+    }
+
+    for (i = 0; i < sTotal; i += sCount)
+    {
+        sCount = sTotal - i < GEN_DATA_CHUNK_CNT ? sTotal - i : GEN_DATA_CHUNK_CNT;
+
+        patternFill(aGen, i, i + sCount, sBuffer);
+
+        if (aConf->mFormat == GEN_DATA_FORMAT_BINARY)
+        {
+            genDataWrite(sBuffer, sizeof(uint32_t) * sCount);
+        }
+        else
+        {
+            for (j = 0; j < sCount; j++)
+            {
+                genDataEmitText(sBuffer[j]);
+            }
+        }
+    }
+
+    genDataFlush();
+
+    free(sBuffer);
 }
 
 /*
@@ -258,13 +370,21 @@ static void genDataPrintUsageAndExit(char *aProgramName)
     uint32_t i = 1;
 
     (void)fprintf(stderr, "Usage : %s [ options ]\n"
-                          "  -c NUM      element count\n"
+                          "  -c NUM      element count, at most 2^40\n"
+                          "  -w NUM      element width in bytes the data is meant for (default 4)\n"
+                          "  -k NUM      offset of the 4 byte key inside an element (default 0)\n"
+                          "  -o FORMAT   binary (default) or text\n"
+                          "  -s NUM, --seed NUM\n"
+                          "              seed of the random based patterns (default : current time)\n"
+                          "  -a NUM      parameter of the pattern, see below\n"
+                          "  -f FILE     write to FILE instead of stdout\n"
+                          "  -t NUM      generating threads (default : online cpus)\n"
+                          "              binary output to a regular file only, otherwise 1\n"
                           "  -p PATETERN\n", aProgramName);
 
-    while (gPatternName[i] != NULL)
+    for (i = 1; i < PATTERN_MAX; i++)
     {
-        (void)fprintf(stderr, "        %s\n", gPatternName[i]);
-        i++;
+        (void)fprintf(stderr, "        %-12s %s\n", patternName(i), patternDesc(i));
     }
 
     exit(1);
@@ -274,9 +394,111 @@ static void genDataPrintUsageAndExit(char *aProgramName)
  * -----------------------------------------------------------------------------
  *  Process command line arguments
  *      -c num : count
+ *      -w num : element width
+ *      -k num : key offset
+ *      -o format : binary, text
+ *      -s num, --seed num : seed
+ *      -a num : pattern parameter
+ *      -f file : output file
+ *      -t num : threads
  *      -p pattern
  * -----------------------------------------------------------------------------
  */
+static int32_t genDataGetNonNegative(int32_t  aArgc,
+                                     char    *aArgv[],
+                                     int32_t  aIndex,
+                                     int32_t  aCurrent)
+{
+    long  sValue;
+    char *sEndPtr = NULL;
+
+    if (aCurrent >= 0)
+    {
+        (void)fprintf(stderr, "error : an option cannot be specified more than once.\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    if (aIndex + 1 >= aArgc)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be "
+                              "provided with a value.\n", aArgv[aIndex]);
+        genDataPrintUsageAndExit(aArgv[0]);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtol(aArgv[aIndex + 1], &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue < 0 || sValue > INT32_MAX)
+    {
+        (void)fprintf(stderr, "error : the value provided with "
+                              "'%s' is out of range.\n", aArgv[aIndex]);
+        exit(1);
+    }
+    else
+    {
+        if (*sEndPtr != '\0')
+        {
+            (void)fprintf(stderr, "error : option '%s' only accepts integer.\n", aArgv[aIndex]);
+            exit(1);
+        }
+    }
+
+    return (int32_t)sValue;
+}
+
+/*
+ * Fills in the default of -a for the pattern, and checks the value given.
+ * Patterns without a parameter record 0.
+ */
+static void genDataResolveParam(char *aProgramName, genDataConf *aConf)
+{
+    uint32_t sDefault;
+    uint32_t sMin;
+
+    if (patternTakesParam(aConf->mPattern, aConf->mCount, &sDefault, &sMin) == 0)
+    {
+        if (aConf->mParam >= 0)
+        {
+            (void)fprintf(stderr, "error : pattern '%s' does not take a parameter.\n",
+                          patternName(aConf->mPattern));
+            genDataPrintUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        aConf->mParam = 0;
+    }
+    else if (aConf->mParam < 0)
+    {
+        aConf->mParam = (int32_t)sDefault;
+    }
+    else if ((uint32_t)aConf->mParam < sMin)
+    {
+        (void)fprintf(stderr, "error : the parameter of '%s' must be at least %u.\n",
+                      patternName(aConf->mPattern), sMin);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    /* the tail cannot be longer than the data */
+    if (aConf->mPattern == PATTERN_SORTED_TAIL && aConf->mParam > aConf->mCount)
+    {
+        aConf->mParam = (int32_t)aConf->mCount;
+    }
+    else
+    {
+    }
+}
+
 static void processArg(int32_t aArgc, char *aArgv[], genDataConf *aConf)
 {
     int32_t i;
@@ -295,17 +517,21 @@ static void processArg(int32_t aArgc, char *aArgv[], genDataConf *aConf)
             {
                 if (i + 1 < aArgc)
                 {
-                    int32_t  sCount;
-                    char    *sEndPtr = NULL;
-                    sCount = strtol(aArgv[i + 1], &sEndPtr, 10);
-                    if (errno == ERANGE)
+                    long long  sCount;
+                    char      *sEndPtr = NULL;
+
+                    errno  = 0;
+                    sCount = strtoll(aArgv[i + 1], &sEndPtr, 10);
+
+                    if (errno == ERANGE || sCount < 0 || sCount > GEN_DATA_MAX_COUNT)
                     {
                         (void)fprintf(stderr, "error : the value provided with "
                                               "'%s' is out of range.\n", aArgv[i]);
+                        exit(1);
                     }
                     else
                     {
-                        if (*sEndPtr != '\0')
+                        if (*sEndPtr != '\0' || sEndPtr == aArgv[i + 1])
                         {
                             (void)fprintf(stderr, "error : option '%s' only accepts integer.\n", aArgv[i]);
                             exit(1);
@@ -328,27 +554,82 @@ static void processArg(int32_t aArgc, char *aArgv[], genDataConf *aConf)
                 exit(1);
             }
         }
+        else if (strcmp(aArgv[i], "-w") == 0)
+        {
+            aConf->mWidth = genDataGetNonNegative(aArgc, aArgv, i, aConf->mWidth);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-k") == 0)
+        {
+            aConf->mKeyOffset = genDataGetNonNegative(aArgc, aArgv, i, aConf->mKeyOffset);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-s") == 0 || strcmp(aArgv[i], "--seed") == 0)
+        {
+            aConf->mSeed = genDataGetNonNegative(aArgc, aArgv, i, aConf->mSeed);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-a") == 0)
+        {
+            aConf->mParam = genDataGetNonNegative(aArgc, aArgv, i, aConf->mParam);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-t") == 0)
+        {
+            aConf->mThreadCnt = genDataGetNonNegative(aArgc, aArgv, i, aConf->mThreadCnt);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-f") == 0)
+        {
+            if (aConf->mFileName != NULL)
+            {
+                (void)fprintf(stderr, "error : an option cannot be specified more than once.\n");
+                exit(1);
+            }
+            else if (i + 1 >= aArgc)
+            {
+                (void)fprintf(stderr, "error : option '%s' needs to be "
+                                      "provided with a value.\n", aArgv[i]);
+                genDataPrintUsageAndExit(aArgv[0]);
+            }
+            else
+            {
+            }
+
+            aConf->mFileName = aArgv[i + 1];
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-o") == 0)
+        {
+            if (aConf->mFormat != GEN_DATA_FORMAT_NONE)
+            {
+                (void)fprintf(stderr, "error : an option cannot be specified more than once.\n");
+                exit(1);
+            }
+            else if (i + 1 < aArgc && strcmp(aArgv[i + 1], "binary") == 0)
+            {
+                aConf->mFormat = GEN_DATA_FORMAT_BINARY;
+            }
+            else if (i + 1 < aArgc && strcmp(aArgv[i + 1], "text") == 0)
+            {
+                aConf->mFormat = GEN_DATA_FORMAT_TEXT;
+            }
+            else
+            {
+                (void)fprintf(stderr, "error : option '%s' accepts binary or text.\n", aArgv[i]);
+                genDataPrintUsageAndExit(aArgv[0]);
+            }
+            i++;
+        }
         else if (strcmp(aArgv[i], "-p") == 0)
         {
-            if (aConf->mPattern == GEN_DATA_PATTERN_NONE)
+            if (aConf->mPattern == PATTERN_NONE)
             {
                 if (i + 1 < aArgc)
                 {
-                    uint32_t j;
-
                     i++;
 
-                    for (j = 1; j < GEN_DATA_PATTERN_MAX; j++)
-                    {
-                        if (strcmp(aArgv[i], gPatternName[j]) == 0)
-                        {
-                            aConf->mPattern = j;
-                            break;
-                        }
-                        else
-                        {
-                        }
-                    }
+                    aConf->mPattern = patternFind(aArgv[i]);
                 }
                 else
                 {
@@ -379,7 +660,7 @@ static void processArg(int32_t aArgc, char *aArgv[], genDataConf *aConf)
     {
     }
 
-    if (aConf->mPattern == GEN_DATA_PATTERN_NONE)
+    if (aConf->mPattern == PATTERN_NONE)
     {
         (void)fprintf(stderr, "error : data pattern must be provided.\n");
         genDataPrintUsageAndExit(aArgv[0]);
@@ -387,55 +668,107 @@ static void processArg(int32_t aArgc, char *aArgv[], genDataConf *aConf)
     else
     {
     }
+
+    if (aConf->mSeed < 0)
+    {
+        aConf->mSeed = (int32_t)(time(NULL) & INT32_MAX);
+    }
+    else
+    {
+    }
+
+    genDataResolveParam(aArgv[0], aConf);
+
+    if (aConf->mFormat == GEN_DATA_FORMAT_NONE)
+    {
+        aConf->mFormat = GEN_DATA_FORMAT_BINARY;
+    }
+    else
+    {
+    }
+
+    if (aConf->mThreadCnt == 0)
+    {
+        (void)fprintf(stderr, "error : at least one thread is needed.\n");
+        exit(1);
+    }
+    else if (aConf->mThreadCnt < 0)
+    {
+        long sCpuCnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+        aConf->mThreadCnt = sCpuCnt > 0 ? (int32_t)sCpuCnt : 1;
+    }
+    else
+    {
+    }
+
+    if (aConf->mWidth >= 0 || aConf->mKeyOffset >= 0)
+    {
+        if (aConf->mWidth < 0)     aConf->mWidth     = sizeof(uint32_t);
+        if (aConf->mKeyOffset < 0) aConf->mKeyOffset = 0;
+
+        if (aConf->mKeyOffset + sizeof(uint32_t) > (uint32_t)aConf->mWidth)
+        {
+            (void)fprintf(stderr, "error : key at offset %d does not fit in width %d.\n",
+                          aConf->mKeyOffset, aConf->mWidth);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+    }
 }
 
 int32_t main(int32_t aArgc, char *aArgv[])
 {
     genDataConf sConf;
+    patternGen  sGen;
+    off_t       sStart;
 
     genDataConfInit(&sConf);
     processArg(aArgc, aArgv, &sConf);
 
-    /*
-     * Printing count
-     */
-    (void)fprintf(stdout, "#%d\n", sConf.mCount);
-
-    /*
-     * Printing data
-     */
-    switch (sConf.mPattern)
+    if (sConf.mFileName != NULL && freopen(sConf.mFileName, "w", stdout) == NULL)
     {
-        case GEN_DATA_PATTERN_RANDOM:
-            genDataGenerateRandom(sConf.mCount);
-            break;
-
-        case GEN_DATA_PATTERN_SORTED:
-            genDataGenerateSorted(sConf.mCount, GEN_DATA_ORDER_ASCENDING);
-            break;
-
-        case GEN_DATA_PATTERN_SORTED_REVERSE:
-            genDataGenerateSorted(sConf.mCount, GEN_DATA_ORDER_DESCENDING);
-            break;
-
-        case GEN_DATA_PATTERN_SINWAVE1:
-            genDataGenerateSinWave1(sConf.mCount, 10);
-            break;
+        (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n",
+                      sConf.mFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
 
-        case GEN_DATA_PATTERN_CHAINSAW:
-            genDataGenerateChainsaw(sConf.mCount, 10);
-            break;
+    if (sConf.mFormat == GEN_DATA_FORMAT_BINARY && isatty(STDOUT_FILENO) == 1)
+    {
+        (void)fprintf(stderr, "error : not writing binary data to a terminal. Redirect it or use '-o text'.\n");
+        exit(1);
+    }
+    else
+    {
+    }
 
-        case GEN_DATA_PATTERN_IDENTICAL:
-            genDataGenerateIdentical(sConf.mCount);
-            break;
+    if (patternInit(&sGen, sConf.mPattern, sConf.mCount, sConf.mParam, sConf.mSeed) != 0)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
 
-        case GEN_DATA_PATTERN_NONE:
-        case GEN_DATA_PATTERN_MAX:
-            abort();
-            break;
+    if (sConf.mFormat == GEN_DATA_FORMAT_BINARY && genDataCanPwrite(fileno(stdout), &sStart) == 1)
+    {
+        genDataGenerateParallel(&sConf, &sGen, fileno(stdout), sStart);
+    }
+    else
+    {
+        genDataGenerateSerial(&sConf, &sGen);
     }
 
+    patternDestroy(&sGen);
+
     return 0;
 }
-
@@ -0,0 +1,756 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+
+#include "timkernel.h"
+
+/*
+ * Microbenchmarks of the building blocks of timsort() and timsort1()
+ * on inputs made to measure one thing at a time :
+ *
+ *      gallop    : timGallopLeft() and timGallopRight(), the key d elements away from the hint
+ *      binsort   : timDoBinarySort() of runs of k elements, the first one taken as sorted
+ *      countrun  : timCountRunAndMakeAscending() on ascending and descending runs of k elements
+ *      merge     : timMergeLow() and timMergeHigh() of two runs interleaved by blocks of r elements
+ *
+ * The same inputs go to the kernels of the index and the pointer addressing
+ * policies of timsort.c. Each figure is the median of the repetitions, in ns per call
+ * for gallop and ns per element otherwise.
+ */
+
+#define KB_MAX_WIDTH_CNT        16
+#define KB_DEFAULT_REPEAT_CNT   11
+#define KB_BATCH_ELEM_CNT       65536       /* elements of a binsort, countrun or merge batch */
+#define KB_GALLOP_LEN           8192        /* run galloped into */
+#define KB_GALLOP_CALL_CNT      65536       /* calls of a gallop batch */
+#define KB_GALLOP_KEY_CNT       1024        /* different keys and hints of a gallop batch */
+#define KB_KEY_SIZE             sizeof(uint32_t)
+
+typedef enum
+{
+    KB_KERNEL_GALLOP   = 0x01,
+    KB_KERNEL_BINSORT  = 0x02,
+    KB_KERNEL_COUNTRUN = 0x04,
+    KB_KERNEL_MERGE    = 0x08,
+    KB_KERNEL_ALL      = 0x0f
+} kbKernel;
+
+static const struct
+{
+    const char *mName;
+    kbKernel    mKernel;
+} gKernelName[] =
+{
+    { "gallop",   KB_KERNEL_GALLOP   },
+    { "binsort",  KB_KERNEL_BINSORT  },
+    { "countrun", KB_KERNEL_COUNTRUN },
+    { "merge",    KB_KERNEL_MERGE    },
+    { "all",      KB_KERNEL_ALL      },
+    { NULL,       0                  }
+};
+
+static const timKernelSet *gKernelSet[] =
+{
+    &gTimKernelIndex,
+    &gTimKernelPointer,
+    NULL
+};
+
+static const int32_t  gGallopDistance[] = { 0, 1, 4, 16, 64, 256, 1024, -1, -16, -256, -1024 };
+static const uint32_t gBinSortLen[]     = { 4, 8, 16, 32, 48, 64 };
+static const uint32_t gCountRunLen[]    = { 4, 16, 64, 1024, KB_BATCH_ELEM_CNT };
+static const uint32_t gMergeBlockLen[]  = { 1, 2, 4, 16, 64, 256, 4096, KB_BATCH_ELEM_CNT / 2 };
+
+#define KB_ARRAY_CNT(_aArray)   (sizeof(_aArray) / sizeof((_aArray)[0]))
+
+typedef struct kbConf
+{
+    uint32_t  mKernel;
+    uint32_t  mRepeatCnt;
+    uint32_t  mWidthCnt;
+    size_t    mWidth[KB_MAX_WIDTH_CNT];
+} kbConf;
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Elements
+ * -----------------------------------------------------------------------------
+ */
+static int kbCompare(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1;
+    uint32_t sKey2;
+
+    /* odd widths leave the key unaligned */
+    memcpy(&sKey1, aElem1, sizeof(sKey1));
+    memcpy(&sKey2, aElem2, sizeof(sKey2));
+
+    return (sKey1 > sKey2) - (sKey1 < sKey2);
+}
+
+static uint32_t kbGetKey(const uint8_t *aArray, size_t aWidth, size_t aIndex)
+{
+    uint32_t sKey;
+
+    memcpy(&sKey, aArray + aIndex * aWidth, sizeof(sKey));
+
+    return sKey;
+}
+
+/*
+ * The key, then bytes of the index so that the rest of an element is not all zero
+ */
+static void kbSetElem(uint8_t *aArray, size_t aWidth, size_t aIndex, uint32_t aKey)
+{
+    uint8_t *sElem = aArray + aIndex * aWidth;
+    size_t   i;
+
+    memcpy(sElem, &aKey, sizeof(aKey));
+
+    for (i = KB_KEY_SIZE; i < aWidth; i++)
+    {
+        sElem[i] = (uint8_t)(aIndex + i);
+    }
+}
+
+static uint32_t kbRandom(uint64_t *aSeed)
+{
+    /* splitmix64 */
+    uint64_t sValue = (*aSeed += 0x9e3779b97f4a7c15ULL);
+
+    sValue = (sValue ^ (sValue >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    sValue = (sValue ^ (sValue >> 27)) * 0x94d049bb133111ebULL;
+
+    return (uint32_t)(sValue ^ (sValue >> 31));
+}
+
+static void *kbAlloc(size_t aSize)
+{
+    void *sMem = malloc(aSize);
+
+    if (sMem == NULL)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return sMem;
+}
+
+static void kbFail(const timKernelSet *aSet, const char *aWhat, size_t aWidth)
+{
+    (void)fprintf(stderr, "error : %s %s gave a wrong result with width %zu.\n", aSet->mName, aWhat, aWidth);
+    exit(1);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Timing
+ * -----------------------------------------------------------------------------
+ */
+static double kbNowNsec(void)
+{
+    struct timespec sNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+static int kbCompareDouble(const void *aElem1, const void *aElem2)
+{
+    double sValue1 = *(const double *)aElem1;
+    double sValue2 = *(const double *)aElem2;
+
+    return (sValue1 > sValue2) - (sValue1 < sValue2);
+}
+
+static double kbMedian(double *aSample, uint32_t aCount)
+{
+    qsort(aSample, aCount, sizeof(double), kbCompareDouble);
+
+    return aSample[aCount / 2];
+}
+
+static void kbPrintHeader(const char *aKernel)
+{
+    uint32_t i;
+
+    (void)printf("\n%-12s %6s %-12s", aKernel, "width", "input");
+
+    for (i = 0; gKernelSet[i] != NULL; i++)
+    {
+        (void)printf(" %10s", gKernelSet[i]->mName);
+    }
+
+    (void)printf(" %10s\n", "ptr/index");
+}
+
+static void kbPrintRow(const char *aKernel, size_t aWidth, const char *aInput, const double *aNsec)
+{
+    uint32_t i;
+
+    (void)printf("%-12s %6zu %-12s", aKernel, aWidth, aInput);
+
+    for (i = 0; gKernelSet[i] != NULL; i++)
+    {
+        (void)printf(" %10.2f", aNsec[i]);
+    }
+
+    (void)printf(" %10.3f\n", aNsec[0] > 0 ? aNsec[1] / aNsec[0] : 0.0);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Gallop
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * A run of keys 0, 2, 4, ... and keys equal to the element d away from
+ * the hint, so that timGallopLeft() returns hint + d and timGallopRight() hint + d + 1.
+ * The hints move around the middle of the run, not to train the branch predictor on one.
+ */
+static double kbGallopOne(const kbConf        *aConf,
+                          const timKernelSet  *aSet,
+                          size_t               aWidth,
+                          int32_t              aDistance,
+                          int32_t              aRight,
+                          const uint8_t       *aRun,
+                          const uint8_t       *aKey,
+                          const int32_t       *aHint,
+                          double              *aSample)
+{
+    int32_t (*sGallop)(const void *, const void *, size_t, int32_t, int32_t, timKernelCmp *);
+
+    volatile int32_t sSink = 0;
+    double           sStart;
+    int32_t          sResult;
+    uint32_t         i;
+    uint32_t         j;
+
+    sGallop = aRight == 1 ? aSet->mGallopRight : aSet->mGallopLeft;
+
+    for (j = 0; j < KB_GALLOP_KEY_CNT; j++)
+    {
+        sResult = (*sGallop)(aKey + j * aWidth, aRun, aWidth, KB_GALLOP_LEN, aHint[j], kbCompare);
+
+        if (sResult != aHint[j] + aDistance + aRight)
+        {
+            kbFail(aSet, aRight == 1 ? "gallopRight" : "gallopLeft", aWidth);
+        }
+        else
+        {
+        }
+    }
+
+    for (i = 0; i < aConf->mRepeatCnt; i++)
+    {
+        sStart = kbNowNsec();
+
+        for (j = 0; j < KB_GALLOP_CALL_CNT; j++)
+        {
+            sSink += (*sGallop)(aKey + (j % KB_GALLOP_KEY_CNT) * aWidth,
+                                aRun,
+                                aWidth,
+                                KB_GALLOP_LEN,
+                                aHint[j % KB_GALLOP_KEY_CNT],
+                                kbCompare);
+        }
+
+        aSample[i] = (kbNowNsec() - sStart) / KB_GALLOP_CALL_CNT;
+    }
+
+    (void)sSink;
+
+    return kbMedian(aSample, aConf->mRepeatCnt);
+}
+
+static void kbGallop(const kbConf *aConf, size_t aWidth, double *aSample)
+{
+    uint8_t  *sRun  = kbAlloc(KB_GALLOP_LEN * aWidth);
+    uint8_t  *sKey  = kbAlloc(KB_GALLOP_KEY_CNT * aWidth);
+    int32_t   sHint[KB_GALLOP_KEY_CNT];
+    double    sNsec[2];
+    char      sInput[32];
+    uint64_t  sSeed = 1;
+    int32_t   sRight;
+    uint32_t  d;
+    uint32_t  i;
+    uint32_t  j;
+
+    for (j = 0; j < KB_GALLOP_LEN; j++)
+    {
+        kbSetElem(sRun, aWidth, j, 2 * j);
+    }
+
+    for (sRight = 0; sRight <= 1; sRight++)
+    {
+        kbPrintHeader(sRight == 1 ? "gallopRight" : "gallopLeft");
+
+        for (d = 0; d < KB_ARRAY_CNT(gGallopDistance); d++)
+        {
+            for (j = 0; j < KB_GALLOP_KEY_CNT; j++)
+            {
+                sHint[j] = KB_GALLOP_LEN / 4 + kbRandom(&sSeed) % (KB_GALLOP_LEN / 2);
+                kbSetElem(sKey, aWidth, j, 2 * (sHint[j] + gGallopDistance[d]));
+            }
+
+            for (i = 0; gKernelSet[i] != NULL; i++)
+            {
+                sNsec[i] = kbGallopOne(aConf, gKernelSet[i], aWidth, gGallopDistance[d],
+                                       sRight, sRun, sKey, sHint, aSample);
+            }
+
+            (void)snprintf(sInput, sizeof(sInput), "d=%d", gGallopDistance[d]);
+            kbPrintRow(sRight == 1 ? "gallopRight" : "gallopLeft", aWidth, sInput, sNsec);
+        }
+    }
+
+    free(sRun);
+    free(sKey);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Binary Sort And Count Run
+ * -----------------------------------------------------------------------------
+ */
+typedef enum
+{
+    KB_BATCH_BINSORT,
+    KB_BATCH_COUNTRUN
+} kbBatch;
+
+/*
+ * aSource holds KB_BATCH_ELEM_CNT / aRunLen runs, copied to aWork before each
+ * repetition. Returns ns per element.
+ */
+static double kbBatchOne(const kbConf       *aConf,
+                         const timKernelSet *aSet,
+                         kbBatch             aBatch,
+                         size_t              aWidth,
+                         uint32_t            aRunLen,
+                         const uint8_t      *aSource,
+                         uint8_t            *aWork,
+                         double             *aSample)
+{
+    void     *sState = (*aSet->mCreate)(aWidth);
+    uint32_t  sRunCnt = KB_BATCH_ELEM_CNT / aRunLen;
+    double    sStart;
+    uint32_t  i;
+    uint32_t  j;
+
+    if (sState == NULL)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < aConf->mRepeatCnt; i++)
+    {
+        memcpy(aWork, aSource, (size_t)sRunCnt * aRunLen * aWidth);
+
+        sStart = kbNowNsec();
+
+        if (aBatch == KB_BATCH_BINSORT)
+        {
+            for (j = 0; j < sRunCnt; j++)
+            {
+                (*aSet->mBinarySort)(sState, aWork + (size_t)j * aRunLen * aWidth, aRunLen, 1, kbCompare);
+            }
+        }
+        else
+        {
+            for (j = 0; j < sRunCnt; j++)
+            {
+                if ((*aSet->mCountRun)(sState, aWork + (size_t)j * aRunLen * aWidth, aRunLen, kbCompare) != aRunLen)
+                {
+                    kbFail(aSet, "countRun", aWidth);
+                }
+                else
+                {
+                }
+            }
+        }
+
+        aSample[i] = (kbNowNsec() - sStart) / ((double)sRunCnt * aRunLen);
+    }
+
+    /* every run ends up ascending either way */
+    for (j = 1; j < sRunCnt * aRunLen; j++)
+    {
+        if (j % aRunLen != 0 && kbGetKey(aWork, aWidth, j - 1) > kbGetKey(aWork, aWidth, j))
+        {
+            kbFail(aSet, aBatch == KB_BATCH_BINSORT ? "binarySort" : "countRun", aWidth);
+        }
+        else
+        {
+        }
+    }
+
+    (*aSet->mDestroy)(sState);
+
+    return kbMedian(aSample, aConf->mRepeatCnt);
+}
+
+static void kbBinarySort(const kbConf *aConf, size_t aWidth, double *aSample)
+{
+    uint8_t  *sSource = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    uint8_t  *sWork   = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    double    sNsec[2];
+    char      sInput[32];
+    uint64_t  sSeed = 1;
+    uint32_t  k;
+    uint32_t  i;
+    uint32_t  j;
+
+    for (j = 0; j < KB_BATCH_ELEM_CNT; j++)
+    {
+        kbSetElem(sSource, aWidth, j, kbRandom(&sSeed));
+    }
+
+    kbPrintHeader("binarySort");
+
+    for (k = 0; k < KB_ARRAY_CNT(gBinSortLen); k++)
+    {
+        for (i = 0; gKernelSet[i] != NULL; i++)
+        {
+            sNsec[i] = kbBatchOne(aConf, gKernelSet[i], KB_BATCH_BINSORT, aWidth, gBinSortLen[k],
+                                  sSource, sWork, aSample);
+        }
+
+        (void)snprintf(sInput, sizeof(sInput), "k=%u", gBinSortLen[k]);
+        kbPrintRow("binarySort", aWidth, sInput, sNsec);
+    }
+
+    free(sSource);
+    free(sWork);
+}
+
+static void kbCountRun(const kbConf *aConf, size_t aWidth, double *aSample)
+{
+    uint8_t  *sSource = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    uint8_t  *sWork   = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    double    sNsec[2];
+    char      sInput[32];
+    int32_t   sDescending;
+    uint32_t  k;
+    uint32_t  i;
+    uint32_t  j;
+
+    kbPrintHeader("countRun");
+
+    for (sDescending = 0; sDescending <= 1; sDescending++)
+    {
+        for (k = 0; k < KB_ARRAY_CNT(gCountRunLen); k++)
+        {
+            /* strictly descending, or timCountRunAndMakeAscending() stops at the first tie */
+            for (j = 0; j < KB_BATCH_ELEM_CNT; j++)
+            {
+                kbSetElem(sSource, aWidth, j,
+                          sDescending == 1 ? gCountRunLen[k] - j % gCountRunLen[k] : j % gCountRunLen[k]);
+            }
+
+            for (i = 0; gKernelSet[i] != NULL; i++)
+            {
+                sNsec[i] = kbBatchOne(aConf, gKernelSet[i], KB_BATCH_COUNTRUN, aWidth, gCountRunLen[k],
+                                      sSource, sWork, aSample);
+            }
+
+            (void)snprintf(sInput, sizeof(sInput), "%s k=%u", sDescending == 1 ? "desc" : "asc", gCountRunLen[k]);
+            kbPrintRow("countRun", aWidth, sInput, sNsec);
+        }
+    }
+
+    free(sSource);
+    free(sWork);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Merge
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Two runs of KB_BATCH_ELEM_CNT / 2 elements each whose merge takes r from the
+ * second, r from the first, and so on. Starting with the second run and ending with
+ * the first one is what timMergeLow() and timMergeHigh() need. r = 1 is the worst
+ * case of galloping, r = KB_BATCH_ELEM_CNT / 2 a merge done by a single gallop.
+ */
+static double kbMergeOne(const kbConf       *aConf,
+                         const timKernelSet *aSet,
+                         size_t              aWidth,
+                         int32_t             aHigh,
+                         const uint8_t      *aSource,
+                         uint8_t            *aWork,
+                         double             *aSample)
+{
+    void     *sState = (*aSet->mCreate)(aWidth);
+    size_t    sLen   = KB_BATCH_ELEM_CNT / 2;
+    double    sStart;
+    uint32_t  i;
+    uint32_t  j;
+
+    if (sState == NULL)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < aConf->mRepeatCnt; i++)
+    {
+        memcpy(aWork, aSource, KB_BATCH_ELEM_CNT * aWidth);
+
+        sStart = kbNowNsec();
+
+        if (aHigh == 1)
+        {
+            (*aSet->mMergeHigh)(sState, aWork, sLen, sLen, kbCompare);
+        }
+        else
+        {
+            (*aSet->mMergeLow)(sState, aWork, sLen, sLen, kbCompare);
+        }
+
+        aSample[i] = (kbNowNsec() - sStart) / KB_BATCH_ELEM_CNT;
+    }
+
+    for (j = 0; j < KB_BATCH_ELEM_CNT; j++)
+    {
+        if (kbGetKey(aWork, aWidth, j) != j)
+        {
+            kbFail(aSet, aHigh == 1 ? "mergeHigh" : "mergeLow", aWidth);
+        }
+        else
+        {
+        }
+    }
+
+    (*aSet->mDestroy)(sState);
+
+    return kbMedian(aSample, aConf->mRepeatCnt);
+}
+
+static void kbMerge(const kbConf *aConf, size_t aWidth, double *aSample)
+{
+    uint8_t  *sSource = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    uint8_t  *sWork   = kbAlloc(KB_BATCH_ELEM_CNT * aWidth);
+    double    sNsec[2];
+    char      sInput[32];
+    uint32_t  sBlock;
+    uint32_t  sCursor1;
+    uint32_t  sCursor2;
+    int32_t   sHigh;
+    uint32_t  r;
+    uint32_t  i;
+    uint32_t  j;
+
+    for (sHigh = 0; sHigh <= 1; sHigh++)
+    {
+        kbPrintHeader(sHigh == 1 ? "mergeHigh" : "mergeLow");
+
+        for (r = 0; r < KB_ARRAY_CNT(gMergeBlockLen); r++)
+        {
+            sCursor1 = 0;
+            sCursor2 = KB_BATCH_ELEM_CNT / 2;
+
+            /* the key is the position in the merged array */
+            for (j = 0; j < KB_BATCH_ELEM_CNT; j++)
+            {
+                sBlock = j / gMergeBlockLen[r];
+
+                if (sBlock % 2 == 0)
+                {
+                    kbSetElem(sSource, aWidth, sCursor2++, j);
+                }
+                else
+                {
+                    kbSetElem(sSource, aWidth, sCursor1++, j);
+                }
+            }
+
+            for (i = 0; gKernelSet[i] != NULL; i++)
+            {
+                sNsec[i] = kbMergeOne(aConf, gKernelSet[i], aWidth, sHigh, sSource, sWork, aSample);
+            }
+
+            (void)snprintf(sInput, sizeof(sInput), "r=%u", gMergeBlockLen[r]);
+            kbPrintRow(sHigh == 1 ? "mergeHigh" : "mergeLow", aWidth, sInput, sNsec);
+        }
+    }
+
+    free(sSource);
+    free(sWork);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Arguments
+ * -----------------------------------------------------------------------------
+ */
+static void printUsageAndExit(char *aProgramName)
+{
+    (void)fprintf(stderr, "Usage : %s [ options ]\n"
+                          "  -k LIST     comma separated kernels : gallop, binsort, countrun, merge, all (default all)\n"
+                          "  -W LIST     comma separated element widths in bytes, at least %zu (default 4,16,64)\n"
+                          "  -r NUM      measured repetitions, the median is reported (default %d)\n",
+                          aProgramName, KB_KEY_SIZE, KB_DEFAULT_REPEAT_CNT);
+    exit(1);
+}
+
+static int32_t processArgGetInteger(char *aProgramName, char *aOption, char *aValue, int32_t aMin)
+{
+    long  sValue;
+    char *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtol(aValue, &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue > INT32_MAX || sValue < aMin || *sEndPtr != '\0' || sEndPtr == aValue)
+    {
+        (void)fprintf(stderr, "error : option '%s' accepts an integer of at least %d.\n", aOption, aMin);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return (int32_t)sValue;
+}
+
+static void processArgDetermineKernels(char *aProgramName, char *aList, kbConf *aConf)
+{
+    char     *sName;
+    char     *sSavePtr = NULL;
+    uint32_t  i;
+
+    aConf->mKernel = 0;
+
+    for (sName = strtok_r(aList, ",", &sSavePtr); sName != NULL; sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        for (i = 0; gKernelName[i].mName != NULL; i++)
+        {
+            if (strcmp(sName, gKernelName[i].mName) == 0) break;
+        }
+
+        if (gKernelName[i].mName == NULL)
+        {
+            (void)fprintf(stderr, "error : unknown kernel '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        aConf->mKernel |= gKernelName[i].mKernel;
+    }
+}
+
+static void processArgDetermineWidths(char *aProgramName, char *aList, kbConf *aConf)
+{
+    char *sValue;
+    char *sSavePtr = NULL;
+
+    aConf->mWidthCnt = 0;
+
+    for (sValue = strtok_r(aList, ",", &sSavePtr); sValue != NULL; sValue = strtok_r(NULL, ",", &sSavePtr))
+    {
+        if (aConf->mWidthCnt >= KB_MAX_WIDTH_CNT)
+        {
+            (void)fprintf(stderr, "error : too many widths.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aConf->mWidth[aConf->mWidthCnt++] = processArgGetInteger(aProgramName, "-W", sValue, KB_KEY_SIZE);
+    }
+}
+
+static void processArg(int32_t aArgc, char *aArgv[], kbConf *aConf)
+{
+    int32_t i;
+
+    aConf->mKernel    = KB_KERNEL_ALL;
+    aConf->mRepeatCnt = KB_DEFAULT_REPEAT_CNT;
+    aConf->mWidthCnt  = 3;
+    aConf->mWidth[0]  = 4;
+    aConf->mWidth[1]  = 16;
+    aConf->mWidth[2]  = 64;
+
+    for (i = 1; i < aArgc; i++)
+    {
+        char *sValue = (i + 1 < aArgc) ? aArgv[i + 1] : NULL;
+
+        if (strcmp(aArgv[i], "-k") == 0 && sValue != NULL)
+        {
+            processArgDetermineKernels(aArgv[0], sValue, aConf);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-W") == 0 && sValue != NULL)
+        {
+            processArgDetermineWidths(aArgv[0], sValue, aConf);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-r") == 0)
+        {
+            aConf->mRepeatCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+    }
+}
+
+int32_t main(int32_t aArgc, char *aArgv[])
+{
+    kbConf    sConf;
+    double   *sSample;
+    uint32_t  i;
+
+    processArg(aArgc, aArgv, &sConf);
+
+    sSample = kbAlloc(sizeof(double) * sConf.mRepeatCnt);
+
+    (void)printf("ns per call (gallop) or per element (others), median of %u\n", sConf.mRepeatCnt);
+
+    for (i = 0; i < sConf.mWidthCnt; i++)
+    {
+        if ((sConf.mKernel & KB_KERNEL_GALLOP) != 0)   kbGallop(&sConf, sConf.mWidth[i], sSample);
+        if ((sConf.mKernel & KB_KERNEL_BINSORT) != 0)  kbBinarySort(&sConf, sConf.mWidth[i], sSample);
+        if ((sConf.mKernel & KB_KERNEL_COUNTRUN) != 0) kbCountRun(&sConf, sConf.mWidth[i], sSample);
+        if ((sConf.mKernel & KB_KERNEL_MERGE) != 0)    kbMerge(&sConf, sConf.mWidth[i], sSample);
+    }
+
+    free(sSample);
+
+    return 0;
+}
@@ -0,0 +1,953 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "pattern.h"
+
+static const char *gPatternName[] =
+{
+    "None",
+    "random",
+    "sorted",
+    "reversed",
+    "sinwave1",
+    "chainsaw",
+    "identical",
+    "sinwave2",
+    "almost",
+    "sortedtail",
+    "pipeorgan",
+    "sawtooth",
+    "fewunique",
+    "bounded",
+    "zipf",
+    "interleaved",
+    "adversarial",
+    NULL
+};
+
+/*
+ * Shown in the usage of gendata, in the order of gPatternName.
+ * -a sets the parameter of the patterns that take one.
+ */
+static const char *gPatternDesc[] =
+{
+    NULL,
+    "uniformly random",
+    "ascending",
+    "descending",
+    "sine wave of growing amplitude",
+    "sine wave",
+    "a single value",
+    "sum of two sine waves",
+    "ascending with -a random swaps (default N / 100)",
+    "ascending followed by -a random values (default N / 10)",
+    "ascending first half, descending second half",
+    "ascending runs of random length 1 .. -a (default 1000)",
+    "-a distinct values (default 16)",
+    "every element at most -a positions from its sorted place (default 8)",
+    "Zipf (s = 1) distributed duplicates of -a distinct values (default 1000)",
+    "-a ascending streams interleaved element by element (default 4)",
+    "run lengths that stress timMergeCollapse, -a is minrun (default : that of timsort)",
+    NULL
+};
+
+#define PATTERN_SINE_CYCLE_CNT  10
+
+const char *patternName(patternId aPattern)
+{
+    return gPatternName[aPattern];
+}
+
+const char *patternDesc(patternId aPattern)
+{
+    return gPatternDesc[aPattern];
+}
+
+/*
+ * Returns PATTERN_NONE if there is no pattern called aName
+ */
+patternId patternFind(const char *aName)
+{
+    uint32_t i;
+
+    for (i = 1; i < PATTERN_MAX; i++)
+    {
+        if (strcmp(aName, gPatternName[i]) == 0)
+        {
+            return (patternId)i;
+        }
+        else
+        {
+        }
+    }
+
+    return PATTERN_NONE;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Counter Based Random Numbers
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * splitmix64 finalizer : every input bit affects every output bit
+ */
+static uint64_t patternMix(uint64_t aValue)
+{
+    aValue ^= aValue >> 30;
+    aValue *= 0xbf58476d1ce4e5b9ULL;
+    aValue ^= aValue >> 27;
+    aValue *= 0x94d049bb133111ebULL;
+    aValue ^= aValue >> 31;
+
+    return aValue;
+}
+
+/*
+ * The aCounter-th number of the stream keyed by aKey
+ */
+static uint64_t patternRandom(uint64_t aKey, uint64_t aCounter)
+{
+    return patternMix(aKey + (aCounter + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+/*
+ * Uniform in [0, aBound)
+ */
+static uint32_t patternRandomBelow(uint64_t aRandom, uint32_t aBound)
+{
+    return (uint32_t)(((aRandom >> 32) * aBound) >> 32);
+}
+
+/*
+ * Uniform position in [0, aBound). The same as patternRandomBelow() below 2^32.
+ */
+static uint64_t patternPosBelow(uint64_t aRandom, uint64_t aBound)
+{
+    if (aBound <= UINT32_MAX) return patternRandomBelow(aRandom, (uint32_t)aBound);
+
+    return (uint64_t)(((unsigned __int128)aRandom * aBound) >> 64);
+}
+
+/*
+ * Element aIndex of aCount ascending random values, without sorting anything :
+ * the 32 bit range is cut into aCount consecutive buckets, and element i is
+ * a random value in bucket i. Beyond 2^32 elements the buckets are empty and
+ * the values repeat.
+ */
+static uint32_t patternSortedValue(uint64_t aKey, uint64_t aCount, uint64_t aIndex)
+{
+    uint64_t sLow  = (uint64_t)(((unsigned __int128)aIndex << 32) / aCount);
+    uint64_t sHigh = (uint64_t)(((unsigned __int128)(aIndex + 1) << 32) / aCount);
+
+    if (sHigh > sLow)
+    {
+        sLow += patternRandom(aKey, aIndex) % (sHigh - sLow);
+    }
+    else
+    {
+    }
+
+    return (uint32_t)sLow;
+}
+
+/*
+ * First index in the ascending aArray[0 .. aCount) not less than aValue
+ */
+static uint64_t patternLowerBound(const uint64_t *aArray, uint64_t aCount, uint64_t aValue)
+{
+    uint64_t sLow  = 0;
+    uint64_t sHigh = aCount;
+    uint64_t sMiddle;
+
+    while (sLow < sHigh)
+    {
+        sMiddle = sLow + (sHigh - sLow) / 2;
+
+        if (aArray[sMiddle] < aValue)
+        {
+            sLow = sMiddle + 1;
+        }
+        else
+        {
+            sHigh = sMiddle;
+        }
+    }
+
+    return sLow;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Parameters
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Same as timCalcMinRunLen() with MIN_MERGE 64
+ */
+static uint32_t patternTimMinRunLen(uint64_t aSize)
+{
+    uint32_t sBumper = 0;
+
+    while (aSize >= 64)
+    {
+        sBumper |= (aSize & 1);
+        aSize >>= 1;
+    }
+
+    return (uint32_t)aSize + sBumper;
+}
+
+/*
+ * Returns 1 and the default and least value of the parameter if aPattern takes one, 0 otherwise.
+ * Defaults that grow with aCount stop at PATTERN_MAX_PARAM.
+ */
+int32_t patternTakesParam(patternId aPattern, uint64_t aCount, uint32_t *aDefault, uint32_t *aMin)
+{
+    *aDefault = 0;
+    *aMin     = 0;
+
+    switch (aPattern)
+    {
+        case PATTERN_ALMOST:
+            *aDefault = aCount / 100 < PATTERN_MAX_PARAM ? (uint32_t)(aCount / 100) : PATTERN_MAX_PARAM;
+            break;
+
+        case PATTERN_SORTED_TAIL:
+            *aDefault = aCount / 10 < PATTERN_MAX_PARAM ? (uint32_t)(aCount / 10) : PATTERN_MAX_PARAM;
+            break;
+
+        case PATTERN_SAWTOOTH:
+            *aDefault = 1000;
+            *aMin     = 1;
+            break;
+
+        case PATTERN_FEW_UNIQUE:
+            *aDefault = 16;
+            *aMin     = 1;
+            break;
+
+        case PATTERN_BOUNDED:
+            *aDefault = 8;
+            break;
+
+        case PATTERN_ZIPF:
+            *aDefault = 1000;
+            *aMin     = 1;
+            break;
+
+        case PATTERN_INTERLEAVED:
+            *aDefault = 4;
+            *aMin     = 1;
+            break;
+
+        case PATTERN_ADVERSARIAL:
+            *aDefault = patternTimMinRunLen(aCount);
+            *aMin     = 1;
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (*aDefault < *aMin) *aDefault = *aMin;
+
+    return 1;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Precomputed Structure
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * fewunique, zipf : the distinct values, and for zipf the cumulative weight 1 / rank
+ */
+static int32_t patternInitTable(patternGen *aGen)
+{
+    double   sSum = 0;
+    uint32_t i;
+
+    aGen->mTableCnt = aGen->mParam;
+    aGen->mTable    = malloc(sizeof(uint32_t) * aGen->mTableCnt);
+
+    if (aGen->mTable == NULL) return -1;
+
+    if (aGen->mPattern == PATTERN_ZIPF)
+    {
+        aGen->mCdf = malloc(sizeof(double) * aGen->mTableCnt);
+
+        if (aGen->mCdf == NULL) return -1;
+    }
+    else
+    {
+    }
+
+    /*
+     * The values are random, so that the frequency of a value says nothing about its order
+     */
+    for (i = 0; i < aGen->mTableCnt; i++)
+    {
+        aGen->mTable[i] = (uint32_t)patternRandom(aGen->mKey[PATTERN_STREAM_TABLE], i);
+
+        if (aGen->mCdf != NULL)
+        {
+            sSum          += 1.0 / (i + 1);
+            aGen->mCdf[i]  = sSum;
+        }
+        else
+        {
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * sawtooth : where each run starts. A run has a random length 1 .. mParam.
+ */
+static int32_t patternInitRuns(patternGen *aGen)
+{
+    uint64_t sStart = 0;
+    uint64_t sCapacity;
+
+    /* runs are mParam / 2 long on average, allow for some more */
+    sCapacity       = aGen->mCount / ((aGen->mParam + 1) / 2) + 64;
+    aGen->mRunStart = malloc(sizeof(uint64_t) * sCapacity);
+
+    if (aGen->mRunStart == NULL) return -1;
+
+    aGen->mRunCnt = 0;
+
+    while (sStart < aGen->mCount)
+    {
+        if (aGen->mRunCnt == sCapacity)
+        {
+            uint64_t *sRunStart;
+
+            sCapacity *= 2;
+            sRunStart  = realloc(aGen->mRunStart, sizeof(uint64_t) * sCapacity);
+
+            if (sRunStart == NULL) return -1;
+
+            aGen->mRunStart = sRunStart;
+        }
+        else
+        {
+        }
+
+        aGen->mRunStart[aGen->mRunCnt] = sStart;
+
+        sStart += patternRandomBelow(patternRandom(aGen->mKey[PATTERN_STREAM_RUN], aGen->mRunCnt),
+                                     aGen->mParam) + 1;
+
+        aGen->mRunCnt++;
+    }
+
+    return 0;
+}
+
+static int patternComparePos(const void *aElem1, const void *aElem2)
+{
+    uint64_t sValue1 = *(const uint64_t *)aElem1;
+    uint64_t sValue2 = *(const uint64_t *)aElem2;
+
+    return (sValue1 > sValue2) - (sValue1 < sValue2);
+}
+
+/*
+ * almost : mParam random swaps applied, one after another, to sorted data.
+ * Only the positions touched by a swap differ from sorted data,
+ * so they are worked out here and patched over the sorted values in patternFill().
+ */
+static int32_t patternInitSwaps(patternGen *aGen)
+{
+    uint64_t *sOrigin;
+    uint64_t  sPosCnt;
+    uint64_t  sPos1;
+    uint64_t  sPos2;
+    uint64_t  sTemp;
+    uint64_t  i;
+    uint64_t  j;
+
+    if (aGen->mCount < 2 || aGen->mParam == 0) return 0;
+
+    sPosCnt = (uint64_t)aGen->mParam * 2;
+
+    aGen->mPatchPos   = malloc(sizeof(uint64_t) * sPosCnt);
+    aGen->mPatchValue = malloc(sizeof(uint32_t) * sPosCnt);
+    sOrigin           = malloc(sizeof(uint64_t) * sPosCnt);
+
+    if (aGen->mPatchPos == NULL || aGen->mPatchValue == NULL || sOrigin == NULL)
+    {
+        free(sOrigin);
+        return -1;
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < sPosCnt; i++)
+    {
+        aGen->mPatchPos[i] = patternPosBelow(patternRandom(aGen->mKey[PATTERN_STREAM_SWAP], i), aGen->mCount);
+    }
+
+    qsort(aGen->mPatchPos, sPosCnt, sizeof(uint64_t), patternComparePos);
+
+    /* unique */
+    for (i = 1, j = 1; i < sPosCnt; i++)
+    {
+        if (aGen->mPatchPos[i] != aGen->mPatchPos[j - 1])
+        {
+            aGen->mPatchPos[j++] = aGen->mPatchPos[i];
+        }
+        else
+        {
+        }
+    }
+
+    aGen->mPatchCnt = j;
+
+    /*
+     * sOrigin[k] : sorted index of the element that ends up at mPatchPos[k]
+     */
+    for (i = 0; i < aGen->mPatchCnt; i++)
+    {
+        sOrigin[i] = aGen->mPatchPos[i];
+    }
+
+    for (i = 0; i < aGen->mParam; i++)
+    {
+        sPos1 = patternPosBelow(patternRandom(aGen->mKey[PATTERN_STREAM_SWAP], 2 * i), aGen->mCount);
+        sPos2 = patternPosBelow(patternRandom(aGen->mKey[PATTERN_STREAM_SWAP], 2 * i + 1), aGen->mCount);
+
+        sPos1 = patternLowerBound(aGen->mPatchPos, aGen->mPatchCnt, sPos1);
+        sPos2 = patternLowerBound(aGen->mPatchPos, aGen->mPatchCnt, sPos2);
+
+        sTemp          = sOrigin[sPos1];
+        sOrigin[sPos1] = sOrigin[sPos2];
+        sOrigin[sPos2] = sTemp;
+    }
+
+    for (i = 0; i < aGen->mPatchCnt; i++)
+    {
+        aGen->mPatchValue[i] = patternSortedValue(aGen->mKey[PATTERN_STREAM_VALUE], aGen->mCount, sOrigin[i]);
+    }
+
+    free(sOrigin);
+
+    return 0;
+}
+
+/*
+ * adversarial : run lengths that break the stack invariant
+ * runLen[n - 2] > runLen[n - 1] + runLen[n] deeper in the stack than
+ * timMergeCollapse() looks, as found by de Gouw et al. for the Java port.
+ * Every run is 0 ... 0 1, so the next 0 starts a new run;
+ * the 1s are the patches.
+ */
+typedef struct patternRunList
+{
+    int64_t  *mLen;
+    uint32_t  mCount;
+    uint32_t  mCapacity;
+} patternRunList;
+
+static int32_t patternRunListAdd(patternRunList *aList, int64_t aLen)
+{
+    if (aList->mCount == aList->mCapacity)
+    {
+        int64_t *sLen;
+
+        aList->mCapacity = aList->mCapacity == 0 ? 64 : aList->mCapacity * 2;
+        sLen             = realloc(aList->mLen, sizeof(int64_t) * aList->mCapacity);
+
+        if (sLen == NULL) return -1;
+
+        aList->mLen = sLen;
+    }
+    else
+    {
+    }
+
+    aList->mLen[aList->mCount++] = aLen;
+
+    return 0;
+}
+
+/*
+ * Splits aX into runs. The list is built back to front.
+ */
+static int32_t patternAddWrongElem(patternRunList *aList, int64_t aMinRun, int64_t aX)
+{
+    int64_t sNewTotal;
+
+    for (; aX >= 2 * aMinRun + 1; aX = sNewTotal)
+    {
+        sNewTotal = aX / 2 + 1;
+
+        if (3 * aMinRun + 3 <= aX && aX <= 4 * aMinRun + 1)
+        {
+            sNewTotal = 2 * aMinRun + 1;
+        }
+        else if (5 * aMinRun + 5 <= aX && aX <= 6 * aMinRun + 5)
+        {
+            sNewTotal = 3 * aMinRun + 3;
+        }
+        else if (8 * aMinRun + 9 <= aX && aX <= 10 * aMinRun + 9)
+        {
+            sNewTotal = 5 * aMinRun + 5;
+        }
+        else if (13 * aMinRun + 15 <= aX && aX <= 16 * aMinRun + 17)
+        {
+            sNewTotal = 8 * aMinRun + 9;
+        }
+        else
+        {
+        }
+
+        if (patternRunListAdd(aList, aX - sNewTotal) != 0) return -1;
+    }
+
+    return patternRunListAdd(aList, aX);
+}
+
+static int32_t patternInitAdversarial(patternGen *aGen)
+{
+    patternRunList  sList  = { NULL, 0, 0 };
+    int64_t         sTotal = 0;
+    int64_t         sX     = aGen->mParam;
+    int64_t         sY     = aGen->mParam + 4;
+    int64_t         sEnd;
+    uint32_t        i;
+
+    while (sTotal + sX + sY <= aGen->mCount)
+    {
+        sTotal += sX + sY;
+
+        if (patternAddWrongElem(&sList, aGen->mParam, sX) != 0) goto LABEL_FAIL;
+        if (patternRunListAdd(&sList, sY) != 0)                 goto LABEL_FAIL;
+
+        /* the run just before sY, in array order */
+        sX  = sY + sList.mLen[sList.mCount - 2] + 1;
+        sY += sX + 1;
+    }
+
+    if (sTotal + sX <= aGen->mCount)
+    {
+        sTotal += sX;
+
+        if (patternAddWrongElem(&sList, aGen->mParam, sX) != 0) goto LABEL_FAIL;
+    }
+    else
+    {
+    }
+
+    /*
+     * The remainder after the last listed run is a run of its own,
+     * and the very last element is always 0.
+     */
+    aGen->mPatchPos   = malloc(sizeof(uint64_t) * (sList.mCount + 1));
+    aGen->mPatchValue = malloc(sizeof(uint32_t) * (sList.mCount + 1));
+
+    if (aGen->mPatchPos == NULL || aGen->mPatchValue == NULL) goto LABEL_FAIL;
+
+    sEnd = -1;
+
+    for (i = sList.mCount; i > 0; i--)
+    {
+        sEnd += sList.mLen[i - 1];
+
+        if (sEnd < (int64_t)aGen->mCount - 1)
+        {
+            aGen->mPatchPos[aGen->mPatchCnt]   = (uint64_t)sEnd;
+            aGen->mPatchValue[aGen->mPatchCnt] = 1;
+            aGen->mPatchCnt++;
+        }
+        else
+        {
+        }
+    }
+
+    free(sList.mLen);
+    return 0;
+
+LABEL_FAIL:
+    free(sList.mLen);
+    return -1;
+}
+
+/*
+ * Returns 0 on success, -1 if out of memory.
+ * aParam must satisfy patternTakesParam().
+ */
+int32_t patternInit(patternGen *aGen, patternId aPattern, uint64_t aCount, uint32_t aParam, uint64_t aSeed)
+{
+    int32_t  sRet = 0;
+    uint32_t i;
+
+    memset(aGen, 0, sizeof(*aGen));
+
+    aGen->mPattern = aPattern;
+    aGen->mCount   = aCount;
+    aGen->mParam   = aParam;
+    aGen->mSeed    = aSeed;
+
+    for (i = 0; i < PATTERN_STREAM_MAX; i++)
+    {
+        aGen->mKey[i] = patternMix(aSeed * PATTERN_STREAM_MAX + i);
+    }
+
+    switch (aPattern)
+    {
+        case PATTERN_FEW_UNIQUE:
+        case PATTERN_ZIPF:
+            sRet = patternInitTable(aGen);
+            break;
+
+        case PATTERN_SAWTOOTH:
+            sRet = patternInitRuns(aGen);
+            break;
+
+        case PATTERN_ALMOST:
+            sRet = patternInitSwaps(aGen);
+            break;
+
+        case PATTERN_ADVERSARIAL:
+            sRet = patternInitAdversarial(aGen);
+            break;
+
+        default:
+            break;
+    }
+
+    if (sRet != 0)
+    {
+        patternDestroy(aGen);
+    }
+    else
+    {
+    }
+
+    return sRet;
+}
+
+void patternDestroy(patternGen *aGen)
+{
+    free(aGen->mTable);
+    free(aGen->mCdf);
+    free(aGen->mRunStart);
+    free(aGen->mPatchPos);
+    free(aGen->mPatchValue);
+
+    aGen->mTable      = NULL;
+    aGen->mCdf        = NULL;
+    aGen->mRunStart   = NULL;
+    aGen->mPatchPos   = NULL;
+    aGen->mPatchValue = NULL;
+    aGen->mTableCnt   = 0;
+    aGen->mRunCnt     = 0;
+    aGen->mPatchCnt   = 0;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Generating
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Overwrites the patched positions in [aBegin, aEnd)
+ */
+static void patternApplyPatch(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut)
+{
+    uint64_t i;
+
+    for (i = patternLowerBound(aGen->mPatchPos, aGen->mPatchCnt, aBegin);
+         i < aGen->mPatchCnt && aGen->mPatchPos[i] < aEnd;
+         i++)
+    {
+        aOut[aGen->mPatchPos[i] - aBegin] = aGen->mPatchValue[i];
+    }
+}
+
+static void patternFillSine(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut)
+{
+    double   sDelta = 2 * PATTERN_SINE_CYCLE_CNT * M_PI / aGen->mCount;
+    double   x;
+    double   sValue;
+    uint64_t i;
+
+    for (i = aBegin; i < aEnd; i++)
+    {
+        x = (i + 1) * sDelta;
+
+        switch (aGen->mPattern)
+        {
+            case PATTERN_SINWAVE1:
+                sValue = (sin(x) + 1) * 100000 * x;
+                aOut[i - aBegin] = 0xFFFFFFFF - (uint32_t)sValue;
+                break;
+
+            case PATTERN_CHAINSAW:
+                sValue = (sin(x) + 1) * 100000;
+                aOut[i - aBegin] = 0xFFFFFFFF - (uint32_t)sValue;
+                break;
+
+            default:
+                sValue  = (sin(x) + 1) * 10000000;
+                sValue += (cos(M_PI * x) + 1) * 10000000;
+                aOut[i - aBegin] = (uint32_t)sValue;
+                break;
+        }
+    }
+}
+
+static void patternFillSawtooth(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut)
+{
+    uint64_t sRun;
+    uint64_t sRunStart;
+    uint64_t sRunLen;
+    uint64_t sRunKey;
+    uint64_t i;
+
+    /* the run aBegin is in */
+    sRun = patternLowerBound(aGen->mRunStart, aGen->mRunCnt, aBegin + 1) - 1;
+
+    for (i = aBegin; i < aEnd; sRun++)
+    {
+        sRunStart = aGen->mRunStart[sRun];
+        sRunLen   = (sRun + 1 < aGen->mRunCnt ? aGen->mRunStart[sRun + 1] : aGen->mCount) - sRunStart;
+        sRunKey   = patternRandom(aGen->mKey[PATTERN_STREAM_RUN], (uint64_t)aGen->mCount + sRun);
+
+        for (; i < aEnd && i < sRunStart + sRunLen; i++)
+        {
+            aOut[i - aBegin] = patternSortedValue(sRunKey, sRunLen, i - sRunStart);
+        }
+    }
+}
+
+/*
+ * Shuffling within blocks of mParam + 1 elements cannot move anything further than mParam.
+ * Blocks cut by aBegin or aEnd are built whole and only their part in range is kept.
+ */
+static void patternFillBounded(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut)
+{
+    uint64_t  sBlockLen = (uint64_t)aGen->mParam + 1;
+    uint64_t  sBlock;
+    uint64_t  sLen;
+    uint32_t *sTemp;
+    uint32_t  sValue;
+    uint64_t  i;
+    uint64_t  j;
+    uint64_t  k;
+
+    if (aBegin >= aEnd) return;
+
+    sTemp = malloc(sizeof(uint32_t) * (sBlockLen < aGen->mCount ? sBlockLen : aGen->mCount));
+    assert(sTemp != NULL);
+
+    for (sBlock = aBegin / sBlockLen * sBlockLen; sBlock < aEnd; sBlock += sBlockLen)
+    {
+        sLen = aGen->mCount - sBlock < sBlockLen ? aGen->mCount - sBlock : sBlockLen;
+
+        for (i = 0; i < sLen; i++)
+        {
+            sTemp[i] = patternSortedValue(aGen->mKey[PATTERN_STREAM_VALUE], aGen->mCount, sBlock + i);
+        }
+
+        for (j = sLen - 1; j > 0; j--)
+        {
+            k = patternRandomBelow(patternRandom(aGen->mKey[PATTERN_STREAM_SHUFFLE], sBlock + j), j + 1);
+
+            sValue   = sTemp[j];
+            sTemp[j] = sTemp[k];
+            sTemp[k] = sValue;
+        }
+
+        for (i = 0; i < sLen; i++)
+        {
+            if (sBlock + i >= aBegin && sBlock + i < aEnd)
+            {
+                aOut[sBlock + i - aBegin] = sTemp[i];
+            }
+            else
+            {
+            }
+        }
+    }
+
+    free(sTemp);
+}
+
+static uint32_t patternZipfValue(const patternGen *aGen, uint64_t aRandom)
+{
+    double   sDraw  = (aRandom >> 11) * (1.0 / 9007199254740992.0) * aGen->mCdf[aGen->mTableCnt - 1];
+    uint32_t sLow   = 0;
+    uint32_t sHigh  = aGen->mTableCnt - 1;
+    uint32_t sMiddle;
+
+    /* first rank whose cdf exceeds the draw */
+    while (sLow < sHigh)
+    {
+        sMiddle = (sLow + sHigh) / 2;
+
+        if (aGen->mCdf[sMiddle] <= sDraw)
+        {
+            sLow = sMiddle + 1;
+        }
+        else
+        {
+            sHigh = sMiddle;
+        }
+    }
+
+    return aGen->mTable[sLow];
+}
+
+/*
+ * Writes elements [aBegin, aEnd) to aOut[0 .. aEnd - aBegin).
+ * May be called from several threads at once.
+ */
+void patternFill(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut)
+{
+    const uint64_t sValueKey = aGen->mKey[PATTERN_STREAM_VALUE];
+    const uint64_t sCount    = aGen->mCount;
+    uint64_t       i;
+
+    switch (aGen->mPattern)
+    {
+        case PATTERN_RANDOM:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = (uint32_t)patternRandom(sValueKey, i);
+            }
+            break;
+
+        case PATTERN_SORTED:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = patternSortedValue(sValueKey, sCount, i);
+            }
+            break;
+
+        case PATTERN_SORTED_REVERSE:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = patternSortedValue(sValueKey, sCount, sCount - 1 - i);
+            }
+            break;
+
+        case PATTERN_SINWAVE1:
+        case PATTERN_CHAINSAW:
+        case PATTERN_SINWAVE2:
+            patternFillSine(aGen, aBegin, aEnd, aOut);
+            break;
+
+        case PATTERN_IDENTICAL:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = 1234567;
+            }
+            break;
+
+        case PATTERN_ALMOST:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = patternSortedValue(sValueKey, sCount, i);
+            }
+
+            patternApplyPatch(aGen, aBegin, aEnd, aOut);
+            break;
+
+        case PATTERN_SORTED_TAIL:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                if (i < sCount - aGen->mParam)
+                {
+                    aOut[i - aBegin] = patternSortedValue(sValueKey, sCount - aGen->mParam, i);
+                }
+                else
+                {
+                    aOut[i - aBegin] = (uint32_t)patternRandom(sValueKey, i);
+                }
+            }
+            break;
+
+        case PATTERN_PIPE_ORGAN:
+            /*
+             * Even ranks on the way up, odd ranks on the way down,
+             * so that both halves cover the whole range.
+             */
+            for (i = aBegin; i < aEnd; i++)
+            {
+                uint64_t sHalf = (sCount + 1) / 2;
+                uint64_t sRank;
+
+                if (i < sHalf)
+                {
+                    sRank = 2 * i;
+                }
+                else
+                {
+                    sRank = ((sCount & 1) == 0 ? sCount - 1 : sCount - 2) - 2 * (i - sHalf);
+                }
+
+                aOut[i - aBegin] = patternSortedValue(sValueKey, sCount, sRank);
+            }
+            break;
+
+        case PATTERN_SAWTOOTH:
+            patternFillSawtooth(aGen, aBegin, aEnd, aOut);
+            break;
+
+        case PATTERN_FEW_UNIQUE:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = aGen->mTable[patternRandomBelow(patternRandom(sValueKey, i), aGen->mTableCnt)];
+            }
+            break;
+
+        case PATTERN_BOUNDED:
+            patternFillBounded(aGen, aBegin, aEnd, aOut);
+            break;
+
+        case PATTERN_ZIPF:
+            for (i = aBegin; i < aEnd; i++)
+            {
+                aOut[i - aBegin] = patternZipfValue(aGen, patternRandom(sValueKey, i));
+            }
+            break;
+
+        case PATTERN_INTERLEAVED:
+            /*
+             * Element i is element i / mParam of stream i % mParam
+             */
+            for (i = aBegin; i < aEnd; i++)
+            {
+                uint32_t sStream    = (uint32_t)(i % aGen->mParam);
+                uint64_t sStreamLen = (sCount - sStream + aGen->mParam - 1) / aGen->mParam;
+
+                aOut[i - aBegin] = patternSortedValue(patternRandom(sValueKey, sCount + sStream),
+                                                      sStreamLen,
+                                                      i / aGen->mParam);
+            }
+            break;
+
+        case PATTERN_ADVERSARIAL:
+            memset(aOut, 0, sizeof(uint32_t) * (aEnd - aBegin));
+
+            patternApplyPatch(aGen, aBegin, aEnd, aOut);
+            break;
+
+        case PATTERN_NONE:
+        case PATTERN_MAX:
+            abort();
+            break;
+    }
+}
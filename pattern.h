@@ -0,0 +1,91 @@
+#ifndef __PATTERN_H__
+#define __PATTERN_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Input patterns of gendata.
+ *
+ * Element i of a pattern is a function of (seed, parameter, count, i) only.
+ * Random numbers come from a counter based generator, i.e. a hash of the seed
+ * and the element index, instead of a sequence. Any range of elements can
+ * therefore be generated on its own, by any number of threads, and the data
+ * does not depend on how it was split.
+ * Sorted data is built in order (see patternSortedValue() in pattern.c)
+ * instead of by sorting random data.
+ * Counts and positions are 64 bit, the keys 32 bit.
+ */
+#define PATTERN_MAX_PARAM   INT32_MAX   /* largest pattern parameter, gendata -a */
+
+typedef enum
+{
+    PATTERN_NONE,
+    PATTERN_RANDOM,
+    PATTERN_SORTED,
+    PATTERN_SORTED_REVERSE,
+    PATTERN_SINWAVE1,
+    PATTERN_CHAINSAW,
+    PATTERN_IDENTICAL,
+    PATTERN_SINWAVE2,
+    PATTERN_ALMOST,
+    PATTERN_SORTED_TAIL,
+    PATTERN_PIPE_ORGAN,
+    PATTERN_SAWTOOTH,
+    PATTERN_FEW_UNIQUE,
+    PATTERN_BOUNDED,
+    PATTERN_ZIPF,
+    PATTERN_INTERLEAVED,
+    PATTERN_ADVERSARIAL,
+    PATTERN_MAX
+} patternId;
+
+/*
+ * Random streams. Each use of random numbers has its own,
+ * so that e.g. the swaps of "almost" do not shift the values.
+ */
+typedef enum
+{
+    PATTERN_STREAM_VALUE,
+    PATTERN_STREAM_SWAP,
+    PATTERN_STREAM_RUN,
+    PATTERN_STREAM_TABLE,
+    PATTERN_STREAM_SHUFFLE,
+    PATTERN_STREAM_MAX
+} patternStream;
+
+typedef struct patternGen
+{
+    patternId   mPattern;
+    uint64_t    mCount;
+    uint32_t    mParam;
+    uint64_t    mSeed;
+
+    uint64_t    mKey[PATTERN_STREAM_MAX];   /* derived from mSeed, one per stream */
+
+    /*
+     * Built by patternInit() for the patterns that need it, read only afterwards
+     */
+    uint32_t    mTableCnt;
+    uint32_t   *mTable;         /* fewunique, zipf : the distinct values */
+    double     *mCdf;           /* zipf : cumulative weights of mTable */
+
+    uint64_t    mRunCnt;
+    uint64_t   *mRunStart;      /* sawtooth : where each run starts */
+
+    uint64_t    mPatchCnt;
+    uint64_t   *mPatchPos;      /* almost, adversarial : ascending positions ... */
+    uint32_t   *mPatchValue;    /* ... and the values found there */
+} patternGen;
+
+const char *patternName(patternId aPattern);
+const char *patternDesc(patternId aPattern);
+patternId   patternFind(const char *aName);
+
+int32_t     patternTakesParam(patternId aPattern, uint64_t aCount, uint32_t *aDefault, uint32_t *aMin);
+
+int32_t     patternInit(patternGen *aGen, patternId aPattern, uint64_t aCount, uint32_t aParam, uint64_t aSeed);
+void        patternFill(const patternGen *aGen, uint64_t aBegin, uint64_t aEnd, uint32_t *aOut);
+void        patternDestroy(patternGen *aGen);
+
+#endif
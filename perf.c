@@ -1,36 +1,390 @@
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <errno.h>
 #include <stdio.h>
-#include <sys/time.h>
+#include <time.h>
+#include <sched.h>
 #include <math.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 #include "timsort.h"
 #include "timsort1.h"
+#include "timisa.h"
+#include "dataset.h"
+#include "pattern.h"
+
+#define PERF_DEFAULT_REPEAT_CNT     11
+#define PERF_DEFAULT_WARMUP_CNT     1
+#define PERF_MAX_ALGORITHM_CNT      16
+#define PERF_MAX_WIDTH_CNT          16
+#define PERF_MAX_COMPARATOR_CNT     8
+#define PERF_MAX_PATTERN_CNT        PATTERN_MAX
+#define PERF_KEY_SIZE               sizeof(uint32_t)
+#define PERF_DEFAULT_SPIN_CYCLES    100
+#define PERF_DEFAULT_GEN_CNT        1000000
+#define PERF_MAX_SIZE_CNT           32
+#define PERF_SWEEP_MIN_EXP          4
+#define PERF_SWEEP_MAX_EXP          30          /* 2^31 does not fit in int32_t */
+#define PERF_BATCH_ELEM_CNT         65536       /* small sizes are sorted this many elements at a time */
+#define PERF_DEFAULT_THRESHOLD      5.0         /* percent slower than the baseline that is a regression */
+#define PERF_MAX_THRESHOLD          1000.0      /* largest -T, in percent */
+#define PERF_SIGNIFICANCE           0.01        /* p-value below which a difference is not noise */
+#define PERF_BASELINE_MAGIC         "#perf-baseline 1"
+#define PERF_EXIT_REGRESSION        2
+#define PERF_INSTR_THRESHOLD        0.2         /* percent more instructions that is a regression */
+#define PERF_VERIFY_BLOCK_CNT       4096        /* elements verifyArrayIsStable() checks at a time */
+#define PERF_MAX_THREAD_CNT_CNT     16          /* thread counts given with -P */
+#define PERF_MAX_THREAD_CNT         1024
+#define PERF_CONCURRENT_ELEM_CNT    (1 << 22)   /* elements each thread sorts by default with -P */
+#define PERF_CONCURRENT_MIN_SORTS   100
+#define PERF_ESCAPED_LEN            4096        /* an input name escaped for -o json or -o csv */
+
+typedef void perfSortFunc(void *, size_t, size_t, int (*)(const void *, const void *));
+typedef void perfStatSortFunc(void *, size_t, size_t, int (*)(const void *, const void *), timStat *);
 
 /*
  * -----------------------------------------------------------------------------
  *  Configure Structure
  * -----------------------------------------------------------------------------
  */
-typedef struct perfContext
+typedef enum
+{
+    PERF_OUTPUT_NONE,
+    PERF_OUTPUT_CSV,
+    PERF_OUTPUT_JSON
+} perfOutputFormat;
+
+typedef struct perfAlgorithm
+{
+    const char    *mName;
+    const char    *mDesc;
+    perfSortFunc      *mSortFunc;
+    perfStatSortFunc  *mStatSortFunc;   /* reports merge memory, and moves, runs, merges and gallops
+                                           in a make stat build. NULL if not available */
+} perfAlgorithm;
+
+typedef struct perfContext perfContext;
+
+/*
+ * Hardware events counted per sort with -I, user space only
+ */
+typedef enum
+{
+    PERF_EVENT_INSTRUCTIONS,
+    PERF_EVENT_CACHE_MISSES,
+    PERF_EVENT_BRANCH_MISSES,
+    PERF_EVENT_DTLB_MISSES,
+    PERF_EVENT_MAX
+} perfEventId;
+
+/*
+ * A comparator and the way its key is laid out in an element.
+ * Every comparator orders elements the same way as the uint32_t key they are built from.
+ */
+typedef struct perfComparator
+{
+    const char    *mName;
+    const char    *mDesc;
+    size_t         mKeySize;    /* bytes at the key offset the comparator looks at */
+    size_t         mStringLen;  /* length of the pointed strings, 0 if not a string comparator */
+
+    void         (*mBuildKey)(perfContext *aContext, uint8_t *aElem, int32_t aIndex);
+    int          (*mCompareFunc)(const void *, const void *);
+} perfComparator;
+
+/*
+ * A comparator selected with -C
+ */
+typedef struct perfComparatorUse
+{
+    const perfComparator *mComparator;
+    uint32_t              mSpinCycles;  /* spin only */
+    char                  mName[32];    /* as shown in the report, e.g. "spin:100" */
+} perfComparatorUse;
+
+/*
+ * A pattern selected with -g
+ */
+typedef struct perfPatternUse
+{
+    patternId             mPattern;
+    int32_t               mParam;       /* -1 : the pattern's default for each size */
+    char                  mName[32];    /* as shown in the report, e.g. "sawtooth:50" */
+} perfPatternUse;
+
+/*
+ * Samples of one configuration in a baseline file
+ */
+typedef struct perfBaselineEntry
+{
+    char                  mInput[256];
+    char                  mComparator[32];
+    char                  mAlgorithm[32];
+    size_t                mWidth;
+    int32_t               mCount;
+
+    int32_t               mSampleCnt;
+    double               *mSample;
+
+    double                mInstrCnt;        /* instructions per sort, -1 if not counted */
+} perfBaselineEntry;
+
+/*
+ * Results saved with -S, compared with -b.
+ * Timings only compare on the machine and configuration they were taken with,
+ * so both are kept to warn about a mismatch.
+ */
+typedef struct perfBaseline
+{
+    char                  mMachine[256];
+    char                  mConfig[256];
+
+    uint32_t              mEntryCnt;
+    perfBaselineEntry    *mEntry;
+} perfBaseline;
+
+/*
+ * Statistics of the repetitions of one algorithm.
+ * All times are in nanoseconds.
+ */
+typedef struct perfResult
+{
+    const perfAlgorithm     *mAlgorithm;
+    const perfComparatorUse *mComparator;
+    const char              *mInput;    /* pattern name, or the input file name */
+    size_t                   mWidth;    /* element width the algorithm sorted */
+    int32_t                  mCount;    /* elements sorted */
+    int32_t                  mBatchCnt; /* copies sorted back to back per sample, see perfRunOnce() */
+    double                   mLowerBound;   /* log2(mCount!), the comparisons any comparison sort needs */
+
+    double               mMin;
+    double               mMedian;
+    double               mP90;
+    double               mMean;
+    double               mStdDev;
+    double               mElemPerSec;   /* throughput, based on the median */
+
+    /*
+     * Cost split between comparing and moving.
+     * The comparison count does not depend on the element width,
+     * so if mNsecPerCmp grows along with the width, the sort is bound by moves.
+     */
+    uint64_t             mCompareCnt;   /* counted in a separate, unmeasured run */
+    double               mNsecPerCmp;   /* median / mCompareCnt */
+    double               mNsecPerByte;  /* median / (count * width) */
+    double               mNsecPerElem;  /* median / count, the figure to follow across sizes */
+
+    /*
+     * Work done by the counting run, filled by mStatSortFunc.
+     * mStat.mEnabled is 0 if the algorithm has none or perf was not built with make stat,
+     * mStat.mMergeMemPeak is filled in every build if there is an mStatSortFunc.
+     */
+    timStat              mStat;
+
+    double              *mSample;       /* mRepeatCnt samples, in run order */
+
+    /*
+     * Median of the events of a sort over the repetitions (-I). -1 if not counted
+     */
+    double               mEvent[PERF_EVENT_MAX];
+    double              *mEventSample;  /* mRepeatCnt samples of each event */
+
+    /*
+     * Memory of the counting run, see perfMemoryStart(). -1 if not measured
+     */
+    int64_t              mMallocCnt;    /* malloc(), calloc() and realloc() calls */
+    int64_t              mFreeCnt;      /* free() calls, and realloc() of a block */
+    int64_t              mAllocBytes;   /* bytes requested by them */
+    int64_t              mHeapPeak;     /* most bytes in use at once, beyond those in use before */
+    int64_t              mRssPeak;      /* peak resident bytes, beyond those resident before */
+} perfResult;
+
+/*
+ * What -v and -V check
+ */
+typedef enum
+{
+    PERF_VERIFY_NONE,
+    PERF_VERIFY_ORDER,          /* -v : adjacent elements are in order */
+    PERF_VERIFY_STABLE          /* -V : order, stability and payload, with the original index */
+} perfVerifyMode;
+
+/*
+ * Sorts run by -P threads at once, each sorting its own copies
+ */
+typedef struct perfConcurrentResult
+{
+    const perfAlgorithm     *mAlgorithm;
+    const perfComparatorUse *mComparator;
+    const char              *mInput;
+    size_t                   mWidth;
+    int32_t                  mCount;        /* elements of each sort */
+    int32_t                  mThreadCnt;
+    int32_t                  mSortCnt;      /* sorts per thread */
+
+    double                   mElemPerSec;   /* all threads together, copying the input included */
+
+    /*
+     * Latency of one sort in nanoseconds, over the sorts of all threads
+     */
+    double                   mP50;
+    double                   mP99;
+    double                   mP999;
+    double                   mMax;
+
+    uint32_t                 mFailCnt;      /* threads whose last sort did not verify */
+} perfConcurrentResult;
+
+struct perfContext
 {
-    int32_t      mDoVerify;
-    char        *mFileName;
+    int32_t               mDoVerify;        /* perfVerifyMode, -1 until set */
+    char                 *mFileName;       /* NULL if the keys are generated */
+
+    /*
+     * Keys generated in memory (-g) instead of read from mFileName
+     */
+    uint32_t              mPatternCnt;      /* 0 if read from mFileName */
+    perfPatternUse        mPattern[PERF_MAX_PATTERN_CNT];
+    const char           *mInput;           /* pattern or file being sorted */
+    int32_t               mSeed;
+    int32_t               mGenCount;        /* -n, keys generated or taken from the file */
+
+    /*
+     * Sizes to sort. Just the whole input unless swept with -N,
+     * in which case a file provides the first mSize[i] keys of it
+     * and a pattern is generated again for each size.
+     */
+    int32_t               mSweepLow;        /* exponents of 2, -1 if no sweep */
+    int32_t               mSweepHigh;       /* 0 : as large as memory allows */
+    uint32_t              mSizeCnt;
+    int32_t               mSize[PERF_MAX_SIZE_CNT];
+
+    int32_t               mKeyCnt;          /* keys mKeyArray has room for */
+    int32_t               mCount;           /* size being sorted */
+    int32_t               mBatchCnt;        /* copies of mSourceArray in mArrayToSort */
+
+    uint32_t             *mKeyArray;        /* keys as read from the file or generated */
+
+    /*
+     * Element layout.
+     * Every element is mWidth[i] bytes with a uint32_t key at mKeyOffset.
+     * The rest of an element is filled with payload derived from its original index.
+     */
+    uint32_t              mWidthCnt;
+    size_t                mWidth[PERF_MAX_WIDTH_CNT];
+    int32_t               mKeyOffset;
+    int32_t               mIndexOffset;     /* -V : where the original index is, -1 if no room */
+
+    uint8_t              *mSourceArray;     /* elements built from mKeyArray, never sorted */
+    uint8_t              *mArrayToSort;     /* mBatchCnt fresh copies of mSourceArray for every run */
+    int                 (*mCompareFunc)(const void *, const void *);
 
-    int32_t      mCount;            /* read from input file */
+    uint32_t              mComparatorCnt;
+    perfComparatorUse     mComparator[PERF_MAX_COMPARATOR_CNT];
+    char                 *mStringPool;      /* strings the elements point to, string comparators only */
+    size_t                mStringLen;       /* length of each string in mStringPool */
 
-    uint32_t    *mArrayToSort;      /* array to sort */
+    int32_t               mRepeatCnt;       /* measured runs per algorithm */
+    int32_t               mWarmupCnt;       /* unmeasured runs per algorithm */
+    int32_t               mCpu;             /* cpu to pin to, -1 if not pinned */
+    int32_t               mCountOnly;       /* -c : counting run only, no timing */
+    int32_t               mCountEvent;      /* -I : count instructions and misses of the timed runs */
+    int                   mEventFd[PERF_EVENT_MAX];     /* -1 if not available */
 
-    void       (*mSortFunc)(void *, size_t, size_t, int (*compar)(const void *, const void *));
-} perfContext;
+    perfOutputFormat      mOutputFormat;
+    char                 *mOutputFileName;  /* NULL means stdout */
+
+    /*
+     * Regression tracking
+     */
+    char                 *mSaveFileName;    /* -S : baseline to write, NULL if none */
+    char                 *mBaselineFileName;/* -b : baseline to compare with, NULL if none */
+    double                mThreshold;       /* -T : percent slower that counts as a regression */
+    perfBaseline          mBaseline;        /* read from mBaselineFileName */
+
+    uint32_t              mAlgorithmCnt;
+    const perfAlgorithm  *mAlgorithm[PERF_MAX_ALGORITHM_CNT];
+
+    uint32_t              mResultCnt;
+    perfResult           *mResult;          /* inputs * sizes * comparators * widths * algorithms */
+
+    /*
+     * -P : many sorts at once instead of one at a time
+     */
+    uint32_t              mThreadCntCnt;    /* 0 if not given */
+    int32_t               mThreadCnt[PERF_MAX_THREAD_CNT_CNT];
+    int32_t               mSortCnt;         /* -M : sorts per thread, -1 : PERF_CONCURRENT_ELEM_CNT elements */
+
+    uint32_t              mConcurrentResultCnt;
+    perfConcurrentResult *mConcurrentResult;    /* mResult times the thread counts */
+};
 
 static void perfContextInit(perfContext *aContext)
 {
-    aContext->mDoVerify      = -1;
-    aContext->mFileName      = NULL;
-    aContext->mCount         = -1;
+    aContext->mDoVerify       = -1;
+    aContext->mFileName       = NULL;
+
+    aContext->mPatternCnt     = 0;
+    aContext->mInput          = NULL;
+    aContext->mSeed           = -1;
+    aContext->mGenCount       = -1;
+
+    aContext->mSweepLow       = -1;
+    aContext->mSweepHigh      = -1;
+    aContext->mSizeCnt        = 0;
+
+    aContext->mKeyCnt         = 0;
+    aContext->mCount          = -1;
+    aContext->mBatchCnt       = 1;
+
+    aContext->mKeyArray       = NULL;
+
+    aContext->mWidthCnt       = 0;
+    aContext->mKeyOffset      = -1;
+    aContext->mIndexOffset    = -1;
+
+    aContext->mSourceArray    = NULL;
+    aContext->mArrayToSort    = NULL;
+    aContext->mCompareFunc    = NULL;
+
+    aContext->mComparatorCnt  = 0;
+    aContext->mStringPool     = NULL;
+    aContext->mStringLen      = 0;
 
-    aContext->mArrayToSort   = NULL;
+    aContext->mRepeatCnt      = -1;
+    aContext->mWarmupCnt      = -1;
+    aContext->mCpu            = -1;
+    aContext->mCountOnly      = -1;
+    aContext->mCountEvent     = -1;
+
+    aContext->mOutputFormat   = PERF_OUTPUT_NONE;
+    aContext->mOutputFileName = NULL;
+
+    aContext->mSaveFileName     = NULL;
+    aContext->mBaselineFileName = NULL;
+    aContext->mThreshold        = -1;
+    aContext->mBaseline.mEntryCnt = 0;
+    aContext->mBaseline.mEntry    = NULL;
+
+    aContext->mAlgorithmCnt   = 0;
+    aContext->mResultCnt      = 0;
+    aContext->mResult         = NULL;
+
+    aContext->mThreadCntCnt   = 0;
+    aContext->mSortCnt        = -1;
+
+    aContext->mConcurrentResultCnt = 0;
+    aContext->mConcurrentResult    = NULL;
 }
 
 /*
@@ -38,6 +392,20 @@ static void perfContextInit(perfContext *aContext)
  *  Wrappers for heapsort and mergesort
  * -----------------------------------------------------------------------------
  */
+/*
+ * mergesort() and heapsort() come with the BSD libcs. glibc has neither,
+ * there they need libbsd, which the Makefile detects (PERF_HAVE_LIBBSD).
+ */
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define PERF_HAVE_BSD_SORT      1
+#elif defined(PERF_HAVE_LIBBSD)
+#include <bsd/stdlib.h>
+#define PERF_HAVE_BSD_SORT      1
+#else
+#define PERF_HAVE_BSD_SORT      0
+#endif
+
+#if PERF_HAVE_BSD_SORT == 1
 static void mergesortLibc(void    *base,
                           size_t   nel,
                           size_t   width,
@@ -53,13 +421,44 @@ static void heapsortLibc(void    *base,
 {
     (void)heapsort(base, nel, width, compar);
 }
+#endif
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Registered Algorithms
+ * -----------------------------------------------------------------------------
+ */
+static const perfAlgorithm gAlgorithm[] =
+{
+    { "quick", "libc qsort",               qsort,         NULL         },
+#if PERF_HAVE_BSD_SORT == 1
+    { "merge", "BSD mergesort",            mergesortLibc, NULL         },
+    { "heap",  "BSD heapsort",             heapsortLibc,  NULL         },
+#endif
+    { "tim",   "timsort",                  timsort,       timsortStat  },
+    { "tim1",  "timsort (pointer, bytes)", timsort1,      timsort1Stat },
+    { NULL,    NULL,                       NULL,          NULL         }
+};
 
 /*
  * -----------------------------------------------------------------------------
  *  Verifying Sorted Array
  * -----------------------------------------------------------------------------
  */
-static int32_t verifyArrayIsSorted(uint32_t *aArray, int32_t aCount)
+static uint32_t getKey(const uint8_t *aElem, size_t aKeyOffset)
+{
+    uint32_t sKey;
+
+    /* elements wider than the key are not necessarily aligned for it */
+    memcpy(&sKey, aElem + aKeyOffset, PERF_KEY_SIZE);
+
+    return sKey;
+}
+
+static int32_t verifyArrayIsSorted(const uint8_t *aArray,
+                                   int32_t        aCount,
+                                   size_t         aWidth,
+                                   int          (*aCmpCb)(const void *, const void *))
 {
     int32_t i;
 
@@ -67,266 +466,4008 @@ static int32_t verifyArrayIsSorted(uint32_t *aArray, int32_t aCount)
     (void)printf("\n");
     for (i = 0; i < aCount; i++)
     {
-        (void)printf("%u\n", *(aArray + i));
+        (void)printf("%u\n", getKey(aArray + i * aWidth, 0));
     }
 #endif
 
     for (i = 1; i < aCount; i++)
     {
-        if (*(aArray + i - 1) > *(aArray + i)) return -1;
+        if ((*aCmpCb)(aArray + (i - 1) * aWidth, aArray + i * aWidth) > 0) return -1;
     }
 
     return 0;
 }
 
 /*
- * -----------------------------------------------------------------------------
- *  Compare function to deliver to sorting functions
- * -----------------------------------------------------------------------------
+ * gcc -O2 only vectorizes loops that need no scalar remainder
  */
-static int32_t compareFunc(const void *aElem1, const void *aElem2)
+#if defined(__GNUC__) && !defined(__clang__)
+#define PERF_VECTORIZE  __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#else
+#define PERF_VECTORIZE
+#endif
+
+/*
+ * Returns 1 if the (aKey[i], aIndex[i]) pairs are strictly ascending.
+ * No branch per element, so that the compiler turns it into vector compares.
+ * Kept as two uint32_t arrays : 64 bit compares do not vectorize before SSE4.2.
+ */
+static PERF_VECTORIZE int32_t perfIsAscending(const uint32_t *aKey, const uint32_t *aIndex, uint32_t aCount)
 {
-    if (*(uint32_t *)aElem1 > *(uint32_t *)aElem2)
-    {
-        return 1;
-    }
-    else if (*(uint32_t *)aElem1 < *(uint32_t *)aElem2)
-    {
-        return -1;
-    }
-    else
+    uint32_t sBad = 0;
+    uint32_t i;
+
+    for (i = 1; i < aCount; i++)
     {
-        return 0;
+        sBad |= (aKey[i - 1] > aKey[i]) | ((aKey[i - 1] == aKey[i]) & (aIndex[i - 1] >= aIndex[i]));
     }
+
+    return sBad == 0 ? 1 : 0;
 }
 
 /*
- * -----------------------------------------------------------------------------
- *  Allocating And Filling Array
- * -----------------------------------------------------------------------------
+ * With -V every element carries its original index at mIndexOffset (see buildElements()).
+ * Element i of the sorted array must be a copy of the source element at its index,
+ * key and payload intact, and the elements must be in ascending (key, index) order :
+ * every comparator orders as the uint32_t key does, and equal keys keep their original order.
+ * Strictly ascending pairs with every index below the count also make the indices
+ * a permutation, since an index seen twice would be the same pair twice.
+ *
+ * The pairs are gathered a block at a time for perfIsAscending().
+ * Returns NULL if the array is correct, or what is wrong with it.
  */
-static int32_t getCountFromFile(FILE *aFileHandle)
+static const char *verifyArrayIsStable(perfContext *aContext, const uint8_t *aArray, size_t aWidth)
 {
-    int32_t  sCount = 0;
-    char     sFirstLine[1024] = {0,};
+    uint32_t       sKey[PERF_VERIFY_BLOCK_CNT + 1];     /* [0] : last pair of the previous block */
+    uint32_t       sOrigin[PERF_VERIFY_BLOCK_CNT + 1];
+    uint32_t       sCount = (uint32_t)aContext->mCount;
+    uint32_t       sBlockCnt;
+    uint32_t       sIndex;
+    const uint8_t *sElem;
+    uint32_t       i;
+    uint32_t       j;
 
-    if (fgets(sFirstLine, sizeof(sFirstLine), aFileHandle) == NULL)
+    for (i = 0; i < sCount; i += sBlockCnt)
     {
-        if (ferror(aFileHandle) != 0)
-        {
-            /* error */
-            (void)fprintf(stderr, "error : reading file.\n");
-            clearerr(aFileHandle);
-            exit(1);
-        }
-        else
+        sBlockCnt = sCount - i < PERF_VERIFY_BLOCK_CNT ? sCount - i : PERF_VERIFY_BLOCK_CNT;
+
+        for (j = 0; j < sBlockCnt; j++)
         {
-            if (feof(aFileHandle) != 0)
+            sElem = aArray + (size_t)(i + j) * aWidth;
+
+            memcpy(&sIndex, sElem + aContext->mIndexOffset, sizeof(uint32_t));
+
+            if (sIndex >= sCount) return "index out of range";
+
+            if (memcmp(sElem, aContext->mSourceArray + (size_t)sIndex * aWidth, aWidth) != 0)
             {
-                /* eof */
-                (void)fprintf(stderr, "%s\n", sFirstLine);
-                (void)fprintf(stderr, "eof\n");
-                exit(1);
+                return "element corrupted";
             }
             else
             {
-                abort();
             }
-        }
-    }
-
-    if (sFirstLine[0] != '#')
-    {
-        (void)fprintf(stderr, "error : invalid file format.\n");
-        exit(1);
-    }
-    else
-    {
-        char    *sEndPtr = NULL;
 
-        sCount = strtol(sFirstLine + 1, &sEndPtr, 10);
-
-        if (errno == ERANGE)
-        {
-            (void)fprintf(stderr, "error : the count is out of range.\n");
-            exit(1);
+            sKey[j + 1]    = aContext->mKeyArray[sIndex];
+            sOrigin[j + 1] = sIndex;
         }
-        else
+
+        if (perfIsAscending(i == 0 ? sKey + 1 : sKey,
+                            i == 0 ? sOrigin + 1 : sOrigin,
+                            i == 0 ? sBlockCnt : sBlockCnt + 1) == 0)
         {
-            if (*sEndPtr != '\n')
+            for (j = i == 0 ? 2 : 1; sKey[j - 1] < sKey[j] || (sKey[j - 1] == sKey[j] && sOrigin[j - 1] < sOrigin[j]); j++)
             {
-                (void)fprintf(stderr, "error : invalid file format.\n");
-                (void)fprintf(stderr, "endptr : %c\n", *sEndPtr);
-                exit(1);
+            }
+
+            if (sKey[j - 1] > sKey[j])
+            {
+                return "keys out of order";
+            }
+            else if (sOrigin[j - 1] == sOrigin[j])
+            {
+                return "element duplicated";
             }
             else
             {
+                return "equal keys out of their original order";
             }
         }
+        else
+        {
+        }
+
+        sKey[0]    = sKey[sBlockCnt];
+        sOrigin[0] = sOrigin[sBlockCnt];
     }
 
-    return sCount;
+    return NULL;
 }
 
-static void createArray(perfContext *aContext)
+/*
+ * -----------------------------------------------------------------------------
+ *  Compare function to deliver to sorting functions
+ * -----------------------------------------------------------------------------
+ */
+static int32_t compareFunc(const void *aElem1, const void *aElem2)
 {
-    /*
-     * Note : It is ubsurd to allocate a linear memory of such a big size.
-     *        Operating system might swap out the memory if the system has not enough memory.
-     *        and it might undermine the credibility of this performance test.
-     */
-    aContext->mArrayToSort = malloc(aContext->mCount * sizeof(uint32_t));
-
-    if (aContext->mArrayToSort == NULL)
+    if (*(uint32_t *)aElem1 > *(uint32_t *)aElem2)
     {
-        (void)fprintf(stderr, "error : malloc fail\n");
-        exit(0);
+        return 1;
+    }
+    else if (*(uint32_t *)aElem1 < *(uint32_t *)aElem2)
+    {
+        return -1;
     }
     else
     {
+        return 0;
     }
 }
 
-static void destroyArray(uint32_t *sArray)
-{
-    free(sArray);
-}
+/*
+ * Key at gKeyOffset, for elements whose key does not start at the first byte.
+ */
+static size_t gKeyOffset = 0;
 
-static void fillArray(FILE *aFileHandle, perfContext *aContext)
+static int32_t compareKeyAtOffset(const void *aElem1, const void *aElem2)
 {
-    int32_t  i;
-    uint32_t sNumber;
+    uint32_t sKey1 = getKey(aElem1, gKeyOffset);
+    uint32_t sKey2 = getKey(aElem2, gKeyOffset);
 
-    for (i = 0; i < aContext->mCount; i++)
+    if (sKey1 > sKey2)
     {
-        if (fscanf(aFileHandle, "%u\n", &sNumber) == EOF)
-        {
-            (void)fprintf(stderr, "error : value count does not match\n");
-            exit(1);
-        }
-        else
-        {
-        }
-
-        aContext->mArrayToSort[i] = sNumber;
+        return 1;
+    }
+    else if (sKey1 < sKey2)
+    {
+        return -1;
+    }
+    else
+    {
+        return 0;
     }
 }
 
-static void createAndFillArray(perfContext *aContext)
+/*
+ * Multi-field record, ordered by mMajor, then mMiddle, then mMinor.
+ * Built from the key so that there are plenty of ties in the leading fields.
+ */
+typedef struct perfRecord
 {
-    FILE *sFileHandle      = NULL;
+    uint32_t mMajor;
+    uint32_t mMiddle;
+    uint32_t mMinor;
+} perfRecord;
 
-    sFileHandle = fopen(aContext->mFileName, "r");
+static int32_t compareRecord(const void *aElem1, const void *aElem2)
+{
+    perfRecord sRecord1;
+    perfRecord sRecord2;
 
-    if (sFileHandle == NULL)
+    memcpy(&sRecord1, (const uint8_t *)aElem1 + gKeyOffset, sizeof(perfRecord));
+    memcpy(&sRecord2, (const uint8_t *)aElem2 + gKeyOffset, sizeof(perfRecord));
+
+    if (sRecord1.mMajor != sRecord2.mMajor)
     {
-        if (errno == ENOENT)
-        {
-            (void)fprintf(stderr, "File not found.\n");
-            exit(1);
-        }
-        else
-        {
-            (void)fprintf(stderr, "Unexpected error. %s (errno %d)\n", strerror(errno), errno);
-            exit(1);
-        }
+        return sRecord1.mMajor > sRecord2.mMajor ? 1 : -1;
     }
-    else
+    else if (sRecord1.mMiddle != sRecord2.mMiddle)
     {
+        return sRecord1.mMiddle > sRecord2.mMiddle ? 1 : -1;
     }
+    else if (sRecord1.mMinor != sRecord2.mMinor)
+    {
+        return sRecord1.mMinor > sRecord2.mMinor ? 1 : -1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+/*
+ * Element holds a pointer to a NUL terminated string.
+ */
+static int32_t compareString(const void *aElem1, const void *aElem2)
+{
+    const char *sString1;
+    const char *sString2;
+
+    memcpy(&sString1, (const uint8_t *)aElem1 + gKeyOffset, sizeof(char *));
+    memcpy(&sString2, (const uint8_t *)aElem2 + gKeyOffset, sizeof(char *));
+
+    return strcmp(sString1, sString2);
+}
+
+/*
+ * Key comparison made artificially expensive by busy waiting gSpinCycles cycles.
+ */
+static uint32_t gSpinCycles = PERF_DEFAULT_SPIN_CYCLES;
+
+static int32_t compareSpin(const void *aElem1, const void *aElem2)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t sStart = __rdtsc();
+
+    while (__rdtsc() - sStart < gSpinCycles)
+    {
+    }
+#else
+    volatile uint32_t i;
+
+    for (i = 0; i < gSpinCycles; i++)
+    {
+    }
+#endif
+
+    return compareKeyAtOffset(aElem1, aElem2);
+}
+
+/*
+ * Counts calls and forwards them to gCountedCompareFunc.
+ */
+static uint64_t gCompareCnt = 0;
+static int    (*gCountedCompareFunc)(const void *, const void *) = NULL;
+
+static int32_t compareCounting(const void *aElem1, const void *aElem2)
+{
+    gCompareCnt++;
+
+    return (*gCountedCompareFunc)(aElem1, aElem2);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Allocating And Filling Array
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Keys taken from a file of aFileCnt : the first -n, or all of them. One sort
+ * takes at most INT32_MAX elements, the first ones of a larger file are taken.
+ */
+static int32_t perfFileKeyCnt(perfContext *aContext, uint64_t aFileCnt)
+{
+    if (aContext->mGenCount >= 0)
+    {
+        if ((uint64_t)aContext->mGenCount > aFileCnt)
+        {
+            (void)fprintf(stderr, "error : '%s' has %llu keys, fewer than -n.\n",
+                          aContext->mFileName, (unsigned long long)aFileCnt);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        return aContext->mGenCount;
+    }
+    else if (aFileCnt > INT32_MAX)
+    {
+        (void)fprintf(stderr, "warning : '%s' has %llu keys, a sort takes at most %d. "
+                              "Taking the first ones, -n sets how many.\n",
+                      aContext->mFileName, (unsigned long long)aFileCnt, INT32_MAX);
+
+        return INT32_MAX;
+    }
+    else
+    {
+        return (int32_t)aFileCnt;
+    }
+}
+
+/*
+ * The first line is
+ *
+ *      #<count>
+ *  or
+ *      #<count> <width> <key offset>
+ *
+ * The latter tells the element layout the data was generated for (gendata -w, -k).
+ * It is used unless overridden by -W, -K.
+ */
+static void getHeaderFromFile(FILE *aFileHandle, perfContext *aContext)
+{
+    long long  sCount = 0;
+    char       sFirstLine[1024] = {0,};
+
+    if (fgets(sFirstLine, sizeof(sFirstLine), aFileHandle) == NULL)
+    {
+        if (ferror(aFileHandle) != 0)
+        {
+            /* error */
+            (void)fprintf(stderr, "error : reading file.\n");
+            clearerr(aFileHandle);
+            exit(1);
+        }
+        else
+        {
+            if (feof(aFileHandle) != 0)
+            {
+                /* eof */
+                (void)fprintf(stderr, "%s\n", sFirstLine);
+                (void)fprintf(stderr, "eof\n");
+                exit(1);
+            }
+            else
+            {
+                abort();
+            }
+        }
+    }
+
+    if (sFirstLine[0] != '#')
+    {
+        (void)fprintf(stderr, "error : invalid file format.\n");
+        exit(1);
+    }
+    else
+    {
+        char    *sEndPtr = NULL;
+
+        errno  = 0;
+        sCount = strtoll(sFirstLine + 1, &sEndPtr, 10);
+
+        if (errno == ERANGE || sCount < 0)
+        {
+            (void)fprintf(stderr, "error : the count is out of range.\n");
+            exit(1);
+        }
+        else
+        {
+            if (*sEndPtr == ' ')
+            {
+                long sWidth;
+                long sKeyOffset;
+
+                sWidth     = strtol(sEndPtr, &sEndPtr, 10);
+                sKeyOffset = strtol(sEndPtr, &sEndPtr, 10);
+
+                if (aContext->mWidthCnt == 0 && sWidth > 0)
+                {
+                    aContext->mWidth[0] = sWidth;
+                    aContext->mWidthCnt = 1;
+                }
+                else
+                {
+                }
+
+                if (aContext->mKeyOffset < 0 && sKeyOffset >= 0)
+                {
+                    aContext->mKeyOffset = sKeyOffset;
+                }
+                else
+                {
+                }
+            }
+            else
+            {
+            }
+
+            if (*sEndPtr != '\n')
+            {
+                (void)fprintf(stderr, "error : invalid file format.\n");
+                (void)fprintf(stderr, "endptr : %c\n", *sEndPtr);
+                exit(1);
+            }
+            else
+            {
+            }
+        }
+    }
+
+    aContext->mCount = perfFileKeyCnt(aContext, (uint64_t)sCount);
+}
+
+static void *createArray(size_t aSize)
+{
+    void *sArray;
+
+    /*
+     * Note : It is ubsurd to allocate a linear memory of such a big size.
+     *        Operating system might swap out the memory if the system has not enough memory.
+     *        and it might undermine the credibility of this performance test.
+     */
+    sArray = malloc(aSize);
+
+    if (sArray == NULL)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return sArray;
+}
+
+static void destroyArray(void *sArray)
+{
+    free(sArray);
+}
+
+static void fillArray(FILE *aFileHandle, perfContext *aContext)
+{
+    int32_t  i;
+    uint32_t sNumber;
+
+    for (i = 0; i < aContext->mCount; i++)
+    {
+        if (fscanf(aFileHandle, "%u\n", &sNumber) == EOF)
+        {
+            (void)fprintf(stderr, "error : value count does not match\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aContext->mKeyArray[i] = sNumber;
+    }
+}
+
+/*
+ * Binary dataset (gendata -o binary) : the keys are copied straight out of the mapped file.
+ * Width and key offset in the header are used unless overridden by -W, -K, as with text files.
+ */
+static void loadBinaryArray(perfContext *aContext)
+{
+    datasetMap  sMap;
+    const char *sError;
+
+    if (datasetMapFile(aContext->mFileName, &sMap) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot map '%s'. %s (errno %d)\n",
+                      aContext->mFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    sError = datasetCheckHeader(sMap.mHeader, sMap.mSize);
+
+    if (sError != NULL)
+    {
+        (void)fprintf(stderr, "error : '%s' : %s.\n", aContext->mFileName, sError);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    aContext->mCount = perfFileKeyCnt(aContext, sMap.mHeader->mCount);
+
+    if (aContext->mWidthCnt == 0 && sMap.mHeader->mWidth > 0)
+    {
+        aContext->mWidth[0] = sMap.mHeader->mWidth;
+        aContext->mWidthCnt = 1;
+
+        if (aContext->mKeyOffset < 0) aContext->mKeyOffset = sMap.mHeader->mKeyOffset;
+    }
+    else
+    {
+    }
+
+    aContext->mKeyArray = createArray(aContext->mCount * PERF_KEY_SIZE);
+
+    memcpy(aContext->mKeyArray, sMap.mKey, aContext->mCount * PERF_KEY_SIZE);
+
+    datasetUnmapFile(&sMap);
+}
+
+static void createAndFillArray(perfContext *aContext)
+{
+    FILE   *sFileHandle = NULL;
+    char    sMagic[DATASET_MAGIC_LEN];
+    size_t  sMagicLen;
+
+    sFileHandle = fopen(aContext->mFileName, "r");
+
+    if (sFileHandle == NULL)
+    {
+        if (errno == ENOENT)
+        {
+            (void)fprintf(stderr, "File not found.\n");
+            exit(1);
+        }
+        else
+        {
+            (void)fprintf(stderr, "Unexpected error. %s (errno %d)\n", strerror(errno), errno);
+            exit(1);
+        }
+    }
+    else
+    {
+    }
+
+    sMagicLen = fread(sMagic, 1, sizeof(sMagic), sFileHandle);
+
+    if (datasetHasMagic(sMagic, sMagicLen) == 1)
+    {
+        (void)fclose(sFileHandle);
+
+        loadBinaryArray(aContext);
+        return;
+    }
+    else
+    {
+        rewind(sFileHandle);
+    }
+
+    getHeaderFromFile(sFileHandle, aContext);
+
+    aContext->mKeyArray = createArray(aContext->mCount * PERF_KEY_SIZE);
+
+    fillArray(sFileHandle, aContext);
+
+    (void)fclose(sFileHandle);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Generating Keys And Choosing Sizes
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Parameter of the pattern for aCount elements, picked the way gendata picks it
+ */
+static uint32_t perfPatternParam(const perfPatternUse *aPattern, int32_t aCount)
+{
+    uint32_t sDefault;
+    uint32_t sMin;
+    uint32_t sParam;
+
+    (void)patternTakesParam(aPattern->mPattern, aCount, &sDefault, &sMin);
+
+    sParam = aPattern->mParam >= 0 ? (uint32_t)aPattern->mParam : sDefault;
+
+    /* the tail cannot be longer than the data */
+    if (aPattern->mPattern == PATTERN_SORTED_TAIL && sParam > (uint32_t)aCount)
+    {
+        sParam = aCount;
+    }
+    else
+    {
+    }
+
+    return sParam;
+}
+
+/*
+ * Makes mKeyArray hold the aCount keys to sort.
+ * A file (aPattern NULL) provides its first aCount keys as they are. A pattern is generated
+ * for exactly aCount elements, since its shape (run lengths, tail, ...) depends on the count.
+ */
+static void perfPrepareKeys(perfContext *aContext, const perfPatternUse *aPattern, int32_t aCount)
+{
+    patternGen sGen;
+
+    aContext->mCount = aCount;
+
+    if (aPattern == NULL)
+    {
+        aContext->mInput = aContext->mFileName;
+        return;
+    }
+    else
+    {
+        aContext->mInput = aPattern->mName;
+    }
+
+    if (patternInit(&sGen,
+                    aPattern->mPattern,
+                    aCount,
+                    perfPatternParam(aPattern, aCount),
+                    aContext->mSeed) != 0)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    patternFill(&sGen, 0, aCount, aContext->mKeyArray);
+
+    patternDestroy(&sGen);
+}
+
+/*
+ * Bytes perf needs per element at most : the key, the element and its sorted copy,
+ * as much again for the temporary array of a merge sort, and the string the element points to.
+ */
+static double perfBytesPerElem(perfContext *aContext)
+{
+    size_t   sMaxWidth  = 0;
+    size_t   sMaxString = 0;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < aContext->mComparatorCnt; i++)
+    {
+        const perfComparator *sComparator = aContext->mComparator[i].mComparator;
+
+        for (j = 0; j < aContext->mWidthCnt; j++)
+        {
+            size_t sWidth = aContext->mWidth[j];
+
+            if (sWidth == 0) sWidth = aContext->mKeyOffset + sComparator->mKeySize;
+            if (sWidth > sMaxWidth) sMaxWidth = sWidth;
+        }
+
+        if (sComparator->mStringLen + 1 > sMaxString) sMaxString = sComparator->mStringLen + 1;
+    }
+
+    return PERF_KEY_SIZE + 3.0 * sMaxWidth + sMaxString;
+}
+
+/*
+ * Largest exponent of 2 whose arrays fit in half of the physical memory,
+ * so that a sweep stops before the measurement turns into one of the swap device.
+ */
+static int32_t perfMaxSweepExp(perfContext *aContext)
+{
+    long    sPageCnt  = sysconf(_SC_PHYS_PAGES);
+    long    sPageSize = sysconf(_SC_PAGESIZE);
+    double  sBudget;
+    int32_t sExp      = PERF_SWEEP_MAX_EXP;
+
+    if (sPageCnt <= 0 || sPageSize <= 0)
+    {
+        (void)fprintf(stderr, "error : cannot tell the size of the memory. Give the sweep as LOW:HIGH.\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    sBudget = (double)sPageCnt * sPageSize / 2;
+
+    while (sExp > aContext->mSweepLow && ldexp(perfBytesPerElem(aContext), sExp) > sBudget)
+    {
+        sExp--;
+    }
+
+    return sExp;
+}
+
+/*
+ * Fills mSize : the whole input, or the powers of 2 of the sweep.
+ * A sweep over a file stops at the largest size the file has keys for.
+ */
+static void perfChooseSizes(perfContext *aContext)
+{
+    int32_t sHigh;
+    int32_t i;
+
+    if (aContext->mSweepLow < 0)
+    {
+        aContext->mSize[0] = aContext->mPatternCnt > 0 ? aContext->mGenCount : aContext->mKeyCnt;
+        aContext->mSizeCnt = 1;
+        return;
+    }
+    else
+    {
+    }
+
+    sHigh = aContext->mSweepHigh > 0 ? aContext->mSweepHigh : perfMaxSweepExp(aContext);
+
+    for (i = aContext->mSweepLow; i <= sHigh; i++)
+    {
+        if (aContext->mPatternCnt == 0 && ((int64_t)1 << i) > aContext->mKeyCnt)
+        {
+            (void)fprintf(stderr, "Sizes above %d skipped, the file has no more keys.\n", aContext->mKeyCnt);
+            break;
+        }
+        else
+        {
+        }
+
+        aContext->mSize[aContext->mSizeCnt] = (int32_t)1 << i;
+        aContext->mSizeCnt++;
+    }
+
+    if (aContext->mSizeCnt == 0)
+    {
+        (void)fprintf(stderr, "error : the input has fewer than 2^%d keys.\n", aContext->mSweepLow);
+        exit(1);
+    }
+    else
+    {
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Building Elements For Each Comparator
+ * -----------------------------------------------------------------------------
+ */
+#define PERF_STRING_DIGIT_CNT   10      /* "%010u" */
+
+static void buildKeyInteger(perfContext *aContext, uint8_t *aElem, int32_t aIndex)
+{
+    memcpy(aElem + aContext->mKeyOffset, &aContext->mKeyArray[aIndex], PERF_KEY_SIZE);
+}
+
+static void buildKeyRecord(perfContext *aContext, uint8_t *aElem, int32_t aIndex)
+{
+    uint32_t   sKey = aContext->mKeyArray[aIndex];
+    perfRecord sRecord;
+
+    sRecord.mMajor  = sKey >> 24;
+    sRecord.mMiddle = (sKey >> 12) & 0xfff;
+    sRecord.mMinor  = sKey & 0xfff;
+
+    memcpy(aElem + aContext->mKeyOffset, &sRecord, sizeof(perfRecord));
+}
+
+/*
+ * The string is the zero padded decimal key, after a prefix shared by all strings,
+ * so that lexicographic order is the key order and longer strings take longer to compare.
+ */
+static void buildKeyString(perfContext *aContext, uint8_t *aElem, int32_t aIndex)
+{
+    size_t  sStringLen = aContext->mStringLen;
+    size_t  sPrefixLen = sStringLen - PERF_STRING_DIGIT_CNT;
+    char   *sString    = aContext->mStringPool + aIndex * (sStringLen + 1);
+
+    memset(sString, 'x', sPrefixLen);
+    (void)snprintf(sString + sPrefixLen, PERF_STRING_DIGIT_CNT + 1, "%010u", aContext->mKeyArray[aIndex]);
+
+    memcpy(aElem + aContext->mKeyOffset, &sString, sizeof(char *));
+}
+
+static const perfComparator gComparator[] =
+{
+    { "int",    "uint32_t key",
+      PERF_KEY_SIZE,      0,  buildKeyInteger, compareKeyAtOffset },
+    { "struct", "3 field record compared field by field",
+      sizeof(perfRecord), 0,  buildKeyRecord,  compareRecord      },
+    { "str",    "strcmp() on 10 byte strings",
+      sizeof(char *),     PERF_STRING_DIGIT_CNT,      buildKeyString, compareString },
+    { "lstr",   "strcmp() on 74 byte strings sharing a 64 byte prefix",
+      sizeof(char *),     PERF_STRING_DIGIT_CNT + 64, buildKeyString, compareString },
+    { "spin",   "uint32_t key after busy waiting K cycles (spin:K, default 100)",
+      PERF_KEY_SIZE,      0,  buildKeyInteger, compareSpin        },
+    { NULL,     NULL, 0, 0, NULL, NULL }
+};
+
+/*
+ * Builds aWidth byte elements out of the keys for the comparator.
+ * The key goes to mKeyOffset and the other bytes get a payload derived from
+ * the original index so that they are not trivially compressible.
+ * With -V the original index itself is stored right after the key,
+ * or in front of it if there is no room after.
+ */
+static void buildElements(perfContext *aContext, size_t aWidth, const perfComparatorUse *aComparator)
+{
+    const perfComparator *sComparator = aComparator->mComparator;
+    int32_t               i;
+    size_t                j;
+    uint8_t              *sElem;
+
+    destroyArray(aContext->mSourceArray);
+    destroyArray(aContext->mArrayToSort);
+    destroyArray(aContext->mStringPool);
+
+    aContext->mSourceArray = createArray(aContext->mCount * aWidth);
+    aContext->mArrayToSort = createArray(aContext->mCount * aWidth * aContext->mBatchCnt);
+    aContext->mStringPool  = NULL;
+    aContext->mStringLen   = sComparator->mStringLen;
+
+    if (sComparator->mStringLen > 0)
+    {
+        aContext->mStringPool = createArray(aContext->mCount * (sComparator->mStringLen + 1));
+    }
+    else
+    {
+    }
+
+    aContext->mIndexOffset = -1;
+
+    if (aContext->mDoVerify == PERF_VERIFY_STABLE)
+    {
+        if (aContext->mKeyOffset + sComparator->mKeySize + sizeof(uint32_t) <= aWidth)
+        {
+            aContext->mIndexOffset = aContext->mKeyOffset + sComparator->mKeySize;
+        }
+        else if (aContext->mKeyOffset >= (int32_t)sizeof(uint32_t))
+        {
+            aContext->mIndexOffset = 0;
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < aContext->mCount; i++)
+    {
+        sElem = aContext->mSourceArray + i * aWidth;
+
+        for (j = 0; j < aWidth; j++)
+        {
+            sElem[j] = (uint8_t)(i * 31 + j);
+        }
+
+        (*sComparator->mBuildKey)(aContext, sElem, i);
+
+        if (aContext->mIndexOffset >= 0)
+        {
+            memcpy(sElem + aContext->mIndexOffset, &i, sizeof(uint32_t));
+        }
+        else
+        {
+        }
+    }
+
+    gKeyOffset  = aContext->mKeyOffset;
+    gSpinCycles = aComparator->mSpinCycles;
+
+    /*
+     * Elements whose key is at the front are compared the same way as before
+     * widths were configurable, so width 4 numbers stay comparable with old runs.
+     */
+    if (sComparator->mCompareFunc == compareKeyAtOffset && aContext->mKeyOffset == 0)
+    {
+        aContext->mCompareFunc = compareFunc;
+    }
+    else
+    {
+        aContext->mCompareFunc = sComparator->mCompareFunc;
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Timing And Statistics
+ * -----------------------------------------------------------------------------
+ */
+static double perfNowNsec(void)
+{
+    struct timespec sNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+static int perfCompareDouble(const void *aElem1, const void *aElem2)
+{
+    double sValue1 = *(const double *)aElem1;
+    double sValue2 = *(const double *)aElem2;
+
+    return (sValue1 > sValue2) - (sValue1 < sValue2);
+}
+
+/*
+ * Nearest-rank percentile of an ascending array. aPercent : 0 .. 100
+ */
+static double perfPercentile(const double *aSorted, int32_t aCount, double aPercent)
+{
+    int32_t sRank;
+
+    sRank = (int32_t)ceil(aPercent / 100.0 * aCount);
+
+    if (sRank < 1)      sRank = 1;
+    if (sRank > aCount) sRank = aCount;
+
+    return aSorted[sRank - 1];
+}
+
+static double perfMedianOf(const double *aSample, int32_t aCount)
+{
+    double *sSorted;
+    double  sMedian;
+
+    sSorted = malloc(aCount * sizeof(double));
+    assert(sSorted != NULL);
+
+    memcpy(sSorted, aSample, aCount * sizeof(double));
+    qsort(sSorted, aCount, sizeof(double), perfCompareDouble);
+
+    if ((aCount & 1) == 1)
+    {
+        sMedian = sSorted[aCount / 2];
+    }
+    else
+    {
+        sMedian = (sSorted[aCount / 2 - 1] + sSorted[aCount / 2]) / 2;
+    }
+
+    free(sSorted);
+
+    return sMedian;
+}
+
+static void perfComputeResult(perfResult *aResult, int32_t aRepeatCnt, int32_t aElementCnt)
+{
+    double  *sSorted;
+    double   sSum = 0;
+    double   sSquareSum = 0;
+    int32_t  i;
+
+    sSorted = malloc(aRepeatCnt * sizeof(double));
+    assert(sSorted != NULL);
+
+    memcpy(sSorted, aResult->mSample, aRepeatCnt * sizeof(double));
+    qsort(sSorted, aRepeatCnt, sizeof(double), perfCompareDouble);
+
+    for (i = 0; i < aRepeatCnt; i++)
+    {
+        sSum += sSorted[i];
+    }
+
+    aResult->mMean = sSum / aRepeatCnt;
+
+    for (i = 0; i < aRepeatCnt; i++)
+    {
+        sSquareSum += (sSorted[i] - aResult->mMean) * (sSorted[i] - aResult->mMean);
+    }
+
+    /* sample standard deviation */
+    aResult->mStdDev = aRepeatCnt > 1 ? sqrt(sSquareSum / (aRepeatCnt - 1)) : 0;
+
+    aResult->mMin = sSorted[0];
+
+    if ((aRepeatCnt & 1) == 1)
+    {
+        aResult->mMedian = sSorted[aRepeatCnt / 2];
+    }
+    else
+    {
+        aResult->mMedian = (sSorted[aRepeatCnt / 2 - 1] + sSorted[aRepeatCnt / 2]) / 2;
+    }
+
+    aResult->mP90 = perfPercentile(sSorted, aRepeatCnt, 90);
+
+    aResult->mElemPerSec = aResult->mMedian > 0 ? aElementCnt / (aResult->mMedian / 1e9) : 0;
+
+    free(sSorted);
+}
+
+/*
+ * Median of each event over the repetitions, -1 for those not counted
+ */
+static void perfComputeEvents(perfResult *aResult, int32_t aRepeatCnt)
+{
+    double   *sValue;
+    uint32_t  i;
+    int32_t   j;
+
+    sValue = malloc(aRepeatCnt * sizeof(double));
+    assert(sValue != NULL);
+
+    for (i = 0; i < PERF_EVENT_MAX; i++)
+    {
+        for (j = 0; j < aRepeatCnt; j++)
+        {
+            sValue[j] = aResult->mEventSample[j * PERF_EVENT_MAX + i];
+        }
+
+        aResult->mEvent[i] = sValue[0] >= 0 ? perfMedianOf(sValue, aRepeatCnt) : -1;
+    }
+
+    free(sValue);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Pinning To A CPU
+ * -----------------------------------------------------------------------------
+ */
+static void perfPinToCpu(int32_t aCpu)
+{
+    cpu_set_t sCpuSet;
+
+    CPU_ZERO(&sCpuSet);
+    CPU_SET(aCpu, &sCpuSet);
+
+    if (sched_setaffinity(0, sizeof(sCpuSet), &sCpuSet) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot pin to cpu %d. %s (errno %d)\n",
+                      aCpu, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Hardware Event Counters
+ * -----------------------------------------------------------------------------
+ */
+static const struct
+{
+    const char *mName;
+    uint32_t    mType;
+    uint64_t    mConfig;
+} gEvent[PERF_EVENT_MAX] =
+{
+    { "instructions",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS  },
+    { "cache-misses",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES  },
+    { "branch-misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "dtlb-load-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+};
+
+/*
+ * Opens the events as one group led by the instructions, so that they are
+ * scheduled together. Only user space is counted : the kernel's share (page faults,
+ * timer interrupts) is what varies from run to run on a busy machine, and
+ * perf_event_paranoid 2, the usual default, allows no more anyway.
+ * Instructions are required, the others are reported as n/a if the cpu lacks them.
+ */
+static void perfOpenEvents(perfContext *aContext)
+{
+    struct perf_event_attr sAttr;
+    uint32_t               i;
+
+    for (i = 0; i < PERF_EVENT_MAX; i++)
+    {
+        memset(&sAttr, 0, sizeof(sAttr));
+
+        sAttr.size           = sizeof(sAttr);
+        sAttr.type           = gEvent[i].mType;
+        sAttr.config         = gEvent[i].mConfig;
+        sAttr.disabled       = i == PERF_EVENT_INSTRUCTIONS ? 1 : 0;
+        sAttr.exclude_kernel = 1;
+        sAttr.exclude_hv     = 1;
+
+        aContext->mEventFd[i] = syscall(SYS_perf_event_open, &sAttr, 0, -1,
+                                        i == PERF_EVENT_INSTRUCTIONS ? -1 : aContext->mEventFd[0], 0);
+
+        if (aContext->mEventFd[i] < 0 && i == PERF_EVENT_INSTRUCTIONS)
+        {
+            (void)fprintf(stderr, "error : cannot count instructions. %s (errno %d)\n"
+                                  "        Needs a cpu with performance counters and perf_event_paranoid <= 2.\n"
+                                  "        'make callgrind' counts them in a simulator instead.\n",
+                          strerror(errno), errno);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+}
+
+static void perfCloseEvents(perfContext *aContext)
+{
+    uint32_t i;
+
+    for (i = 0; i < PERF_EVENT_MAX; i++)
+    {
+        if (aContext->mEventFd[i] >= 0) (void)close(aContext->mEventFd[i]);
+    }
+}
+
+static void perfStartEvents(perfContext *aContext)
+{
+    (void)ioctl(aContext->mEventFd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    (void)ioctl(aContext->mEventFd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/*
+ * aEvent : PERF_EVENT_MAX counts, -1 for the events not available
+ */
+static void perfStopEvents(perfContext *aContext, double *aEvent)
+{
+    uint64_t sValue;
+    uint32_t i;
+
+    (void)ioctl(aContext->mEventFd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (i = 0; i < PERF_EVENT_MAX; i++)
+    {
+        if (aContext->mEventFd[i] >= 0 && read(aContext->mEventFd[i], &sValue, sizeof(sValue)) == sizeof(sValue))
+        {
+            aEvent[i] = (double)sValue;
+        }
+        else
+        {
+            aEvent[i] = -1;
+        }
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Memory Accounting
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * malloc(), calloc(), realloc() and free() are replaced for the whole process,
+ * libc's qsort() included, and forwarded to glibc's own. While gAlloc.mTracking is 1
+ * they count calls and follow the bytes in use, as malloc_usable_size() sees them,
+ * to find their peak. Aligned allocations (posix_memalign() and the like) are not seen.
+ * Only the counting run is tracked, which is single threaded.
+ * Other C libraries have no __libc_malloc(), there nothing is counted.
+ */
+typedef struct perfAllocStat
+{
+    int32_t   mTracking;
+    int64_t   mMallocCnt;
+    int64_t   mFreeCnt;
+    int64_t   mAllocBytes;
+    int64_t   mInUse;       /* bytes allocated minus bytes freed since tracking started */
+    int64_t   mPeak;        /* highest mInUse */
+} perfAllocStat;
+
+static perfAllocStat gAlloc;
+
+#ifdef __GLIBC__
+#define PERF_ALLOC_TRACKED      1
+
+extern void *__libc_malloc(size_t aSize);
+extern void *__libc_calloc(size_t aCount, size_t aSize);
+extern void *__libc_realloc(void *aPtr, size_t aSize);
+extern void  __libc_free(void *aPtr);
+
+static void perfAllocAdd(void *aPtr, size_t aSize)
+{
+    if (aPtr == NULL) return;
+
+    gAlloc.mMallocCnt++;
+    gAlloc.mAllocBytes += aSize;
+    gAlloc.mInUse      += malloc_usable_size(aPtr);
+
+    if (gAlloc.mInUse > gAlloc.mPeak) gAlloc.mPeak = gAlloc.mInUse;
+}
+
+void *malloc(size_t aSize)
+{
+    void *sPtr = __libc_malloc(aSize);
+
+    if (gAlloc.mTracking == 1) perfAllocAdd(sPtr, aSize);
+
+    return sPtr;
+}
+
+void *calloc(size_t aCount, size_t aSize)
+{
+    void *sPtr = __libc_calloc(aCount, aSize);
+
+    if (gAlloc.mTracking == 1) perfAllocAdd(sPtr, aCount * aSize);
+
+    return sPtr;
+}
+
+void *realloc(void *aPtr, size_t aSize)
+{
+    size_t  sOldSize = 0;
+    void   *sPtr;
+
+    /* the old block may be gone afterwards */
+    if (gAlloc.mTracking == 1 && aPtr != NULL) sOldSize = malloc_usable_size(aPtr);
+
+    sPtr = __libc_realloc(aPtr, aSize);
+
+    if (gAlloc.mTracking == 1 && (sPtr != NULL || aSize == 0))
+    {
+        /* as a free() of the old block and a malloc() of the new one */
+        if (aPtr != NULL)
+        {
+            gAlloc.mFreeCnt++;
+            gAlloc.mInUse -= sOldSize;
+        }
+        else
+        {
+        }
+
+        perfAllocAdd(sPtr, aSize);
+    }
+    else
+    {
+    }
+
+    return sPtr;
+}
+
+void free(void *aPtr)
+{
+    if (gAlloc.mTracking == 1 && aPtr != NULL)
+    {
+        gAlloc.mFreeCnt++;
+        gAlloc.mInUse -= malloc_usable_size(aPtr);
+    }
+    else
+    {
+    }
+
+    __libc_free(aPtr);
+}
+#else
+#define PERF_ALLOC_TRACKED      0
+#endif
+
+/*
+ * A field of /proc/self/status in bytes, e.g. "VmRSS:", -1 if not found
+ */
+static int64_t perfReadStatus(const char *aField)
+{
+    char     sLine[256];
+    int64_t  sValue = -1;
+    size_t   sLen   = strlen(aField);
+    FILE    *sFileHandle;
+
+    sFileHandle = fopen("/proc/self/status", "r");
+
+    if (sFileHandle == NULL) return -1;
+
+    while (fgets(sLine, sizeof(sLine), sFileHandle) != NULL)
+    {
+        if (strncmp(sLine, aField, sLen) == 0)
+        {
+            sValue = strtoll(sLine + sLen, NULL, 10) * 1024;
+            break;
+        }
+        else
+        {
+        }
+    }
+
+    (void)fclose(sFileHandle);
+
+    return sValue;
+}
+
+/*
+ * Resets the peak resident size (VmHWM) to the current one. Linux 4.0 or later
+ */
+static int32_t perfResetPeakRss(void)
+{
+    int sFd = open("/proc/self/clear_refs", O_WRONLY);
+    int sDone;
+
+    if (sFd < 0) return -1;
+
+    sDone = write(sFd, "5", 1) == 1 ? 0 : -1;
+    (void)close(sFd);
+
+    return sDone;
+}
+
+static int64_t gRssBefore = -1;
+
+/*
+ * Brackets a sort, after its input has been copied in
+ */
+static void perfMemoryStart(void)
+{
+    gRssBefore = perfResetPeakRss() == 0 ? perfReadStatus("VmRSS:") : -1;
+
+    memset(&gAlloc, 0, sizeof(gAlloc));
+    gAlloc.mTracking = PERF_ALLOC_TRACKED;
+}
+
+static void perfMemoryStop(perfResult *aResult)
+{
+    int64_t sRssPeak;
+
+    gAlloc.mTracking = 0;
+
+    if (PERF_ALLOC_TRACKED == 1)
+    {
+        aResult->mMallocCnt  = gAlloc.mMallocCnt;
+        aResult->mFreeCnt    = gAlloc.mFreeCnt;
+        aResult->mAllocBytes = gAlloc.mAllocBytes;
+        aResult->mHeapPeak   = gAlloc.mPeak;
+    }
+    else
+    {
+        aResult->mMallocCnt  = -1;
+        aResult->mFreeCnt    = -1;
+        aResult->mAllocBytes = -1;
+        aResult->mHeapPeak   = -1;
+    }
+
+    sRssPeak = gRssBefore >= 0 ? perfReadStatus("VmHWM:") : -1;
+
+    aResult->mRssPeak = sRssPeak >= 0 ? sRssPeak - gRssBefore : -1;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Running Benchmark
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * The measured part of a run.
+ * Kept out of line so that 'make callgrind' can collect exactly this (--toggle-collect).
+ */
+static __attribute__((noinline)) void perfSortCopies(perfContext         *aContext,
+                                                     const perfAlgorithm *aAlgorithm,
+                                                     size_t               aWidth)
+{
+    size_t  sSize = aContext->mCount * aWidth;
+    int32_t i;
+
+    for (i = 0; i < aContext->mBatchCnt; i++)
+    {
+        (*aAlgorithm->mSortFunc)(aContext->mArrayToSort + i * sSize,
+                                 aContext->mCount,
+                                 aWidth,
+                                 aContext->mCompareFunc);
+    }
+}
+
+/*
+ * Sorts a fresh copy of the source array and returns elapsed time in nanoseconds.
+ * Copying is not included in the measurement.
+ *
+ * Sizes too small for the clock are sorted mBatchCnt times back to back,
+ * each in its own copy, and the time is that of one sort.
+ * With -I the events of one sort are stored to aEvent, unless it is NULL.
+ */
+static double perfRunOnce(perfContext *aContext, const perfAlgorithm *aAlgorithm, size_t aWidth, double *aEvent)
+{
+    size_t   sSize = aContext->mCount * aWidth;
+    double   sStart;
+    double   sEnd;
+    int32_t  i;
+    uint32_t j;
+
+    for (i = 0; i < aContext->mBatchCnt; i++)
+    {
+        memcpy(aContext->mArrayToSort + i * sSize, aContext->mSourceArray, sSize);
+    }
+
+    if (aEvent != NULL) perfStartEvents(aContext);
+
+    sStart = perfNowNsec();
+
+    perfSortCopies(aContext, aAlgorithm, aWidth);
+
+    sEnd   = perfNowNsec();
+
+    if (aEvent != NULL)
+    {
+        perfStopEvents(aContext, aEvent);
+
+        for (j = 0; j < PERF_EVENT_MAX; j++)
+        {
+            if (aEvent[j] >= 0) aEvent[j] /= aContext->mBatchCnt;
+        }
+    }
+    else
+    {
+    }
+
+    return (sEnd - sStart) / aContext->mBatchCnt;
+}
+
+/*
+ * Sorts a fresh copy once more, counting comparisons, allocations, memory and,
+ * where the algorithm can report them, moves, runs, merges and gallops.
+ * Kept out of the measured runs so that counting does not distort the timing.
+ */
+static void perfCountWork(perfContext *aContext, const perfAlgorithm *aAlgorithm, size_t aWidth, perfResult *aResult)
+{
+    memcpy(aContext->mArrayToSort, aContext->mSourceArray, aContext->mCount * aWidth);
+
+    gCompareCnt         = 0;
+    gCountedCompareFunc = aContext->mCompareFunc;
+
+    memset(&aResult->mStat, 0, sizeof(aResult->mStat));
+
+    perfMemoryStart();
+
+    if (aAlgorithm->mStatSortFunc != NULL)
+    {
+        (*aAlgorithm->mStatSortFunc)(aContext->mArrayToSort, aContext->mCount, aWidth, compareCounting,
+                                     &aResult->mStat);
+    }
+    else
+    {
+        (*aAlgorithm->mSortFunc)(aContext->mArrayToSort, aContext->mCount, aWidth, compareCounting);
+    }
+
+    perfMemoryStop(aResult);
+
+    aResult->mCompareCnt = gCompareCnt;
+}
+
+/*
+ * Verifies the outcome of the last run if option is set
+ */
+static void perfVerify(perfContext             *aContext,
+                       const perfAlgorithm     *aAlgorithm,
+                       size_t                   aWidth,
+                       const perfComparatorUse *aComparator)
+{
+    const char *sError;
+
+    if (aContext->mDoVerify == PERF_VERIFY_STABLE && aContext->mIndexOffset >= 0)
+    {
+        (void)fprintf(stderr, "%-12s %-6s %-9s w%-4zu n%-10d : checking order, stability and payload...... ",
+                      aContext->mInput, aAlgorithm->mName, aComparator->mName, aWidth, aContext->mCount);
+
+        sError = verifyArrayIsStable(aContext, aContext->mArrayToSort, aWidth);
+
+        if (sError == NULL)
+        {
+            (void)fprintf(stderr, "OK\n");
+        }
+        else
+        {
+            (void)fprintf(stderr, "FAIL (%s)\n", sError);
+        }
+    }
+    else if (aContext->mDoVerify != PERF_VERIFY_NONE)
+    {
+        (void)fprintf(stderr, "%-12s %-6s %-9s w%-4zu n%-10d : checking if resulting array is correctly sorted...... ",
+                      aContext->mInput, aAlgorithm->mName, aComparator->mName, aWidth, aContext->mCount);
+
+        if (aContext->mDoVerify == PERF_VERIFY_STABLE)
+        {
+            (void)fprintf(stderr, "(no room for the index, order only) ");
+        }
+        else
+        {
+        }
+
+        if (verifyArrayIsSorted(aContext->mArrayToSort,
+                                aContext->mCount,
+                                aWidth,
+                                aContext->mCompareFunc) == 0)
+        {
+            (void)fprintf(stderr, "OK\n");
+        }
+        else
+        {
+            (void)fprintf(stderr, "FAIL\n");
+        }
+    }
+}
+
+static void perfRunAlgorithm(perfContext             *aContext,
+                             uint32_t                 aIndex,
+                             size_t                   aWidth,
+                             const perfComparatorUse *aComparator)
+{
+    const perfAlgorithm *sAlgorithm = aContext->mAlgorithm[aIndex];
+    perfResult          *sResult    = &aContext->mResult[aContext->mResultCnt];
+    int32_t              i;
+
+    aContext->mResultCnt++;
+
+    sResult->mAlgorithm  = sAlgorithm;
+    sResult->mComparator = aComparator;
+    sResult->mInput      = aContext->mInput;
+    sResult->mWidth      = aWidth;
+    sResult->mCount      = aContext->mCount;
+    sResult->mBatchCnt   = aContext->mBatchCnt;
+
+    /* log2(n!) = ln(n!) / ln(2), ln(n!) = lgamma(n + 1) */
+    sResult->mLowerBound = lgamma((double)aContext->mCount + 1) / log(2.0);
+
+    for (i = 0; i < PERF_EVENT_MAX; i++)
+    {
+        sResult->mEvent[i] = -1;
+    }
+
+    if (aContext->mCountOnly == 1)
+    {
+        (void)fprintf(stderr, "%-12s %-6s %-9s w%-4zu n%-10d : counting... ",
+                      aContext->mInput, sAlgorithm->mName, aComparator->mName, aWidth, aContext->mCount);
+
+        perfCountWork(aContext, sAlgorithm, aWidth, sResult);
+
+        (void)fprintf(stderr, "done.\n");
+
+        perfVerify(aContext, sAlgorithm, aWidth, aComparator);
+        return;
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "%-12s %-6s %-9s w%-4zu n%-10d : warming up (%d)... ",
+                  aContext->mInput, sAlgorithm->mName, aComparator->mName, aWidth, aContext->mCount,
+                  aContext->mWarmupCnt);
+
+    for (i = 0; i < aContext->mWarmupCnt; i++)
+    {
+        (void)perfRunOnce(aContext, sAlgorithm, aWidth, NULL);
+    }
+
+    if (aContext->mBatchCnt > 1)
+    {
+        (void)fprintf(stderr, "measuring (%d x %d)... ", aContext->mRepeatCnt, aContext->mBatchCnt);
+    }
+    else
+    {
+        (void)fprintf(stderr, "measuring (%d)... ", aContext->mRepeatCnt);
+    }
+
+    sResult->mSample    = malloc(aContext->mRepeatCnt * sizeof(double));
+    assert(sResult->mSample != NULL);
+
+    if (aContext->mCountEvent == 1)
+    {
+        sResult->mEventSample = malloc(aContext->mRepeatCnt * PERF_EVENT_MAX * sizeof(double));
+        assert(sResult->mEventSample != NULL);
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < aContext->mRepeatCnt; i++)
+    {
+        sResult->mSample[i] = perfRunOnce(aContext, sAlgorithm, aWidth,
+                                          sResult->mEventSample != NULL ?
+                                          &sResult->mEventSample[i * PERF_EVENT_MAX] : NULL);
+    }
+
+    (void)fprintf(stderr, "done.\n");
+
+    perfComputeResult(sResult, aContext->mRepeatCnt, aContext->mCount);
+
+    if (sResult->mEventSample != NULL) perfComputeEvents(sResult, aContext->mRepeatCnt);
+
+    perfCountWork(aContext, sAlgorithm, aWidth, sResult);
+
+    sResult->mNsecPerCmp  = sResult->mCompareCnt > 0 ? sResult->mMedian / sResult->mCompareCnt : 0;
+    sResult->mNsecPerByte = sResult->mMedian / ((double)aContext->mCount * aWidth);
+    sResult->mNsecPerElem = sResult->mMedian / aContext->mCount;
+
+    perfVerify(aContext, sAlgorithm, aWidth, aComparator);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Concurrent Sorts
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * One of the -P threads. Aligned to a cache line so that the threads
+ * do not share one through their own bookkeeping.
+ */
+typedef struct perfWorker
+{
+    perfContext          *mContext;
+    const perfAlgorithm  *mAlgorithm;
+    size_t                mWidth;
+    pthread_barrier_t    *mBarrier;
+    int32_t               mSortCnt;
+
+    double               *mLatency;     /* of each of the mSortCnt sorts */
+    const char           *mError;       /* verification of the last sort, NULL if fine */
+
+    pthread_t             mThread;
+} __attribute__((aligned(64))) perfWorker;
+
+/*
+ * Copies the shared source array into an array of its own and sorts it,
+ * over and over. The array is allocated by the thread, as a server thread would.
+ */
+static void *perfWorkerMain(void *aArg)
+{
+    perfWorker  *sWorker  = (perfWorker *)aArg;
+    perfContext *sContext = sWorker->mContext;
+    size_t       sSize    = sContext->mCount * sWorker->mWidth;
+    uint8_t     *sArray;
+    double       sStart;
+    int32_t      i;
+
+    sArray = malloc(sSize + 1);
+    assert(sArray != NULL);
+
+    for (i = 0; i < sContext->mWarmupCnt; i++)
+    {
+        memcpy(sArray, sContext->mSourceArray, sSize);
+        (*sWorker->mAlgorithm->mSortFunc)(sArray, sContext->mCount, sWorker->mWidth, sContext->mCompareFunc);
+    }
+
+    (void)pthread_barrier_wait(sWorker->mBarrier);
+
+    for (i = 0; i < sWorker->mSortCnt; i++)
+    {
+        memcpy(sArray, sContext->mSourceArray, sSize);
+
+        sStart = perfNowNsec();
+
+        (*sWorker->mAlgorithm->mSortFunc)(sArray, sContext->mCount, sWorker->mWidth, sContext->mCompareFunc);
+
+        sWorker->mLatency[i] = perfNowNsec() - sStart;
+    }
+
+    sWorker->mError = NULL;
+
+    if (sContext->mDoVerify == PERF_VERIFY_STABLE && sContext->mIndexOffset >= 0)
+    {
+        sWorker->mError = verifyArrayIsStable(sContext, sArray, sWorker->mWidth);
+    }
+    else if (sContext->mDoVerify != PERF_VERIFY_NONE &&
+             verifyArrayIsSorted(sArray, sContext->mCount, sWorker->mWidth, sContext->mCompareFunc) != 0)
+    {
+        sWorker->mError = "keys out of order";
+    }
+    else
+    {
+    }
+
+    free(sArray);
+
+    return NULL;
+}
+
+/*
+ * aThreadCnt threads sort mSortCnt copies each, all starting at once.
+ * The throughput is that of the whole run, the latencies those of the sorts alone.
+ */
+static void perfRunConcurrent(perfContext             *aContext,
+                              uint32_t                 aIndex,
+                              size_t                   aWidth,
+                              const perfComparatorUse *aComparator,
+                              int32_t                  aThreadCnt)
+{
+    const perfAlgorithm  *sAlgorithm = aContext->mAlgorithm[aIndex];
+    perfConcurrentResult *sResult    = &aContext->mConcurrentResult[aContext->mConcurrentResultCnt];
+    int32_t               sSortCnt   = aContext->mSortCnt;
+    pthread_barrier_t     sBarrier;
+    perfWorker           *sWorker;
+    double               *sLatency;
+    double                sStart;
+    double                sEnd;
+    int32_t               i;
+
+    aContext->mConcurrentResultCnt++;
+
+    if (sSortCnt < 0)
+    {
+        /* enough for the percentiles even with one thread */
+        sSortCnt = aContext->mCount > 0 ? PERF_CONCURRENT_ELEM_CNT / aContext->mCount : 0;
+
+        if (sSortCnt < PERF_CONCURRENT_MIN_SORTS) sSortCnt = PERF_CONCURRENT_MIN_SORTS;
+    }
+    else
+    {
+    }
+
+    sResult->mAlgorithm  = sAlgorithm;
+    sResult->mComparator = aComparator;
+    sResult->mInput      = aContext->mInput;
+    sResult->mWidth      = aWidth;
+    sResult->mCount      = aContext->mCount;
+    sResult->mThreadCnt  = aThreadCnt;
+    sResult->mSortCnt    = sSortCnt;
+    sResult->mFailCnt    = 0;
+
+    (void)fprintf(stderr, "%-12s %-6s %-9s w%-4zu n%-10d : %d threads x %d sorts... ",
+                  aContext->mInput, sAlgorithm->mName, aComparator->mName, aWidth, aContext->mCount,
+                  aThreadCnt, sSortCnt);
+
+    sWorker  = aligned_alloc(64, sizeof(perfWorker) * aThreadCnt);
+    sLatency = malloc(sizeof(double) * sSortCnt * aThreadCnt);
+    assert(sWorker != NULL && sLatency != NULL);
+
+    /* the threads and this one, which starts the clock */
+    (void)pthread_barrier_init(&sBarrier, NULL, aThreadCnt + 1);
+
+    for (i = 0; i < aThreadCnt; i++)
+    {
+        sWorker[i].mContext   = aContext;
+        sWorker[i].mAlgorithm = sAlgorithm;
+        sWorker[i].mWidth     = aWidth;
+        sWorker[i].mBarrier   = &sBarrier;
+        sWorker[i].mSortCnt   = sSortCnt;
+        sWorker[i].mLatency   = &sLatency[i * sSortCnt];
+        sWorker[i].mError     = NULL;
+
+        if (pthread_create(&sWorker[i].mThread, NULL, perfWorkerMain, &sWorker[i]) != 0)
+        {
+            (void)fprintf(stderr, "error : cannot create thread.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+
+    (void)pthread_barrier_wait(&sBarrier);
+
+    sStart = perfNowNsec();
+
+    for (i = 0; i < aThreadCnt; i++)
+    {
+        (void)pthread_join(sWorker[i].mThread, NULL);
+    }
+
+    sEnd = perfNowNsec();
+
+    for (i = 0; i < aThreadCnt; i++)
+    {
+        if (sWorker[i].mError != NULL)
+        {
+            if (sResult->mFailCnt == 0) (void)fprintf(stderr, "FAIL (%s)... ", sWorker[i].mError);
+
+            sResult->mFailCnt++;
+        }
+        else
+        {
+        }
+    }
+
+    (void)pthread_barrier_destroy(&sBarrier);
+
+    qsort(sLatency, (size_t)sSortCnt * aThreadCnt, sizeof(double), perfCompareDouble);
+
+    sResult->mElemPerSec = (double)aContext->mCount * sSortCnt * aThreadCnt / ((sEnd - sStart) / 1e9);
+    sResult->mP50        = perfPercentile(sLatency, sSortCnt * aThreadCnt, 50);
+    sResult->mP99        = perfPercentile(sLatency, sSortCnt * aThreadCnt, 99);
+    sResult->mP999       = perfPercentile(sLatency, sSortCnt * aThreadCnt, 99.9);
+    sResult->mMax        = sLatency[sSortCnt * aThreadCnt - 1];
+
+    (void)fprintf(stderr, "done.\n");
+
+    free(sLatency);
+    free(sWorker);
+}
+
+/*
+ * Runs every comparator, width and algorithm on the keys in mKeyArray
+ */
+static void perfRunKeys(perfContext *aContext)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+    uint32_t l;
+
+    /*
+     * A counting run is not timed, one copy is enough.
+     * Concurrent sorts are timed one by one in the threads' own copies.
+     */
+    if (aContext->mCountOnly == 0 && aContext->mThreadCntCnt == 0 &&
+        aContext->mCount > 0 && aContext->mCount < PERF_BATCH_ELEM_CNT)
+    {
+        aContext->mBatchCnt = PERF_BATCH_ELEM_CNT / aContext->mCount;
+    }
+    else
+    {
+        aContext->mBatchCnt = 1;
+    }
+
+    for (i = 0; i < aContext->mComparatorCnt; i++)
+    {
+        const perfComparatorUse *sComparator = &aContext->mComparator[i];
+
+        for (j = 0; j < aContext->mWidthCnt; j++)
+        {
+            size_t sWidth = aContext->mWidth[j];
+
+            if (sWidth == 0)
+            {
+                sWidth = aContext->mKeyOffset + sComparator->mComparator->mKeySize;
+            }
+            else
+            {
+            }
+
+            buildElements(aContext, sWidth, sComparator);
+
+            for (k = 0; k < aContext->mAlgorithmCnt; k++)
+            {
+                if (aContext->mThreadCntCnt > 0)
+                {
+                    for (l = 0; l < aContext->mThreadCntCnt; l++)
+                    {
+                        perfRunConcurrent(aContext, k, sWidth, sComparator, aContext->mThreadCnt[l]);
+                    }
+                }
+                else
+                {
+                    perfRunAlgorithm(aContext, k, sWidth, sComparator);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Reporting
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Work per element, which does not depend on the machine.
+ * lg(n!)/elem is the least comparisons per element any comparison sort needs in the worst case,
+ * cmp/bound how far the algorithm is from it. Pre-sorted input can go well below 1.
+ * byte/elem is the memory traffic of the moves, move/elem times the width.
+ */
+static void perfPrintCountReport(perfContext *aContext)
+{
+    uint32_t i;
+    int32_t  sStatMissing = 0;
+
+    (void)fprintf(stderr, "%-12s %-9s %5s %10s %-6s %10s %12s %9s %10s %10s %9s %9s %9s %9s\n",
+                  "input", "cmp", "width", "count", "algo", "cmp/elem", "lg(n!)/elem", "cmp/bound",
+                  "move/elem", "byte/elem", "runs", "run-elem", "merges", "gallops");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s %10.3f %12.3f %9.3f",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName,
+                      (double)sResult->mCompareCnt / sResult->mCount,
+                      sResult->mLowerBound / sResult->mCount,
+                      sResult->mLowerBound > 0 ? sResult->mCompareCnt / sResult->mLowerBound : 0);
+
+        if (sResult->mStat.mEnabled == 1)
+        {
+            (void)fprintf(stderr, " %10.3f %10.1f %9llu %9llu %9llu %9llu\n",
+                          (double)sResult->mStat.mMoveCnt / sResult->mCount,
+                          (double)sResult->mStat.mMoveCnt * sResult->mWidth / sResult->mCount,
+                          (unsigned long long)sResult->mStat.mNaturalRunCnt,
+                          (unsigned long long)sResult->mStat.mNaturalRunElemCnt,
+                          (unsigned long long)sResult->mStat.mMergeCnt,
+                          (unsigned long long)sResult->mStat.mGallopCnt);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %10s %10s %9s %9s %9s %9s\n", "n/a", "n/a", "n/a", "n/a", "n/a", "n/a");
+
+            if (sResult->mAlgorithm->mStatSortFunc != NULL) sStatMissing = 1;
+        }
+    }
+
+    if (sStatMissing == 1)
+    {
+        (void)fprintf(stderr, "\nBuild with 'make stat' to count moves, runs, merges and gallops of timsort.\n");
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "\n");
+}
+
+/*
+ * Memory of one sort, next to that of the data it sorts.
+ * heap/data is the peak of the heap over the bytes sorted : 0.5 for a merge buffer
+ * of half the array, 1 for one of the whole array.
+ * rss is the peak resident size above that before the sort, which is 0 for
+ * memory the allocator already had. merge-mem is timsort's own peak, the merge
+ * memory it maps for huge pages included, which the heap columns do not see.
+ */
+static void perfPrintMemoryReport(perfContext *aContext)
+{
+    uint32_t i;
+
+    (void)fprintf(stderr, "%-12s %-9s %5s %10s %-6s %9s %9s %12s %14s %9s %12s %14s\n",
+                  "input", "cmp", "width", "count", "algo", "mallocs", "frees", "alloc(KiB)",
+                  "heap-peak(KiB)", "heap/data", "rss(KiB)", "merge-mem(KiB)");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName);
+
+        if (sResult->mHeapPeak >= 0)
+        {
+            (void)fprintf(stderr, " %9lld %9lld %12.1f %14.1f %9.3f",
+                          (long long)sResult->mMallocCnt,
+                          (long long)sResult->mFreeCnt,
+                          (double)sResult->mAllocBytes / 1024,
+                          (double)sResult->mHeapPeak / 1024,
+                          (double)sResult->mHeapPeak / ((double)sResult->mCount * sResult->mWidth));
+        }
+        else
+        {
+            (void)fprintf(stderr, " %9s %9s %12s %14s %9s", "n/a", "n/a", "n/a", "n/a", "n/a");
+        }
+
+        if (sResult->mRssPeak >= 0)
+        {
+            (void)fprintf(stderr, " %12.1f", (double)sResult->mRssPeak / 1024);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %12s", "n/a");
+        }
+
+        if (sResult->mAlgorithm->mStatSortFunc != NULL)
+        {
+            (void)fprintf(stderr, " %14.1f\n", (double)sResult->mStat.mMergeMemPeak / 1024);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %14s\n", "n/a");
+        }
+    }
+
+    (void)fprintf(stderr, "\n");
+}
+
+/*
+ * Events of one sort (-I), the median over the repetitions.
+ * Instructions retired in user space are nearly exact from run to run, unlike time,
+ * so they show small changes of the code even on a shared machine.
+ */
+static void perfPrintEventReport(perfContext *aContext)
+{
+    static const int sColumnWidth[PERF_EVENT_MAX] = { 16, 16, 18, 16 };
+
+    uint32_t i;
+    uint32_t j;
+
+    (void)fprintf(stderr, "%-12s %-9s %5s %10s %-6s %16s %11s %11s %16s %18s %16s\n",
+                  "input", "cmp", "width", "count", "algo", "instr/sort", "instr/elem", "instr/cmp",
+                  "cache-miss/elem", "branch-miss/elem", "dtlb-miss/elem");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s %16.0f %11.2f %11.2f",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName,
+                      sResult->mEvent[PERF_EVENT_INSTRUCTIONS],
+                      sResult->mEvent[PERF_EVENT_INSTRUCTIONS] / sResult->mCount,
+                      sResult->mCompareCnt > 0 ?
+                      sResult->mEvent[PERF_EVENT_INSTRUCTIONS] / sResult->mCompareCnt : 0);
+
+        for (j = PERF_EVENT_CACHE_MISSES; j < PERF_EVENT_MAX; j++)
+        {
+            if (sResult->mEvent[j] >= 0)
+            {
+                (void)fprintf(stderr, " %*.4f", sColumnWidth[j], sResult->mEvent[j] / sResult->mCount);
+            }
+            else
+            {
+                (void)fprintf(stderr, " %*s", sColumnWidth[j], "n/a");
+            }
+        }
+
+        (void)fprintf(stderr, "\n");
+    }
+
+    (void)fprintf(stderr, "\n");
+}
+
+/*
+ * elements/s is the throughput of all threads together, thr/1 that per thread
+ * relative to the run with a single thread, if there is one : 1.00 is perfect
+ * scaling, less is contention for the allocator, the caches or memory bandwidth.
+ * Latencies are those of single sorts, in microseconds.
+ */
+static void perfPrintConcurrentReport(perfContext *aContext)
+{
+    uint32_t i;
+    uint32_t j;
+
+    (void)fprintf(stderr, "%-12s %-9s %5s %10s %-6s %7s %9s %14s %7s %11s %11s %11s %11s %5s\n",
+                  "input", "cmp", "width", "count", "algo", "threads", "sorts", "elements/s", "thr/1",
+                  "p50(us)", "p99(us)", "p999(us)", "max(us)", "fail");
+
+    for (i = 0; i < aContext->mConcurrentResultCnt; i++)
+    {
+        const perfConcurrentResult *sResult = &aContext->mConcurrentResult[i];
+        const perfConcurrentResult *sSingle = NULL;
+
+        for (j = 0; j < aContext->mConcurrentResultCnt; j++)
+        {
+            const perfConcurrentResult *sOther = &aContext->mConcurrentResult[j];
+
+            if (sOther->mThreadCnt == 1 &&
+                sOther->mAlgorithm == sResult->mAlgorithm &&
+                sOther->mComparator == sResult->mComparator &&
+                sOther->mInput == sResult->mInput &&
+                sOther->mWidth == sResult->mWidth &&
+                sOther->mCount == sResult->mCount)
+            {
+                sSingle = sOther;
+                break;
+            }
+            else
+            {
+            }
+        }
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s %7d %9d %14.0f",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName,
+                      sResult->mThreadCnt,
+                      sResult->mSortCnt,
+                      sResult->mElemPerSec);
+
+        if (sSingle != NULL)
+        {
+            (void)fprintf(stderr, " %7.2f", sResult->mElemPerSec / sResult->mThreadCnt / sSingle->mElemPerSec);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %7s", "n/a");
+        }
+
+        (void)fprintf(stderr, " %11.2f %11.2f %11.2f %11.2f %5u\n",
+                      sResult->mP50  / 1e3,
+                      sResult->mP99  / 1e3,
+                      sResult->mP999 / 1e3,
+                      sResult->mMax  / 1e3,
+                      sResult->mFailCnt);
+    }
+
+    (void)fprintf(stderr, "\n");
+}
+
+/*
+ * Where the keys came from, e.g. "data.txt" or "generated, seed 0"
+ */
+static void perfDescribeInput(perfContext *aContext, char *aBuffer, size_t aSize)
+{
+    if (aContext->mPatternCnt == 0)
+    {
+        (void)snprintf(aBuffer, aSize, "%s", aContext->mFileName);
+    }
+    else
+    {
+        (void)snprintf(aBuffer, aSize, "generated, seed %d", aContext->mSeed);
+    }
+}
+
+static void perfPrintReport(perfContext *aContext)
+{
+    char     sInput[128];
+    char     sSizes[64];
+    uint32_t i;
+
+    perfDescribeInput(aContext, sInput, sizeof(sInput));
+
+    if (aContext->mSizeCnt > 1)
+    {
+        (void)snprintf(sSizes, sizeof(sSizes), "%d to %d elements",
+                       aContext->mSize[0], aContext->mSize[aContext->mSizeCnt - 1]);
+    }
+    else
+    {
+        (void)snprintf(sSizes, sizeof(sSizes), "%d elements", aContext->mSize[0]);
+    }
+
+    if (aContext->mThreadCntCnt > 0)
+    {
+        (void)fprintf(stderr, "\n%s, %s, %d warmup per thread, key offset %d, concurrent\n\n",
+                      sInput, sSizes, aContext->mWarmupCnt, aContext->mKeyOffset);
+
+        perfPrintConcurrentReport(aContext);
+        return;
+    }
+    else
+    {
+    }
+
+    if (aContext->mCountOnly == 1)
+    {
+        (void)fprintf(stderr, "\n%s, %s, key offset %d, counting only\n\n",
+                      sInput, sSizes, aContext->mKeyOffset);
+
+        perfPrintCountReport(aContext);
+        perfPrintMemoryReport(aContext);
+        return;
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "\n%s, %s, %d repetitions, %d warmup, cpu %d, key offset %d\n\n",
+                  sInput, sSizes, aContext->mRepeatCnt, aContext->mWarmupCnt,
+                  aContext->mCpu, aContext->mKeyOffset);
+
+    /* set(KiB) : the elements being sorted, to tell which cache level they fit in */
+    (void)fprintf(stderr, "%-12s %-9s %5s %10s %-6s %10s %12s %12s %12s %12s %14s %9s %10s %9s %9s\n",
+                  "input", "cmp", "width", "count", "algo", "set(KiB)", "min(ms)", "median(ms)", "p90(ms)", "stddev(ms)",
+                  "elements/s", "ns/elem", "cmp/elem", "ns/cmp", "ns/byte");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s %10.1f %12.3f %12.3f %12.3f %12.3f %14.0f %9.2f %10.2f %9.2f %9.3f\n",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName,
+                      (double)sResult->mCount * sResult->mWidth / 1024,
+                      sResult->mMin    / 1e6,
+                      sResult->mMedian / 1e6,
+                      sResult->mP90    / 1e6,
+                      sResult->mStdDev / 1e6,
+                      sResult->mElemPerSec,
+                      sResult->mNsecPerElem,
+                      (double)sResult->mCompareCnt / sResult->mCount,
+                      sResult->mNsecPerCmp,
+                      sResult->mNsecPerByte);
+    }
+
+    (void)fprintf(stderr, "\n");
+
+    if (aContext->mCountEvent == 1) perfPrintEventReport(aContext);
+
+    perfPrintCountReport(aContext);
+    perfPrintMemoryReport(aContext);
+}
+
+/*
+ * aValue as the inside of a JSON string : quotes and backslashes escaped,
+ * control characters as \u00XX. Cut short, never inside an escape, if
+ * aBuffer is too small.
+ */
+static const char *perfJsonString(const char *aValue, char *aBuffer, size_t aSize)
+{
+    size_t sUsed = 0;
+    char   sPiece[8];
+    size_t sLen;
+
+    for (; *aValue != '\0'; aValue++)
+    {
+        unsigned char sChar = (unsigned char)*aValue;
+
+        if (sChar == '"' || sChar == '\\')
+        {
+            (void)snprintf(sPiece, sizeof(sPiece), "\\%c", sChar);
+        }
+        else if (sChar < 0x20)
+        {
+            (void)snprintf(sPiece, sizeof(sPiece), "\\u%04x", sChar);
+        }
+        else
+        {
+            sPiece[0] = (char)sChar;
+            sPiece[1] = '\0';
+        }
+
+        sLen = strlen(sPiece);
+        if (sUsed + sLen >= aSize) break;
+
+        memcpy(aBuffer + sUsed, sPiece, sLen);
+        sUsed += sLen;
+    }
+
+    aBuffer[sUsed] = '\0';
+
+    return aBuffer;
+}
+
+/*
+ * aValue as a CSV field : quoted, with its quotes doubled, if it holds a
+ * comma, a quote or a line break. Cut short if aBuffer is too small.
+ */
+static const char *perfCsvField(const char *aValue, char *aBuffer, size_t aSize)
+{
+    size_t sUsed = 0;
+
+    if (strpbrk(aValue, ",\"\r\n") == NULL)
+    {
+        (void)snprintf(aBuffer, aSize, "%s", aValue);
+        return aBuffer;
+    }
+    else { }
+
+    aBuffer[sUsed++] = '"';
+
+    for (; *aValue != '\0'; aValue++)
+    {
+        size_t sLen = *aValue == '"' ? 2 : 1;
+
+        /* room left for the closing quote */
+        if (sUsed + sLen + 1 >= aSize) break;
+
+        if (*aValue == '"') aBuffer[sUsed++] = '"';
+        else { }
+        aBuffer[sUsed++] = *aValue;
+    }
+
+    aBuffer[sUsed++] = '"';
+    aBuffer[sUsed]   = '\0';
+
+    return aBuffer;
+}
+
+static void perfWriteCsv(perfContext *aContext, FILE *aFileHandle)
+{
+    char     sEscaped[PERF_ESCAPED_LEN];
+    uint32_t i;
+    uint32_t j;
+
+    (void)fprintf(aFileHandle, "algorithm,comparator,width,key_offset,count,repeat,warmup,min_ns,median_ns,p90_ns,"
+                               "mean_ns,stddev_ns,elements_per_sec,comparisons,ns_per_cmp,ns_per_byte,"
+                               "lower_bound,moves,natural_runs,natural_run_elements,merges,gallops,"
+                               "batch,ns_per_elem,bytes_moved_per_elem,input,"
+                               "instructions,cache_misses,branch_misses,dtlb_misses,"
+                               "mallocs,frees,bytes_allocated,heap_peak_bytes,rss_peak_bytes,merge_mem_peak_bytes\n");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(aFileHandle, "%s,%s,%zu,%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%llu,%.3f,%.4f,%.0f",
+                      sResult->mAlgorithm->mName,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      aContext->mKeyOffset,
+                      sResult->mCount,
+                      aContext->mRepeatCnt,
+                      aContext->mWarmupCnt,
+                      sResult->mMin,
+                      sResult->mMedian,
+                      sResult->mP90,
+                      sResult->mMean,
+                      sResult->mStdDev,
+                      sResult->mElemPerSec,
+                      (unsigned long long)sResult->mCompareCnt,
+                      sResult->mNsecPerCmp,
+                      sResult->mNsecPerByte,
+                      sResult->mLowerBound);
+
+        /* counters left empty if not available */
+        if (sResult->mStat.mEnabled == 1)
+        {
+            (void)fprintf(aFileHandle, ",%llu,%llu,%llu,%llu,%llu",
+                          (unsigned long long)sResult->mStat.mMoveCnt,
+                          (unsigned long long)sResult->mStat.mNaturalRunCnt,
+                          (unsigned long long)sResult->mStat.mNaturalRunElemCnt,
+                          (unsigned long long)sResult->mStat.mMergeCnt,
+                          (unsigned long long)sResult->mStat.mGallopCnt);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, ",,,,,");
+        }
+
+        (void)fprintf(aFileHandle, ",%d,%.3f", sResult->mBatchCnt, sResult->mNsecPerElem);
+
+        if (sResult->mStat.mEnabled == 1)
+        {
+            (void)fprintf(aFileHandle, ",%.3f",
+                          (double)sResult->mStat.mMoveCnt * sResult->mWidth / sResult->mCount);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, ",");
+        }
+
+        (void)fprintf(aFileHandle, ",%s", perfCsvField(sResult->mInput, sEscaped, sizeof(sEscaped)));
+
+        /* events of one sort, empty if not counted */
+        for (j = 0; j < PERF_EVENT_MAX; j++)
+        {
+            if (sResult->mEvent[j] >= 0)
+            {
+                (void)fprintf(aFileHandle, ",%.0f", sResult->mEvent[j]);
+            }
+            else
+            {
+                (void)fprintf(aFileHandle, ",");
+            }
+        }
+
+        /* memory of the counting run, empty if not measured */
+        if (sResult->mHeapPeak >= 0)
+        {
+            (void)fprintf(aFileHandle, ",%lld,%lld,%lld,%lld",
+                          (long long)sResult->mMallocCnt,
+                          (long long)sResult->mFreeCnt,
+                          (long long)sResult->mAllocBytes,
+                          (long long)sResult->mHeapPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, ",,,,");
+        }
+
+        if (sResult->mRssPeak >= 0)
+        {
+            (void)fprintf(aFileHandle, ",%lld", (long long)sResult->mRssPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, ",");
+        }
+
+        if (sResult->mAlgorithm->mStatSortFunc != NULL)
+        {
+            (void)fprintf(aFileHandle, ",%llu", (unsigned long long)sResult->mStat.mMergeMemPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, ",");
+        }
+
+        (void)fprintf(aFileHandle, "\n");
+    }
+}
+
+static void perfWriteJson(perfContext *aContext, FILE *aFileHandle)
+{
+    char     sInput[128];
+    char     sEscaped[PERF_ESCAPED_LEN];
+    uint32_t i;
+    int32_t  j;
+    uint32_t k;
+
+    perfDescribeInput(aContext, sInput, sizeof(sInput));
+
+    (void)fprintf(aFileHandle, "{\n"
+                               "  \"input\": \"%s\",\n"
+                               "  \"count\": %d,\n"
+                               "  \"repeat\": %d,\n"
+                               "  \"warmup\": %d,\n"
+                               "  \"cpu\": %d,\n"
+                               "  \"key_offset\": %d,\n"
+                               "  \"count_only\": %s,\n"
+                               "  \"results\": [\n",
+                  perfJsonString(sInput, sEscaped, sizeof(sEscaped)),
+                  aContext->mSize[aContext->mSizeCnt - 1],
+                  aContext->mRepeatCnt,
+                  aContext->mWarmupCnt,
+                  aContext->mCpu,
+                  aContext->mKeyOffset,
+                  aContext->mCountOnly == 1 ? "true" : "false");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(aFileHandle, "    {\n"
+                                   "      \"input\": \"%s\",\n"
+                                   "      \"algorithm\": \"%s\",\n"
+                                   "      \"comparator\": \"%s\",\n"
+                                   "      \"width\": %zu,\n"
+                                   "      \"count\": %d,\n"
+                                   "      \"batch\": %d,\n"
+                                   "      \"lower_bound\": %.0f,\n"
+                                   "      \"min_ns\": %.0f,\n"
+                                   "      \"median_ns\": %.0f,\n"
+                                   "      \"p90_ns\": %.0f,\n"
+                                   "      \"mean_ns\": %.0f,\n"
+                                   "      \"stddev_ns\": %.0f,\n"
+                                   "      \"elements_per_sec\": %.0f,\n"
+                                   "      \"comparisons\": %llu,\n"
+                                   "      \"ns_per_cmp\": %.3f,\n"
+                                   "      \"ns_per_byte\": %.4f,\n"
+                                   "      \"ns_per_elem\": %.3f,\n",
+                      perfJsonString(sResult->mInput, sEscaped, sizeof(sEscaped)),
+                      sResult->mAlgorithm->mName,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mBatchCnt,
+                      sResult->mLowerBound,
+                      sResult->mMin,
+                      sResult->mMedian,
+                      sResult->mP90,
+                      sResult->mMean,
+                      sResult->mStdDev,
+                      sResult->mElemPerSec,
+                      (unsigned long long)sResult->mCompareCnt,
+                      sResult->mNsecPerCmp,
+                      sResult->mNsecPerByte,
+                      sResult->mNsecPerElem);
+
+        if (sResult->mStat.mEnabled == 1)
+        {
+            (void)fprintf(aFileHandle, "      \"moves\": %llu,\n"
+                                       "      \"bytes_moved_per_elem\": %.3f,\n"
+                                       "      \"natural_runs\": %llu,\n"
+                                       "      \"natural_run_elements\": %llu,\n"
+                                       "      \"merges\": %llu,\n"
+                                       "      \"gallops\": %llu,\n",
+                          (unsigned long long)sResult->mStat.mMoveCnt,
+                          (double)sResult->mStat.mMoveCnt * sResult->mWidth / sResult->mCount,
+                          (unsigned long long)sResult->mStat.mNaturalRunCnt,
+                          (unsigned long long)sResult->mStat.mNaturalRunElemCnt,
+                          (unsigned long long)sResult->mStat.mMergeCnt,
+                          (unsigned long long)sResult->mStat.mGallopCnt);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, "      \"moves\": null,\n"
+                                       "      \"bytes_moved_per_elem\": null,\n"
+                                       "      \"natural_runs\": null,\n"
+                                       "      \"natural_run_elements\": null,\n"
+                                       "      \"merges\": null,\n"
+                                       "      \"gallops\": null,\n");
+        }
+
+        for (k = 0; k < PERF_EVENT_MAX; k++)
+        {
+            if (sResult->mEvent[k] >= 0)
+            {
+                (void)fprintf(aFileHandle, "      \"%s\": %.0f,\n", gEvent[k].mName, sResult->mEvent[k]);
+            }
+            else
+            {
+                (void)fprintf(aFileHandle, "      \"%s\": null,\n", gEvent[k].mName);
+            }
+        }
+
+        if (sResult->mHeapPeak >= 0)
+        {
+            (void)fprintf(aFileHandle, "      \"mallocs\": %lld,\n"
+                                       "      \"frees\": %lld,\n"
+                                       "      \"bytes_allocated\": %lld,\n"
+                                       "      \"heap_peak_bytes\": %lld,\n",
+                          (long long)sResult->mMallocCnt,
+                          (long long)sResult->mFreeCnt,
+                          (long long)sResult->mAllocBytes,
+                          (long long)sResult->mHeapPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, "      \"mallocs\": null,\n"
+                                       "      \"frees\": null,\n"
+                                       "      \"bytes_allocated\": null,\n"
+                                       "      \"heap_peak_bytes\": null,\n");
+        }
+
+        if (sResult->mRssPeak >= 0)
+        {
+            (void)fprintf(aFileHandle, "      \"rss_peak_bytes\": %lld,\n", (long long)sResult->mRssPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, "      \"rss_peak_bytes\": null,\n");
+        }
+
+        if (sResult->mAlgorithm->mStatSortFunc != NULL)
+        {
+            (void)fprintf(aFileHandle, "      \"merge_mem_peak_bytes\": %llu,\n",
+                          (unsigned long long)sResult->mStat.mMergeMemPeak);
+        }
+        else
+        {
+            (void)fprintf(aFileHandle, "      \"merge_mem_peak_bytes\": null,\n");
+        }
+
+        (void)fprintf(aFileHandle, "      \"samples_ns\": [");
+
+        for (j = 0; j < aContext->mRepeatCnt; j++)
+        {
+            (void)fprintf(aFileHandle, "%s%.0f", j == 0 ? "" : ", ", sResult->mSample[j]);
+        }
+
+        (void)fprintf(aFileHandle, "]\n    }%s\n", i + 1 < aContext->mResultCnt ? "," : "");
+    }
+
+    (void)fprintf(aFileHandle, "  ]\n}\n");
+}
+
+static void perfWriteConcurrentCsv(perfContext *aContext, FILE *aFileHandle)
+{
+    char     sEscaped[PERF_ESCAPED_LEN];
+    uint32_t i;
+
+    (void)fprintf(aFileHandle, "input,algorithm,comparator,width,key_offset,count,threads,sorts_per_thread,"
+                               "elements_per_sec,p50_ns,p99_ns,p999_ns,max_ns,failed_threads\n");
+
+    for (i = 0; i < aContext->mConcurrentResultCnt; i++)
+    {
+        const perfConcurrentResult *sResult = &aContext->mConcurrentResult[i];
+
+        (void)fprintf(aFileHandle, "%s,%s,%s,%zu,%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%u\n",
+                      perfCsvField(sResult->mInput, sEscaped, sizeof(sEscaped)),
+                      sResult->mAlgorithm->mName,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      aContext->mKeyOffset,
+                      sResult->mCount,
+                      sResult->mThreadCnt,
+                      sResult->mSortCnt,
+                      sResult->mElemPerSec,
+                      sResult->mP50,
+                      sResult->mP99,
+                      sResult->mP999,
+                      sResult->mMax,
+                      sResult->mFailCnt);
+    }
+}
+
+static void perfWriteConcurrentJson(perfContext *aContext, FILE *aFileHandle)
+{
+    char     sInput[128];
+    char     sEscaped[PERF_ESCAPED_LEN];
+    uint32_t i;
+
+    perfDescribeInput(aContext, sInput, sizeof(sInput));
+
+    (void)fprintf(aFileHandle, "{\n"
+                               "  \"input\": \"%s\",\n"
+                               "  \"warmup\": %d,\n"
+                               "  \"key_offset\": %d,\n"
+                               "  \"concurrent\": [\n",
+                  perfJsonString(sInput, sEscaped, sizeof(sEscaped)),
+                  aContext->mWarmupCnt,
+                  aContext->mKeyOffset);
+
+    for (i = 0; i < aContext->mConcurrentResultCnt; i++)
+    {
+        const perfConcurrentResult *sResult = &aContext->mConcurrentResult[i];
+
+        (void)fprintf(aFileHandle, "    {\n"
+                                   "      \"input\": \"%s\",\n"
+                                   "      \"algorithm\": \"%s\",\n"
+                                   "      \"comparator\": \"%s\",\n"
+                                   "      \"width\": %zu,\n"
+                                   "      \"count\": %d,\n"
+                                   "      \"threads\": %d,\n"
+                                   "      \"sorts_per_thread\": %d,\n"
+                                   "      \"elements_per_sec\": %.0f,\n"
+                                   "      \"p50_ns\": %.0f,\n"
+                                   "      \"p99_ns\": %.0f,\n"
+                                   "      \"p999_ns\": %.0f,\n"
+                                   "      \"max_ns\": %.0f,\n"
+                                   "      \"failed_threads\": %u\n"
+                                   "    }%s\n",
+                      perfJsonString(sResult->mInput, sEscaped, sizeof(sEscaped)),
+                      sResult->mAlgorithm->mName,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mThreadCnt,
+                      sResult->mSortCnt,
+                      sResult->mElemPerSec,
+                      sResult->mP50,
+                      sResult->mP99,
+                      sResult->mP999,
+                      sResult->mMax,
+                      sResult->mFailCnt,
+                      i + 1 < aContext->mConcurrentResultCnt ? "," : "");
+    }
+
+    (void)fprintf(aFileHandle, "  ]\n}\n");
+}
+
+static void perfWriteOutput(perfContext *aContext)
+{
+    FILE *sFileHandle = stdout;
+
+    if (aContext->mOutputFormat == PERF_OUTPUT_NONE) return;
+
+    if (aContext->mOutputFileName != NULL)
+    {
+        sFileHandle = fopen(aContext->mOutputFileName, "w");
+
+        if (sFileHandle == NULL)
+        {
+            (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n",
+                          aContext->mOutputFileName, strerror(errno), errno);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+
+    switch (aContext->mOutputFormat)
+    {
+        case PERF_OUTPUT_CSV:
+            if (aContext->mThreadCntCnt > 0)
+            {
+                perfWriteConcurrentCsv(aContext, sFileHandle);
+            }
+            else
+            {
+                perfWriteCsv(aContext, sFileHandle);
+            }
+            break;
+
+        case PERF_OUTPUT_JSON:
+            if (aContext->mThreadCntCnt > 0)
+            {
+                perfWriteConcurrentJson(aContext, sFileHandle);
+            }
+            else
+            {
+                perfWriteJson(aContext, sFileHandle);
+            }
+            break;
+
+        case PERF_OUTPUT_NONE:
+            abort();
+            break;
+    }
+
+    if (sFileHandle != stdout)
+    {
+        (void)fclose(sFileHandle);
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Baselines
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * e.g. "build01, Intel(R) Xeon(R) Gold 6230 CPU @ 2.10GHz, 80 cpus"
+ */
+static void perfDescribeMachine(char *aBuffer, size_t aSize)
+{
+    char  sHost[64]   = "unknown";
+    char  sModel[128] = "unknown";
+    char  sLine[256];
+    FILE *sFileHandle;
+
+    (void)gethostname(sHost, sizeof(sHost) - 1);
+
+    sFileHandle = fopen("/proc/cpuinfo", "r");
+
+    if (sFileHandle != NULL)
+    {
+        while (fgets(sLine, sizeof(sLine), sFileHandle) != NULL)
+        {
+            if (strncmp(sLine, "model name", 10) == 0 && strchr(sLine, ':') != NULL)
+            {
+                (void)snprintf(sModel, sizeof(sModel), "%s", strchr(sLine, ':') + 2);
+                sModel[strcspn(sModel, "\n")] = '\0';
+                break;
+            }
+            else
+            {
+            }
+        }
+
+        (void)fclose(sFileHandle);
+    }
+    else
+    {
+    }
+
+    (void)snprintf(aBuffer, aSize, "%s, %s, %ld cpus", sHost, sModel, sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+/*
+ * What else the timings depend on : the way they were taken and the build
+ */
+static void perfDescribeConfig(perfContext *aContext, char *aBuffer, size_t aSize)
+{
+    (void)snprintf(aBuffer, aSize, "repeat %d, warmup %d, cpu %d, key offset %d, seed %d, isa %s, gcc %s%s",
+                   aContext->mRepeatCnt, aContext->mWarmupCnt, aContext->mCpu,
+                   aContext->mKeyOffset, aContext->mSeed, timIsaName(), __VERSION__,
+#ifdef TIM_STAT
+                   ", stat"
+#else
+                   ""
+#endif
+                   );
+}
+
+/*
+ * Tab separated, one configuration per line :
+ *
+ *      #perf-baseline 1
+ *      machine <machine>
+ *      config  <configuration>
+ *      result  <input> <comparator> <width> <count> <algorithm> <sample>,<sample>,... [<instructions>]
+ *
+ * The instructions of a sort are there if the baseline was taken with -I.
+ */
+static void perfSaveBaseline(perfContext *aContext)
+{
+    FILE     *sFileHandle;
+    char      sDesc[256];
+    uint32_t  i;
+    int32_t   j;
+
+    sFileHandle = fopen(aContext->mSaveFileName, "w");
+
+    if (sFileHandle == NULL)
+    {
+        (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n",
+                      aContext->mSaveFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    (void)fprintf(sFileHandle, "%s\n", PERF_BASELINE_MAGIC);
+
+    perfDescribeMachine(sDesc, sizeof(sDesc));
+    (void)fprintf(sFileHandle, "machine\t%s\n", sDesc);
+
+    perfDescribeConfig(aContext, sDesc, sizeof(sDesc));
+    (void)fprintf(sFileHandle, "config\t%s\n", sDesc);
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        perfResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(sFileHandle, "result\t%s\t%s\t%zu\t%d\t%s\t",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName);
+
+        for (j = 0; j < aContext->mRepeatCnt; j++)
+        {
+            (void)fprintf(sFileHandle, "%s%.0f", j == 0 ? "" : ",", sResult->mSample[j]);
+        }
+
+        if (sResult->mEvent[PERF_EVENT_INSTRUCTIONS] >= 0)
+        {
+            (void)fprintf(sFileHandle, "\t%.0f", sResult->mEvent[PERF_EVENT_INSTRUCTIONS]);
+        }
+        else
+        {
+        }
+
+        (void)fprintf(sFileHandle, "\n");
+    }
+
+    if (fclose(sFileHandle) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot write '%s'. %s (errno %d)\n",
+                      aContext->mSaveFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "Saved baseline to '%s'.\n", aContext->mSaveFileName);
+}
+
+static void perfBaselineFormatError(const char *aFileName, int32_t aLineNo)
+{
+    (void)fprintf(stderr, "error : '%s' line %d : invalid baseline.\n", aFileName, aLineNo);
+    exit(1);
+}
+
+/*
+ * aLine : a "result" line without its tag, cut at the tabs
+ */
+static void perfParseBaselineEntry(const char *aFileName, int32_t aLineNo, char *aLine, perfBaselineEntry *aEntry)
+{
+    char *sField[6];
+    char *sSavePtr = NULL;
+    char *sSample;
+    char *sEndPtr;
+    int32_t i;
+
+    for (i = 0; i < 6; i++)
+    {
+        sField[i] = strtok_r(i == 0 ? aLine : NULL, "\t\n", &sSavePtr);
+
+        if (sField[i] == NULL) perfBaselineFormatError(aFileName, aLineNo);
+    }
+
+    (void)snprintf(aEntry->mInput,      sizeof(aEntry->mInput),      "%s", sField[0]);
+    (void)snprintf(aEntry->mComparator, sizeof(aEntry->mComparator), "%s", sField[1]);
+    (void)snprintf(aEntry->mAlgorithm,  sizeof(aEntry->mAlgorithm),  "%s", sField[4]);
+
+    aEntry->mWidth = strtoul(sField[2], NULL, 10);
+    aEntry->mCount = strtol(sField[3], NULL, 10);
+
+    /* one more than the commas */
+    aEntry->mSampleCnt = 1;
+
+    for (sSample = sField[5]; *sSample != '\0'; sSample++)
+    {
+        if (*sSample == ',') aEntry->mSampleCnt++;
+    }
+
+    aEntry->mSample = malloc(aEntry->mSampleCnt * sizeof(double));
+    assert(aEntry->mSample != NULL);
+
+    sSample = sField[5];
+
+    for (i = 0; i < aEntry->mSampleCnt; i++)
+    {
+        aEntry->mSample[i] = strtod(sSample, &sEndPtr);
+
+        if (sEndPtr == sSample || (*sEndPtr != ',' && *sEndPtr != '\0'))
+        {
+            perfBaselineFormatError(aFileName, aLineNo);
+        }
+        else
+        {
+        }
+
+        sSample = sEndPtr + 1;
+    }
+
+    sField[0] = strtok_r(NULL, "\t\n", &sSavePtr);
+
+    aEntry->mInstrCnt = sField[0] != NULL ? strtod(sField[0], NULL) : -1;
+}
+
+static void perfLoadBaseline(perfContext *aContext)
+{
+    perfBaseline *sBaseline = &aContext->mBaseline;
+    FILE         *sFileHandle;
+    char         *sLine     = NULL;
+    size_t        sLineSize = 0;
+    uint32_t      sEntryMax = 0;
+    int32_t       sLineNo   = 0;
+
+    sFileHandle = fopen(aContext->mBaselineFileName, "r");
+
+    if (sFileHandle == NULL)
+    {
+        (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n",
+                      aContext->mBaselineFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    (void)strcpy(sBaseline->mMachine, "unknown");
+    (void)strcpy(sBaseline->mConfig, "unknown");
+
+    while (getline(&sLine, &sLineSize, sFileHandle) >= 0)
+    {
+        sLineNo++;
+        sLine[strcspn(sLine, "\n")] = '\0';
+
+        if (sLineNo == 1)
+        {
+            if (strcmp(sLine, PERF_BASELINE_MAGIC) != 0)
+            {
+                (void)fprintf(stderr, "error : '%s' is not a perf baseline.\n", aContext->mBaselineFileName);
+                exit(1);
+            }
+            else
+            {
+            }
+        }
+        else if (strncmp(sLine, "machine\t", 8) == 0)
+        {
+            (void)snprintf(sBaseline->mMachine, sizeof(sBaseline->mMachine), "%s", sLine + 8);
+        }
+        else if (strncmp(sLine, "config\t", 7) == 0)
+        {
+            (void)snprintf(sBaseline->mConfig, sizeof(sBaseline->mConfig), "%s", sLine + 7);
+        }
+        else if (strncmp(sLine, "result\t", 7) == 0)
+        {
+            if (sBaseline->mEntryCnt == sEntryMax)
+            {
+                sEntryMax        = sEntryMax == 0 ? 64 : sEntryMax * 2;
+                sBaseline->mEntry = realloc(sBaseline->mEntry, sEntryMax * sizeof(perfBaselineEntry));
+                assert(sBaseline->mEntry != NULL);
+            }
+            else
+            {
+            }
+
+            perfParseBaselineEntry(aContext->mBaselineFileName, sLineNo, sLine + 7,
+                                   &sBaseline->mEntry[sBaseline->mEntryCnt]);
+            sBaseline->mEntryCnt++;
+        }
+        else if (sLine[0] != '\0')
+        {
+            perfBaselineFormatError(aContext->mBaselineFileName, sLineNo);
+        }
+        else
+        {
+        }
+    }
+
+    if (sLineNo == 0)
+    {
+        (void)fprintf(stderr, "error : '%s' is not a perf baseline.\n", aContext->mBaselineFileName);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    free(sLine);
+    (void)fclose(sFileHandle);
+}
+
+static void perfDestroyBaseline(perfBaseline *aBaseline)
+{
+    uint32_t i;
+
+    for (i = 0; i < aBaseline->mEntryCnt; i++)
+    {
+        free(aBaseline->mEntry[i].mSample);
+    }
+
+    free(aBaseline->mEntry);
+}
+
+static const perfBaselineEntry *perfFindBaseline(perfContext *aContext, const perfResult *aResult)
+{
+    uint32_t i;
+
+    for (i = 0; i < aContext->mBaseline.mEntryCnt; i++)
+    {
+        const perfBaselineEntry *sEntry = &aContext->mBaseline.mEntry[i];
+
+        if (strcmp(sEntry->mInput, aResult->mInput) == 0 &&
+            strcmp(sEntry->mComparator, aResult->mComparator->mName) == 0 &&
+            strcmp(sEntry->mAlgorithm, aResult->mAlgorithm->mName) == 0 &&
+            sEntry->mWidth == aResult->mWidth &&
+            sEntry->mCount == aResult->mCount)
+        {
+            return sEntry;
+        }
+        else
+        {
+        }
+    }
+
+    return NULL;
+}
+
+typedef struct perfRank
+{
+    double  mValue;
+    int32_t mIsNew;
+} perfRank;
+
+static int perfCompareRank(const void *aElem1, const void *aElem2)
+{
+    return perfCompareDouble(&((const perfRank *)aElem1)->mValue, &((const perfRank *)aElem2)->mValue);
+}
+
+/*
+ * One-sided Mann-Whitney U test : the probability of aNew ranking this high above aOld
+ * if both were samples of the same distribution. Unlike a t-test it assumes nothing
+ * about the shape of the distribution, which for timings has a long tail to the right.
+ * Normal approximation with tie and continuity correction, good from about 8 samples each.
+ */
+static double perfMannWhitney(const double *aOld, int32_t aOldCnt, const double *aNew, int32_t aNewCnt)
+{
+    perfRank *sRank;
+    int32_t   sCnt     = aOldCnt + aNewCnt;
+    double    sRankSum = 0;     /* of aNew */
+    double    sTieSum  = 0;     /* t^3 - t for every group of t equal values */
+    double    sU;
+    double    sVariance;
+    int32_t   i;
+    int32_t   j;
+    int32_t   k;
+
+    if (aOldCnt == 0 || aNewCnt == 0) return 1;
+
+    sRank = malloc(sCnt * sizeof(perfRank));
+    assert(sRank != NULL);
+
+    for (i = 0; i < aOldCnt; i++)
+    {
+        sRank[i].mValue = aOld[i];
+        sRank[i].mIsNew = 0;
+    }
+
+    for (i = 0; i < aNewCnt; i++)
+    {
+        sRank[aOldCnt + i].mValue = aNew[i];
+        sRank[aOldCnt + i].mIsNew = 1;
+    }
+
+    qsort(sRank, sCnt, sizeof(perfRank), perfCompareRank);
+
+    for (i = 0; i < sCnt; i = j)
+    {
+        for (j = i + 1; j < sCnt && sRank[j].mValue == sRank[i].mValue; j++)
+        {
+        }
+
+        /* ranks i + 1 .. j are tied, each gets their mean */
+        for (k = i; k < j; k++)
+        {
+            if (sRank[k].mIsNew == 1) sRankSum += (i + 1 + j) / 2.0;
+        }
+
+        sTieSum += (double)(j - i) * (j - i) * (j - i) - (j - i);
+    }
+
+    free(sRank);
+
+    sU        = sRankSum - (double)aNewCnt * (aNewCnt + 1) / 2;
+    sVariance = (double)aOldCnt * aNewCnt / 12 * ((sCnt + 1) - sTieSum / ((double)sCnt * (sCnt - 1)));
+
+    /* all equal */
+    if (sVariance <= 0) return 1;
+
+    return 0.5 * erfc((sU - (double)aOldCnt * aNewCnt / 2 - 0.5) / sqrt(sVariance) / sqrt(2.0));
+}
+
+/*
+ * Result of algorithm aName on the same input, comparator, width and count as aResult
+ */
+static const perfResult *perfFindSibling(perfContext *aContext, const perfResult *aResult, const char *aName)
+{
+    uint32_t i;
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        const perfResult *sResult = &aContext->mResult[i];
+
+        if (sResult->mInput == aResult->mInput &&
+            sResult->mComparator == aResult->mComparator &&
+            sResult->mWidth == aResult->mWidth &&
+            sResult->mCount == aResult->mCount &&
+            strcmp(sResult->mAlgorithm->mName, aName) == 0)
+        {
+            return sResult;
+        }
+        else
+        {
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Prints the change of every result against the baseline, grouped by input,
+ * and returns how many are regressions : slower by more than mThreshold percent,
+ * and significantly so. "vs tim" puts each algorithm next to tim of this run.
+ * If both sides counted instructions (-I), those decide instead of the time,
+ * and any increase above PERF_INSTR_THRESHOLD percent is a regression.
+ */
+static uint32_t perfCompareBaseline(perfContext *aContext)
+{
+    char     sDesc[256];
+    uint32_t sRegressionCnt = 0;
+    uint32_t i;
+
+    (void)fprintf(stderr, "Against baseline '%s', threshold %.1f%%, significance %.2f\n",
+                  aContext->mBaselineFileName, aContext->mThreshold, PERF_SIGNIFICANCE);
+
+    perfDescribeMachine(sDesc, sizeof(sDesc));
+
+    if (strcmp(sDesc, aContext->mBaseline.mMachine) != 0)
+    {
+        (void)fprintf(stderr, "warning : the baseline was taken on %s\n", aContext->mBaseline.mMachine);
+    }
+    else
+    {
+    }
+
+    perfDescribeConfig(aContext, sDesc, sizeof(sDesc));
+
+    if (strcmp(sDesc, aContext->mBaseline.mConfig) != 0)
+    {
+        (void)fprintf(stderr, "warning : the baseline was taken with %s\n", aContext->mBaseline.mConfig);
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "\n%-12s %-9s %5s %10s %-6s %12s %12s %9s %9s %10s %8s  %s\n",
+                  "input", "cmp", "width", "count", "algo", "base(ms)", "median(ms)", "delta", "p-value",
+                  "instr", "vs tim", "verdict");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        const perfResult        *sResult = &aContext->mResult[i];
+        const perfResult        *sTim    = perfFindSibling(aContext, sResult, "tim");
+        const perfBaselineEntry *sEntry  = perfFindBaseline(aContext, sResult);
+        const char              *sVerdict;
+        double                   sBaseMedian;
+        double                   sDelta;
+        double                   sSlower;
+        double                   sFaster;
+        double                   sInstrDelta;
+
+        (void)fprintf(stderr, "%-12s %-9s %5zu %10d %-6s",
+                      sResult->mInput,
+                      sResult->mComparator->mName,
+                      sResult->mWidth,
+                      sResult->mCount,
+                      sResult->mAlgorithm->mName);
+
+        if (sEntry == NULL)
+        {
+            (void)fprintf(stderr, " %12s %12.3f %9s %9s %10s", "-", sResult->mMedian / 1e6, "-", "-", "-");
+            sVerdict = "new";
+        }
+        else
+        {
+            sBaseMedian = perfMedianOf(sEntry->mSample, sEntry->mSampleCnt);
+            sDelta      = sBaseMedian > 0 ? (sResult->mMedian / sBaseMedian - 1) * 100 : 0;
+            sSlower     = perfMannWhitney(sEntry->mSample, sEntry->mSampleCnt,
+                                          sResult->mSample, aContext->mRepeatCnt);
+            sFaster     = perfMannWhitney(sResult->mSample, aContext->mRepeatCnt,
+                                          sEntry->mSample, sEntry->mSampleCnt);
+
+            (void)fprintf(stderr, " %12.3f %12.3f %+8.1f%% %9.4f",
+                          sBaseMedian / 1e6, sResult->mMedian / 1e6, sDelta, sDelta >= 0 ? sSlower : sFaster);
+
+            if (sEntry->mInstrCnt > 0 && sResult->mEvent[PERF_EVENT_INSTRUCTIONS] >= 0)
+            {
+                sInstrDelta = (sResult->mEvent[PERF_EVENT_INSTRUCTIONS] / sEntry->mInstrCnt - 1) * 100;
+
+                (void)fprintf(stderr, " %+9.3f%%", sInstrDelta);
+
+                if (sInstrDelta > PERF_INSTR_THRESHOLD)
+                {
+                    sVerdict = "REGRESSION (instr)";
+                    sRegressionCnt++;
+                }
+                else if (sInstrDelta < -PERF_INSTR_THRESHOLD)
+                {
+                    sVerdict = "improved (instr)";
+                }
+                else
+                {
+                    sVerdict = "";
+                }
+            }
+            else
+            {
+                (void)fprintf(stderr, " %10s", "-");
+
+                if (sDelta > aContext->mThreshold && sSlower < PERF_SIGNIFICANCE)
+                {
+                    sVerdict = "REGRESSION";
+                    sRegressionCnt++;
+                }
+                else if (sDelta < -aContext->mThreshold && sFaster < PERF_SIGNIFICANCE)
+                {
+                    sVerdict = "improved";
+                }
+                else
+                {
+                    sVerdict = "";
+                }
+            }
+        }
+
+        if (sTim != NULL && sTim->mMedian > 0)
+        {
+            (void)fprintf(stderr, " %8.3f  %s\n", sResult->mMedian / sTim->mMedian, sVerdict);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %8s  %s\n", "-", sVerdict);
+        }
+    }
+
+    (void)fprintf(stderr, "\n");
+
+    if (sRegressionCnt > 0)
+    {
+        (void)fprintf(stderr, "%u regression(s) against the baseline.\n", sRegressionCnt);
+    }
+    else
+    {
+    }
+
+    return sRegressionCnt;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Processing Command Line Arguments
+ * -----------------------------------------------------------------------------
+ */
+static void printUsageAndExit(char *aProgramName)
+{
+    uint32_t i = 0;
+
+    (void)fprintf(stderr, "Usage : %s [ options ] <sorting_algorithm>[,<sorting_algorithm>...] <input_file_name>\n"
+                          "        %s [ options ] -g <pattern> <sorting_algorithm>[,<sorting_algorithm>...]\n"
+                          "  -v          verify sorted array\n"
+                          "  -V          verify order, stability and payload : every element carries its\n"
+                          "              original index after the key, which needs a width of key + 4 (-W)\n"
+                          "  -c          count comparisons and moves only, no timing\n"
+                          "              (moves need a 'make stat' build)\n"
+                          "  -I          count instructions, cache misses, branch misses and dTLB load\n"
+                          "              misses of each sort\n"
+                          "              (perf_event_open, user space only). Compared with a baseline,\n"
+                          "              more instructions than %.1f%% is a regression, whatever the time\n"
+                          "  -r NUM      measured repetitions (default %d)\n"
+                          "  -w NUM      warmup runs, not measured (default %d)\n"
+                          "  -a CPU      pin to the cpu\n"
+                          "  -o FORMAT   machine readable output : csv, json\n"
+                          "  -f FILE     write machine readable output to FILE instead of stdout\n"
+                          "  -W LIST     comma separated element widths in bytes, e.g. 4,8,16,32,64,128,256\n"
+                          "              (default : width in the input file header, or 4)\n"
+                          "  -K NUM      offset of the comparator's key inside an element\n"
+                          "              (default : key offset in the input file header, or 0)\n"
+                          "  -g LIST     comma separated patterns to generate the keys of in memory\n"
+                          "              instead of reading a file. PATTERN:NUM gives the parameter (gendata -a)\n"
+                          "  -n NUM      number of keys to generate (default %d), or to take from the start\n"
+                          "              of a file (default : all of them, at most 2^31 - 1)\n"
+                          "  -s NUM      seed of the generated keys (default 0)\n"
+                          "  -N LOW:HIGH sort 2^LOW .. 2^HIGH elements, doubling the size\n"
+                          "              'auto' : from 2^%d until half of the memory is used\n"
+                          "              sizes below %d elements are sorted in batches to be measurable\n"
+                          "  -S FILE     save the timings as a baseline\n"
+                          "  -b FILE     compare the timings with a baseline. Exits with %d if any\n"
+                          "              is significantly slower (Mann-Whitney, p < %.2f) by more than\n"
+                          "              -T percent\n"
+                          "  -T PCT      regression threshold in percent, e.g. 2.5, at most %.0f (default %.1f)\n"
+                          "  -P LIST     comma separated thread counts, e.g. 1,8,32 : that many threads sort\n"
+                          "              copies of the input at once, each its own. Reports the throughput\n"
+                          "              and the latency percentiles of single sorts\n"
+                          "  -M NUM      sorts per thread with -P (default : %d elements' worth, at least %d)\n"
+                          "  -C LIST     comma separated comparators (default : int)\n",
+                          aProgramName, aProgramName, PERF_INSTR_THRESHOLD, PERF_DEFAULT_REPEAT_CNT, PERF_DEFAULT_WARMUP_CNT,
+                          PERF_DEFAULT_GEN_CNT, PERF_SWEEP_MIN_EXP, PERF_BATCH_ELEM_CNT,
+                          PERF_EXIT_REGRESSION, PERF_SIGNIFICANCE, PERF_MAX_THRESHOLD, PERF_DEFAULT_THRESHOLD,
+                          PERF_CONCURRENT_ELEM_CNT, PERF_CONCURRENT_MIN_SORTS);
+
+    for (i = 0; gComparator[i].mName != NULL; i++)
+    {
+        (void)fprintf(stderr, "        %-6s : %s\n", gComparator[i].mName, gComparator[i].mDesc);
+    }
+
+    (void)fprintf(stderr, "  Environment :\n"
+                          "        " TIM_PROFILE_ENV " : profile of tim by element width, written by timtune :\n"
+                          "        minmerge, mingallop, tempsize, addressing, move, merge, runblock, buffer,\n"
+                          "        hugepage, hugetlb, stream and tag (see timconf.h)\n"
+                          "        " TIM_ISA_ENV " : instruction set tim and tim1 run, generic, sse4.2,\n"
+                          "        avx2 or avx512 (default : the best this CPU has)\n");
+
+    (void)fprintf(stderr, "  Patterns :\n");
+
+    for (i = PATTERN_NONE + 1; i < PATTERN_MAX; i++)
+    {
+        (void)fprintf(stderr, "        %-11s : %s\n", patternName(i), patternDesc(i));
+    }
+
+    (void)fprintf(stderr, "  Available sorting algorithms :\n"
+                          "        all\n");
+
+    i = 0;
+
+    while (gAlgorithm[i].mName != NULL)
+    {
+        (void)fprintf(stderr, "        %s (%s)\n", gAlgorithm[i].mName, gAlgorithm[i].mDesc);
+        i++;
+    }
+
+    exit(1);
+}
+
+static void processArgAddAlgorithm(char                *aProgramName,
+                                   const perfAlgorithm *aAlgorithm,
+                                   perfContext         *aContext)
+{
+    if (aContext->mAlgorithmCnt >= PERF_MAX_ALGORITHM_CNT)
+    {
+        (void)fprintf(stderr, "error : too many algorithms.\n");
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    aContext->mAlgorithm[aContext->mAlgorithmCnt] = aAlgorithm;
+    aContext->mAlgorithmCnt++;
+}
+
+/*
+ * aAlgorithmList : comma separated algorithm names, or "all"
+ */
+static void processArgDetermineSortFunc(char        *aProgramName,
+                                        char        *aAlgorithmList,
+                                        perfContext *aContext)
+{
+    char     *sName;
+    char     *sSavePtr = NULL;
+    uint32_t  i;
+
+    for (sName = strtok_r(aAlgorithmList, ",", &sSavePtr);
+         sName != NULL;
+         sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        if (strcmp(sName, "all") == 0)
+        {
+            for (i = 0; gAlgorithm[i].mName != NULL; i++)
+            {
+                processArgAddAlgorithm(aProgramName, &gAlgorithm[i], aContext);
+            }
+
+            continue;
+        }
+        else
+        {
+        }
+
+        for (i = 0; gAlgorithm[i].mName != NULL; i++)
+        {
+            if (strcmp(sName, gAlgorithm[i].mName) == 0)
+            {
+                processArgAddAlgorithm(aProgramName, &gAlgorithm[i], aContext);
+                break;
+            }
+            else
+            {
+            }
+        }
+
+        if (gAlgorithm[i].mName == NULL)
+        {
+            (void)fprintf(stderr, "error : unknown sorting algorithm '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+    }
+
+    if (aContext->mAlgorithmCnt == 0)
+    {
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+}
+
+static int32_t processArgGetInteger(char *aProgramName, char *aOption, char *aValue, int32_t aMin)
+{
+    long  sValue;
+    char *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtol(aValue, &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue > INT32_MAX || sValue < aMin)
+    {
+        (void)fprintf(stderr, "error : the value provided with '%s' is out of range.\n", aOption);
+        exit(1);
+    }
+    else
+    {
+        if (*sEndPtr != '\0' || sEndPtr == aValue)
+        {
+            (void)fprintf(stderr, "error : option '%s' only accepts integer.\n", aOption);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+
+    return (int32_t)sValue;
+}
+
+static double processArgGetDouble(char *aProgramName, char *aOption, char *aValue, double aMin, double aMax)
+{
+    double  sValue;
+    char   *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtod(aValue, &sEndPtr);
+
+    if (*sEndPtr != '\0' || sEndPtr == aValue || isnan(sValue))
+    {
+        (void)fprintf(stderr, "error : option '%s' only accepts a number.\n", aOption);
+        exit(1);
+    }
+    else
+    {
+        if (errno == ERANGE || sValue < aMin || sValue > aMax)
+        {
+            (void)fprintf(stderr, "error : the value provided with '%s' is out of range.\n", aOption);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+
+    return sValue;
+}
+
+/*
+ * aWidthList : comma separated element widths
+ */
+static void processArgDetermineWidth(char        *aProgramName,
+                                     char        *aOption,
+                                     char        *aWidthList,
+                                     perfContext *aContext)
+{
+    char *sWidth;
+    char *sSavePtr = NULL;
+
+    if (aWidthList == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    for (sWidth = strtok_r(aWidthList, ",", &sSavePtr);
+         sWidth != NULL;
+         sWidth = strtok_r(NULL, ",", &sSavePtr))
+    {
+        if (aContext->mWidthCnt >= PERF_MAX_WIDTH_CNT)
+        {
+            (void)fprintf(stderr, "error : too many widths.\n");
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        aContext->mWidth[aContext->mWidthCnt] = processArgGetInteger(aProgramName,
+                                                                     aOption,
+                                                                     sWidth,
+                                                                     PERF_KEY_SIZE);
+        aContext->mWidthCnt++;
+    }
+}
+
+static void processArgDetermineThreads(char        *aProgramName,
+                                       char        *aOption,
+                                       char        *aThreadList,
+                                       perfContext *aContext)
+{
+    char *sThread;
+    char *sSavePtr = NULL;
+
+    if (aThreadList == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    for (sThread = strtok_r(aThreadList, ",", &sSavePtr);
+         sThread != NULL;
+         sThread = strtok_r(NULL, ",", &sSavePtr))
+    {
+        if (aContext->mThreadCntCnt >= PERF_MAX_THREAD_CNT_CNT)
+        {
+            (void)fprintf(stderr, "error : too many thread counts.\n");
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        aContext->mThreadCnt[aContext->mThreadCntCnt] = processArgGetInteger(aProgramName, aOption, sThread, 1);
+
+        if (aContext->mThreadCnt[aContext->mThreadCntCnt] > PERF_MAX_THREAD_CNT)
+        {
+            (void)fprintf(stderr, "error : at most %d threads.\n", PERF_MAX_THREAD_CNT);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aContext->mThreadCntCnt++;
+    }
+}
+
+/*
+ * aPatternList : comma separated gendata pattern names. A parameter, if any, as PATTERN:NUM
+ */
+static void processArgDeterminePattern(char        *aProgramName,
+                                       char        *aOption,
+                                       char        *aPatternList,
+                                       perfContext *aContext)
+{
+    char     *sName;
+    char     *sSavePtr = NULL;
+    char     *sArg;
+    uint32_t  sDefault;
+    uint32_t  sMin;
+
+    if (aPatternList == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    for (sName = strtok_r(aPatternList, ",", &sSavePtr);
+         sName != NULL;
+         sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        perfPatternUse *sUse = &aContext->mPattern[aContext->mPatternCnt];
+
+        if (aContext->mPatternCnt >= PERF_MAX_PATTERN_CNT)
+        {
+            (void)fprintf(stderr, "error : too many patterns.\n");
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        (void)snprintf(sUse->mName, sizeof(sUse->mName), "%s", sName);
+
+        sArg = strchr(sName, ':');
+        if (sArg != NULL) *sArg++ = '\0';
+
+        sUse->mPattern = patternFind(sName);
+        sUse->mParam   = -1;
+
+        if (sUse->mPattern == PATTERN_NONE)
+        {
+            (void)fprintf(stderr, "error : unknown pattern '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        if (sArg != NULL)
+        {
+            if (patternTakesParam(sUse->mPattern, 0, &sDefault, &sMin) == 0)
+            {
+                (void)fprintf(stderr, "error : pattern '%s' does not take a parameter.\n", sName);
+                printUsageAndExit(aProgramName);
+            }
+            else
+            {
+            }
+
+            sUse->mParam = processArgGetInteger(aProgramName, aOption, sArg, sMin);
+        }
+        else
+        {
+        }
+
+        aContext->mPatternCnt++;
+    }
+}
+
+/*
+ * aSweep : LOW:HIGH exponents of 2, or "auto"
+ */
+static void processArgDetermineSweep(char        *aProgramName,
+                                     char        *aOption,
+                                     char        *aSweep,
+                                     perfContext *aContext)
+{
+    char *sHigh;
+
+    if (aSweep == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    if (strcmp(aSweep, "auto") == 0)
+    {
+        aContext->mSweepLow  = PERF_SWEEP_MIN_EXP;
+        aContext->mSweepHigh = 0;
+        return;
+    }
+    else
+    {
+    }
+
+    sHigh = strchr(aSweep, ':');
+
+    if (sHigh == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' accepts LOW:HIGH or auto.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    *sHigh++ = '\0';
+
+    aContext->mSweepLow  = processArgGetInteger(aProgramName, aOption, aSweep, 0);
+    aContext->mSweepHigh = processArgGetInteger(aProgramName, aOption, sHigh, aContext->mSweepLow);
+
+    if (aContext->mSweepHigh > PERF_SWEEP_MAX_EXP)
+    {
+        (void)fprintf(stderr, "error : the value provided with '%s' is out of range.\n", aOption);
+        exit(1);
+    }
+    else
+    {
+    }
+}
+
+/*
+ * aComparatorList : comma separated comparator names. spin takes its cost as spin:K
+ */
+static void processArgDetermineComparator(char        *aProgramName,
+                                          char        *aOption,
+                                          char        *aComparatorList,
+                                          perfContext *aContext)
+{
+    char     *sName;
+    char     *sSavePtr = NULL;
+    char     *sArg;
+    uint32_t  i;
+
+    if (aComparatorList == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    for (sName = strtok_r(aComparatorList, ",", &sSavePtr);
+         sName != NULL;
+         sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        perfComparatorUse *sUse = &aContext->mComparator[aContext->mComparatorCnt];
+
+        if (aContext->mComparatorCnt >= PERF_MAX_COMPARATOR_CNT)
+        {
+            (void)fprintf(stderr, "error : too many comparators.\n");
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
 
-    aContext->mCount = getCountFromFile(sFileHandle);
-
-    createArray(aContext);
+        (void)snprintf(sUse->mName, sizeof(sUse->mName), "%s", sName);
 
-    fillArray(sFileHandle, aContext);
-}
+        sArg = strchr(sName, ':');
+        if (sArg != NULL) *sArg++ = '\0';
 
-/*
- * -----------------------------------------------------------------------------
- *  Processing Command Line Arguments
- * -----------------------------------------------------------------------------
- */
-static void printUsageAndExit(char *aProgramName)
-{
-    (void)fprintf(stderr, "Usage : %s [ -v ] <sorting_algorithm> <input_file_name>\n"
-                          "    If -v is specified, the program verifies sorted array.\n"
-                          "    Available sorting algorithms :\n"
-                          "        quick\n"
-                          "        merge\n"
-                          "        heap\n"
-                          "        tim (index)\n"
-                          "        tim1 (pointer)\n",
-                          aProgramName);
-    exit(1);
+        for (i = 0; gComparator[i].mName != NULL; i++)
+        {
+            if (strcmp(sName, gComparator[i].mName) == 0) break;
+        }
+
+        if (gComparator[i].mName == NULL)
+        {
+            (void)fprintf(stderr, "error : unknown comparator '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        sUse->mComparator  = &gComparator[i];
+        sUse->mSpinCycles  = PERF_DEFAULT_SPIN_CYCLES;
+
+        if (sArg != NULL)
+        {
+            if (gComparator[i].mCompareFunc != compareSpin)
+            {
+                (void)fprintf(stderr, "error : comparator '%s' takes no argument.\n", sName);
+                printUsageAndExit(aProgramName);
+            }
+            else
+            {
+            }
+
+            sUse->mSpinCycles = processArgGetInteger(aProgramName, aOption, sArg, 0);
+        }
+        else
+        {
+        }
+
+        aContext->mComparatorCnt++;
+    }
 }
 
-static void processArgDetermineSortFunc(char        *aProgramName,
-                                        char        *aAlgorithmName,
-                                        perfContext *aContext)
+static void processArg(int32_t aArgc, char *aArgv[], perfContext *aContext)
 {
-    if (strcmp(aAlgorithmName, "quick") == 0)
+    int32_t  i;
+    char    *sAlgorithmList = NULL;
+
+    for (i = 1; i < aArgc; i++)
+    {
+        char *sValue = (i + 1 < aArgc) ? aArgv[i + 1] : NULL;
+
+        if (strcmp(aArgv[i], "-v") == 0)
+        {
+            if (aContext->mDoVerify < 0) aContext->mDoVerify = PERF_VERIFY_ORDER;
+        }
+        else if (strcmp(aArgv[i], "-V") == 0)
+        {
+            aContext->mDoVerify = PERF_VERIFY_STABLE;
+        }
+        else if (strcmp(aArgv[i], "-c") == 0)
+        {
+            aContext->mCountOnly = 1;
+        }
+        else if (strcmp(aArgv[i], "-I") == 0)
+        {
+            aContext->mCountEvent = 1;
+        }
+        else if (strcmp(aArgv[i], "-r") == 0)
+        {
+            aContext->mRepeatCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-w") == 0)
+        {
+            aContext->mWarmupCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-a") == 0)
+        {
+            aContext->mCpu = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-o") == 0)
+        {
+            if (sValue != NULL && strcmp(sValue, "csv") == 0)
+            {
+                aContext->mOutputFormat = PERF_OUTPUT_CSV;
+            }
+            else if (sValue != NULL && strcmp(sValue, "json") == 0)
+            {
+                aContext->mOutputFormat = PERF_OUTPUT_JSON;
+            }
+            else
+            {
+                (void)fprintf(stderr, "error : option '%s' accepts csv or json.\n", aArgv[i]);
+                printUsageAndExit(aArgv[0]);
+            }
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-f") == 0)
+        {
+            if (sValue == NULL)
+            {
+                (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aArgv[i]);
+                printUsageAndExit(aArgv[0]);
+            }
+            else
+            {
+            }
+
+            aContext->mOutputFileName = sValue;
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-W") == 0)
+        {
+            processArgDetermineWidth(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-K") == 0)
+        {
+            aContext->mKeyOffset = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-C") == 0)
+        {
+            processArgDetermineComparator(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-g") == 0)
+        {
+            processArgDeterminePattern(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-n") == 0)
+        {
+            aContext->mGenCount = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-s") == 0)
+        {
+            aContext->mSeed = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-N") == 0)
+        {
+            processArgDetermineSweep(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-S") == 0 || strcmp(aArgv[i], "-b") == 0)
+        {
+            if (sValue == NULL)
+            {
+                (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aArgv[i]);
+                printUsageAndExit(aArgv[0]);
+            }
+            else if (aArgv[i][1] == 'S')
+            {
+                aContext->mSaveFileName = sValue;
+            }
+            else
+            {
+                aContext->mBaselineFileName = sValue;
+            }
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-T") == 0)
+        {
+            aContext->mThreshold = processArgGetDouble(aArgv[0], aArgv[i], sValue, 0, PERF_MAX_THRESHOLD);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-P") == 0)
+        {
+            processArgDetermineThreads(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-M") == 0)
+        {
+            aContext->mSortCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else if (aArgv[i][0] == '-')
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+        else if (sAlgorithmList == NULL)
+        {
+            sAlgorithmList = aArgv[i];
+        }
+        else if (aContext->mFileName == NULL)
+        {
+            aContext->mFileName = aArgv[i];
+        }
+        else
+        {
+            /*
+             * Invalid number of arguments.
+             */
+            printUsageAndExit(aArgv[0]);
+        }
+    }
+
+    if (sAlgorithmList == NULL || (aContext->mFileName == NULL && aContext->mPatternCnt == 0))
+    {
+        printUsageAndExit(aArgv[0]);
+    }
+    else
+    {
+    }
+
+    if (aContext->mGenCount >= 0 && aContext->mSweepLow >= 0)
+    {
+        (void)fprintf(stderr, "error : '-n' and '-N' cannot be used together.\n");
+        printUsageAndExit(aArgv[0]);
+    }
+    else
     {
-        aContext->mSortFunc = qsort;
     }
-    else if (strcmp(aAlgorithmName, "merge") == 0)
+
+    if (aContext->mPatternCnt > 0)
     {
-        aContext->mSortFunc = mergesortLibc;
+        if (aContext->mFileName != NULL)
+        {
+            (void)fprintf(stderr, "error : either generate the keys with '-g' or read them from a file.\n");
+            printUsageAndExit(aArgv[0]);
+        }
+        else
+        {
+        }
+
+        if (aContext->mGenCount < 0) aContext->mGenCount = PERF_DEFAULT_GEN_CNT;
+        if (aContext->mSeed < 0)     aContext->mSeed     = 0;
     }
-    else if (strcmp(aAlgorithmName, "heap") == 0)
+    else if (aContext->mSeed >= 0)
     {
-        aContext->mSortFunc = heapsortLibc;
+        (void)fprintf(stderr, "error : '-s' is an option of '-g'.\n");
+        printUsageAndExit(aArgv[0]);
     }
-    else if (strcmp(aAlgorithmName, "tim") == 0)
+    else
     {
-        aContext->mSortFunc = timsort;
     }
-    else if (strcmp(aAlgorithmName, "tim1") == 0)
+
+    processArgDetermineSortFunc(aArgv[0], sAlgorithmList, aContext);
+
+    if (aContext->mComparatorCnt == 0)
     {
-        aContext->mSortFunc = timsort1;
+        char sDefault[] = "int";
+
+        processArgDetermineComparator(aArgv[0], "-C", sDefault, aContext);
     }
     else
     {
-        printUsageAndExit(aProgramName);
     }
-}
 
-static void processArg(int32_t aArgc, char *aArgv[], perfContext *aContext)
-{
-    if (aArgc == 4)
+    if (aContext->mDoVerify < 0)  aContext->mDoVerify  = PERF_VERIFY_NONE; /* do not verify unless -v or -V */
+    if (aContext->mRepeatCnt < 0) aContext->mRepeatCnt = PERF_DEFAULT_REPEAT_CNT;
+    if (aContext->mWarmupCnt < 0) aContext->mWarmupCnt = PERF_DEFAULT_WARMUP_CNT;
+    if (aContext->mCountOnly < 0) aContext->mCountOnly = 0;
+    if (aContext->mCountEvent < 0) aContext->mCountEvent = 0;
+
+    if (aContext->mThreshold < 0) aContext->mThreshold = PERF_DEFAULT_THRESHOLD;
+
+    if (aContext->mCountOnly == 1)
     {
-        /*
-         * There is an option specified.
-         */
-        if (strcmp(aArgv[1], "-v") == 0)
+        /* nothing timed, nothing to count the events of */
+        aContext->mCountEvent = 0;
+
+        if (aContext->mSaveFileName != NULL || aContext->mBaselineFileName != NULL)
         {
-            aContext->mDoVerify = 1;
+            (void)fprintf(stderr, "error : baselines hold timings, there are none with '-c'.\n");
+            exit(1);
         }
         else
         {
-            printUsageAndExit(aArgv[0]);
         }
 
-        processArgDetermineSortFunc(aArgv[0], aArgv[2], aContext);
-        aContext->mFileName = aArgv[3];
+        /* a single counting run per algorithm */
+        aContext->mRepeatCnt = 0;
+        aContext->mWarmupCnt = 0;
     }
-    else if (aArgc == 3)
+    else
     {
-        /*
-         * No option specified
-         */
-        processArgDetermineSortFunc(aArgv[0], aArgv[1], aContext);
-        aContext->mFileName = aArgv[2];
     }
-    else
+
+    if (aContext->mThreadCntCnt > 0)
+    {
+        if (aContext->mCountOnly == 1 || aContext->mCountEvent == 1 ||
+            aContext->mSaveFileName != NULL || aContext->mBaselineFileName != NULL)
+        {
+            (void)fprintf(stderr, "error : '-P' cannot be used with '-c', '-I', '-S' or '-b'.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+    else if (aContext->mSortCnt > 0)
     {
-        /*
-         * Invalid number of arguments.
-         */
+        (void)fprintf(stderr, "error : '-M' is an option of '-P'.\n");
         printUsageAndExit(aArgv[0]);
     }
+    else
+    {
+    }
 
-    if (aContext->mDoVerify < 0) aContext->mDoVerify = 0; /* do not verify unless -v is provided */
+    if (aContext->mOutputFileName != NULL && aContext->mOutputFormat == PERF_OUTPUT_NONE)
+    {
+        aContext->mOutputFormat = PERF_OUTPUT_JSON;
+    }
+    else
+    {
+    }
 }
 
 /*
@@ -337,11 +4478,12 @@ static void processArg(int32_t aArgc, char *aArgv[], perfContext *aContext)
 int32_t main(int32_t aArgc, char *aArgv[])
 {
     perfContext     sContext;
-
-    struct timeval  sStart, sEnd;
-    int32_t         sSeconds, sUseconds;
-
-    uint32_t       *sArray;
+    double          sLoadStart;
+    uint32_t        sRegressionCnt = 0;
+    uint32_t        sInputCnt;
+    uint32_t        sInput;
+    uint32_t        sSize;
+    uint32_t        i;
 
     /*
      * Init
@@ -350,61 +4492,174 @@ int32_t main(int32_t aArgc, char *aArgv[])
 
     processArg(aArgc, aArgv, &sContext);
 
+    if (sContext.mCpu >= 0)
+    {
+        perfPinToCpu(sContext.mCpu);
+    }
+    else
+    {
+    }
+
+    if (sContext.mCountEvent == 1)
+    {
+        perfOpenEvents(&sContext);
+    }
+    else
+    {
+    }
+
+    /* a broken baseline should not cost a whole run */
+    if (sContext.mBaselineFileName != NULL)
+    {
+        perfLoadBaseline(&sContext);
+    }
+    else
+    {
+    }
+
     /*
-     * Allocate memory and load data
+     * Allocate memory and load data. Generated keys are made for each size later on.
      */
-    (void)fprintf(stderr, "Reading data...\n");
-    createAndFillArray(&sContext);
+    if (sContext.mFileName != NULL)
+    {
+        (void)fprintf(stderr, "Reading data...\n");
+        sLoadStart = perfNowNsec();
+        createAndFillArray(&sContext);
+        (void)fprintf(stderr, "Read %d elements in %.3f s.\n", sContext.mCount, (perfNowNsec() - sLoadStart) / 1e9);
 
-    sArray = sContext.mArrayToSort;
+        sContext.mKeyCnt = sContext.mCount;
+    }
+    else
+    {
+    }
 
     /*
-     * Sort it!
+     * Element layout : options, then the file header, then the smallest
+     * element that holds the comparator's key (uint32_t array for "int").
+     * Width 0 stands for the latter.
      */
-    (void)fprintf(stderr, "Start sorting...\n");
-    (void)gettimeofday(&sStart, NULL);
+    if (sContext.mWidthCnt == 0)
+    {
+        sContext.mWidth[0] = 0;
+        sContext.mWidthCnt = 1;
+    }
+    else
+    {
+    }
 
-    (*sContext.mSortFunc)(sArray, sContext.mCount, sizeof(uint32_t), compareFunc);
+    if (sContext.mKeyOffset < 0) sContext.mKeyOffset = 0;
 
-    (void)gettimeofday(&sEnd, NULL);
-    (void)fprintf(stderr, "Completed sorting.\n");
+    for (i = 0; i < sContext.mComparatorCnt; i++)
+    {
+        uint32_t j;
+
+        for (j = 0; j < sContext.mWidthCnt; j++)
+        {
+            size_t sKeyEnd = sContext.mKeyOffset + sContext.mComparator[i].mComparator->mKeySize;
+
+            if (sContext.mWidth[j] != 0 && sKeyEnd > sContext.mWidth[j])
+            {
+                (void)fprintf(stderr, "error : key of '%s' at offset %d does not fit in width %zu.\n",
+                              sContext.mComparator[i].mName, sContext.mKeyOffset, sContext.mWidth[j]);
+                exit(1);
+            }
+            else
+            {
+            }
+        }
+    }
+
+    perfChooseSizes(&sContext);
+
+    if (sContext.mPatternCnt > 0)
+    {
+        sContext.mKeyCnt   = sContext.mSize[sContext.mSizeCnt - 1];
+        sContext.mKeyArray = createArray(sContext.mKeyCnt * PERF_KEY_SIZE);
+    }
+    else
+    {
+    }
+
+    /* the patterns, or the file */
+    sInputCnt = sContext.mPatternCnt > 0 ? sContext.mPatternCnt : 1;
+
+    sContext.mResult = calloc(sInputCnt * sContext.mSizeCnt *
+                              sContext.mComparatorCnt * sContext.mWidthCnt * sContext.mAlgorithmCnt,
+                              sizeof(perfResult));
+    assert(sContext.mResult != NULL);
+
+    if (sContext.mThreadCntCnt > 0)
+    {
+        sContext.mConcurrentResult = calloc(sInputCnt * sContext.mSizeCnt * sContext.mComparatorCnt *
+                                            sContext.mWidthCnt * sContext.mAlgorithmCnt * sContext.mThreadCntCnt,
+                                            sizeof(perfConcurrentResult));
+        assert(sContext.mConcurrentResult != NULL);
+    }
+    else
+    {
+    }
 
     /*
-     * Calculate time
+     * Sort it!
      */
-    sSeconds  = sEnd.tv_sec - sStart.tv_sec;
-    sUseconds = sEnd.tv_usec - sStart.tv_usec;
+    (void)fprintf(stderr, "Start sorting...\n");
 
-    if (sUseconds < 0)
+    for (sInput = 0; sInput < sInputCnt; sInput++)
     {
-        sSeconds--;
-        sUseconds += 1000000;
+        for (sSize = 0; sSize < sContext.mSizeCnt; sSize++)
+        {
+            perfPrepareKeys(&sContext,
+                            sContext.mPatternCnt > 0 ? &sContext.mPattern[sInput] : NULL,
+                            sContext.mSize[sSize]);
+
+            perfRunKeys(&sContext);
+        }
     }
 
-    (void)fprintf(stderr, "\nIt took %d.%06d seconds to sort %d elements.\n\n",
-                  sSeconds, sUseconds, sContext.mCount);
+    (void)fprintf(stderr, "Completed sorting.\n");
 
     /*
-     * Verify if option is set
+     * Report
      */
-    if (sContext.mDoVerify == 1)
+    perfPrintReport(&sContext);
+    perfWriteOutput(&sContext);
+
+    if (sContext.mBaselineFileName != NULL)
+    {
+        sRegressionCnt = perfCompareBaseline(&sContext);
+    }
+    else
     {
-        (void)fprintf(stderr, "Checking if resulting array is correctly sorted...... ");
+    }
 
-        if (verifyArrayIsSorted(sArray, sContext.mCount) == 0)
-        {
-            (void)fprintf(stderr, "OK\n");
-        }
-        else
-        {
-            (void)fprintf(stderr, "FAIL\n");
-        }
+    if (sContext.mSaveFileName != NULL)
+    {
+        perfSaveBaseline(&sContext);
+    }
+    else
+    {
     }
 
     /*
      * Free memory
      */
-    destroyArray(sArray);
+    for (i = 0; i < sContext.mResultCnt; i++)
+    {
+        free(sContext.mResult[i].mSample);
+        free(sContext.mResult[i].mEventSample);
+    }
 
-    return 0;
+    free(sContext.mResult);
+    free(sContext.mConcurrentResult);
+
+    destroyArray(sContext.mArrayToSort);
+    destroyArray(sContext.mSourceArray);
+    destroyArray(sContext.mStringPool);
+    destroyArray(sContext.mKeyArray);
+
+    perfDestroyBaseline(&sContext.mBaseline);
+
+    if (sContext.mCountEvent == 1) perfCloseEvents(&sContext);
+
+    return sRegressionCnt > 0 ? PERF_EXIT_REGRESSION : 0;
 }
@@ -0,0 +1,849 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <algorithm>
+
+#ifdef PERFCXX_PARALLEL
+#include <execution>
+#endif
+
+extern "C"
+{
+#include "timsort.h"
+#include "timsort1.h"
+#include "dataset.h"
+#include "pattern.h"
+}
+
+/*
+ * Timsort next to the C++ standard library, on the same keys as perf.
+ *
+ * The standard algorithms are run twice : with the comparison inlined into the
+ * template instance (a lambda on the key), and through the same C callback the
+ * C engines are given, called through a pointer the compiler cannot see through.
+ * The difference between the two is what the callback interface costs;
+ * the difference between timsort and std::stable_sort with a callback is what
+ * the engine itself is worth.
+ *
+ * Elements are fixed size structs, a uint32_t key at offset 0 and a payload,
+ * for the widths instantiated in cxxRunWidth().
+ */
+#define PERFCXX_DEFAULT_REPEAT_CNT  11
+#define PERFCXX_DEFAULT_WARMUP_CNT  1
+#define PERFCXX_DEFAULT_GEN_CNT     1000000
+#define PERFCXX_MAX_WIDTH_CNT       8
+#define PERFCXX_MAX_RESULT_CNT      1024
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Engines
+ * -----------------------------------------------------------------------------
+ */
+typedef enum
+{
+    CXX_ENGINE_TIM,
+    CXX_ENGINE_TIM1,
+    CXX_ENGINE_QSORT,
+    CXX_ENGINE_STD_SORT,
+    CXX_ENGINE_STD_STABLE,
+    CXX_ENGINE_PAR_SORT,
+    CXX_ENGINE_PAR_STABLE,
+    CXX_ENGINE_MAX
+} cxxEngineId;
+
+typedef enum
+{
+    CXX_CMP_INLINE,         /* lambda, inlined into the sort */
+    CXX_CMP_CALLBACK,       /* int (*)(const void *, const void *), as the C engines take */
+    CXX_CMP_MAX
+} cxxCmpMode;
+
+typedef struct cxxEngine
+{
+    const char   *mName;
+    const char   *mDesc;
+    int32_t       mStable;
+    int32_t       mHasInline;       /* takes an inlined comparator */
+    int32_t       mAvailable;       /* 0 : parallel algorithms not built in */
+} cxxEngine;
+
+#ifdef PERFCXX_PARALLEL
+#define PERFCXX_HAS_PARALLEL    1
+#else
+#define PERFCXX_HAS_PARALLEL    0
+#endif
+
+static const cxxEngine gEngine[CXX_ENGINE_MAX] =
+{
+    { "tim",        "timsort",                              1, 0, 1 },
+    { "tim1",       "timsort (pointer, bytes)",             1, 0, 1 },
+    { "quick",      "libc qsort",                           0, 0, 1 },
+    { "std-sort",   "std::sort",                            0, 1, 1 },
+    { "std-stable", "std::stable_sort",                     1, 1, 1 },
+    { "par-sort",   "std::sort(std::execution::par)",       0, 1, PERFCXX_HAS_PARALLEL },
+    { "par-stable", "std::stable_sort(std::execution::par)", 1, 1, PERFCXX_HAS_PARALLEL }
+};
+
+static const char *gCmpModeName[CXX_CMP_MAX] = { "inline", "callback" };
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Elements And Comparators
+ * -----------------------------------------------------------------------------
+ */
+template <size_t W> struct cxxElem
+{
+    uint32_t mKey;
+    uint8_t  mPayload[W - sizeof(uint32_t)];
+};
+
+template <> struct cxxElem<4>
+{
+    uint32_t mKey;
+};
+
+static int cxxCompareKey(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1 = *(const uint32_t *)aElem1;
+    uint32_t sKey2 = *(const uint32_t *)aElem2;
+
+    return (sKey1 > sKey2) - (sKey1 < sKey2);
+}
+
+/*
+ * volatile : read at every call, so that the standard algorithms
+ * cannot inline the callback any more than the C engines can
+ */
+static int (*volatile gCompareFunc)(const void *, const void *) = cxxCompareKey;
+
+template <size_t W>
+static void cxxSort(cxxEngineId aEngine, cxxCmpMode aMode, cxxElem<W> *aArray, size_t aCount)
+{
+    typedef cxxElem<W> elem;
+
+    auto sInline   = [](const elem &aElem1, const elem &aElem2) { return aElem1.mKey < aElem2.mKey; };
+    auto sCallback = [](const elem &aElem1, const elem &aElem2) { return (*gCompareFunc)(&aElem1, &aElem2) < 0; };
+
+    switch (aEngine)
+    {
+        case CXX_ENGINE_TIM:
+            timsort(aArray, aCount, W, gCompareFunc);
+            break;
+
+        case CXX_ENGINE_TIM1:
+            timsort1(aArray, aCount, W, gCompareFunc);
+            break;
+
+        case CXX_ENGINE_QSORT:
+            qsort(aArray, aCount, W, gCompareFunc);
+            break;
+
+        case CXX_ENGINE_STD_SORT:
+            if (aMode == CXX_CMP_INLINE) std::sort(aArray, aArray + aCount, sInline);
+            else                         std::sort(aArray, aArray + aCount, sCallback);
+            break;
+
+        case CXX_ENGINE_STD_STABLE:
+            if (aMode == CXX_CMP_INLINE) std::stable_sort(aArray, aArray + aCount, sInline);
+            else                         std::stable_sort(aArray, aArray + aCount, sCallback);
+            break;
+
+#ifdef PERFCXX_PARALLEL
+        case CXX_ENGINE_PAR_SORT:
+            if (aMode == CXX_CMP_INLINE) std::sort(std::execution::par, aArray, aArray + aCount, sInline);
+            else                         std::sort(std::execution::par, aArray, aArray + aCount, sCallback);
+            break;
+
+        case CXX_ENGINE_PAR_STABLE:
+            if (aMode == CXX_CMP_INLINE) std::stable_sort(std::execution::par, aArray, aArray + aCount, sInline);
+            else                         std::stable_sort(std::execution::par, aArray, aArray + aCount, sCallback);
+            break;
+#endif
+
+        default:
+            abort();
+            break;
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Configuration And Results
+ * -----------------------------------------------------------------------------
+ */
+typedef struct cxxResult
+{
+    cxxEngineId  mEngine;
+    cxxCmpMode   mMode;
+    size_t       mWidth;
+    double       mMin;          /* nanoseconds */
+    double       mMedian;
+    int32_t      mVerified;     /* 1 : OK, 0 : FAIL, -1 : not verified */
+} cxxResult;
+
+typedef struct cxxContext
+{
+    char        *mFileName;     /* binary dataset, NULL if generated */
+    patternId    mPattern;
+    int32_t      mGenCount;
+    int32_t      mSeed;
+    const char  *mInput;        /* pattern or file name */
+
+    uint32_t     mCount;
+    uint32_t    *mKeyArray;
+
+    uint32_t     mWidthCnt;
+    size_t       mWidth[PERFCXX_MAX_WIDTH_CNT];
+
+    int32_t      mEngineSelected[CXX_ENGINE_MAX];
+    int32_t      mModeSelected[CXX_CMP_MAX];
+
+    int32_t      mRepeatCnt;
+    int32_t      mWarmupCnt;
+    int32_t      mDoVerify;
+    int32_t      mCsv;          /* -o csv : results to stdout */
+
+    uint32_t     mResultCnt;
+    cxxResult    mResult[PERFCXX_MAX_RESULT_CNT];
+} cxxContext;
+
+static double cxxNowNsec(void)
+{
+    struct timespec sNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+static int cxxCompareDouble(const void *aElem1, const void *aElem2)
+{
+    double sValue1 = *(const double *)aElem1;
+    double sValue2 = *(const double *)aElem2;
+
+    return (sValue1 > sValue2) - (sValue1 < sValue2);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Running Benchmark
+ * -----------------------------------------------------------------------------
+ */
+template <size_t W>
+static int32_t cxxIsSorted(const cxxElem<W> *aArray, uint32_t aCount)
+{
+    uint32_t i;
+
+    for (i = 1; i < aCount; i++)
+    {
+        if (aArray[i - 1].mKey > aArray[i].mKey) return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Every selected engine and comparator mode on W byte elements.
+ * The payload is derived from the original index, as in perf.
+ */
+template <size_t W>
+static void cxxRunWidth(cxxContext *aContext)
+{
+    typedef cxxElem<W> elem;
+
+    elem     *sSource;
+    elem     *sArray;
+    double   *sSample;
+    double    sStart;
+    uint32_t  i;
+    size_t    j;
+    int32_t   k;
+    int32_t   e;
+    int32_t   m;
+
+    static_assert(sizeof(elem) == W, "element has padding");
+
+    sSource = (elem *)malloc(sizeof(elem) * aContext->mCount + 1);
+    sArray  = (elem *)malloc(sizeof(elem) * aContext->mCount + 1);
+    sSample = (double *)malloc(sizeof(double) * aContext->mRepeatCnt);
+    assert(sSource != NULL && sArray != NULL && sSample != NULL);
+
+    for (i = 0; i < aContext->mCount; i++)
+    {
+        uint8_t *sBytes = (uint8_t *)&sSource[i];
+
+        for (j = 0; j < W; j++)
+        {
+            sBytes[j] = (uint8_t)(i * 31 + j);
+        }
+
+        sSource[i].mKey = aContext->mKeyArray[i];
+    }
+
+    for (e = 0; e < CXX_ENGINE_MAX; e++)
+    {
+        for (m = 0; m < CXX_CMP_MAX; m++)
+        {
+            cxxEngineId  sEngine = (cxxEngineId)e;
+            cxxCmpMode   sMode   = (cxxCmpMode)m;
+            cxxResult   *sResult;
+
+            if (aContext->mEngineSelected[e] == 0 || aContext->mModeSelected[m] == 0) continue;
+            if (sMode == CXX_CMP_INLINE && gEngine[e].mHasInline == 0) continue;
+
+            if (aContext->mResultCnt >= PERFCXX_MAX_RESULT_CNT)
+            {
+                (void)fprintf(stderr, "error : too many configurations.\n");
+                exit(1);
+            }
+            else
+            {
+            }
+
+            sResult = &aContext->mResult[aContext->mResultCnt++];
+
+            (void)fprintf(stderr, "%-12s %-10s %-8s w%-4zu n%-10u : measuring (%d)... ",
+                          aContext->mInput, gEngine[e].mName, gCmpModeName[m], W, aContext->mCount,
+                          aContext->mRepeatCnt);
+
+            for (k = 0; k < aContext->mWarmupCnt + aContext->mRepeatCnt; k++)
+            {
+                memcpy(sArray, sSource, sizeof(elem) * aContext->mCount);
+
+                sStart = cxxNowNsec();
+
+                cxxSort<W>(sEngine, sMode, sArray, aContext->mCount);
+
+                if (k >= aContext->mWarmupCnt) sSample[k - aContext->mWarmupCnt] = cxxNowNsec() - sStart;
+            }
+
+            qsort(sSample, aContext->mRepeatCnt, sizeof(double), cxxCompareDouble);
+
+            sResult->mEngine   = sEngine;
+            sResult->mMode     = sMode;
+            sResult->mWidth    = W;
+            sResult->mMin      = sSample[0];
+            sResult->mMedian   = sSample[aContext->mRepeatCnt / 2];
+            sResult->mVerified = aContext->mDoVerify == 1 ? cxxIsSorted<W>(sArray, aContext->mCount) : -1;
+
+            (void)fprintf(stderr, "done%s\n", sResult->mVerified == 0 ? ", FAIL : not sorted" : ".");
+        }
+    }
+
+    free(sSource);
+    free(sArray);
+    free(sSample);
+}
+
+static void cxxRun(cxxContext *aContext)
+{
+    uint32_t i;
+
+    for (i = 0; i < aContext->mWidthCnt; i++)
+    {
+        switch (aContext->mWidth[i])
+        {
+            case 4:  cxxRunWidth<4>(aContext);  break;
+            case 8:  cxxRunWidth<8>(aContext);  break;
+            case 16: cxxRunWidth<16>(aContext); break;
+            case 32: cxxRunWidth<32>(aContext); break;
+            case 64: cxxRunWidth<64>(aContext); break;
+            default: abort();                   break;
+        }
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Reporting
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * vs-tim : median over that of tim on the same width, below 1 is faster.
+ * tim runs the policies of the profile, pointer addressing without one.
+ */
+static const cxxResult *cxxFindTim(const cxxContext *aContext, size_t aWidth)
+{
+    uint32_t i;
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        if (aContext->mResult[i].mEngine == CXX_ENGINE_TIM && aContext->mResult[i].mWidth == aWidth)
+        {
+            return &aContext->mResult[i];
+        }
+        else
+        {
+        }
+    }
+
+    return NULL;
+}
+
+static void cxxPrintReport(const cxxContext *aContext)
+{
+    uint32_t i;
+
+    (void)fprintf(stderr, "\n%s, %u elements, %d repetitions, %d warmup\n\n",
+                  aContext->mInput, aContext->mCount, aContext->mRepeatCnt, aContext->mWarmupCnt);
+
+    (void)fprintf(stderr, "%-12s %5s %10s %-10s %-8s %6s %12s %12s %9s %7s\n",
+                  "input", "width", "count", "engine", "cmp", "stable", "min(ms)", "median(ms)", "ns/elem", "vs-tim");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        const cxxResult *sResult = &aContext->mResult[i];
+        const cxxResult *sTim    = cxxFindTim(aContext, sResult->mWidth);
+
+        (void)fprintf(stderr, "%-12s %5zu %10u %-10s %-8s %6s %12.3f %12.3f %9.2f",
+                      aContext->mInput,
+                      sResult->mWidth,
+                      aContext->mCount,
+                      gEngine[sResult->mEngine].mName,
+                      gCmpModeName[sResult->mMode],
+                      gEngine[sResult->mEngine].mStable == 1 ? "yes" : "no",
+                      sResult->mMin / 1e6,
+                      sResult->mMedian / 1e6,
+                      aContext->mCount > 0 ? sResult->mMedian / aContext->mCount : 0);
+
+        if (sTim != NULL && sTim->mMedian > 0)
+        {
+            (void)fprintf(stderr, " %7.2f\n", sResult->mMedian / sTim->mMedian);
+        }
+        else
+        {
+            (void)fprintf(stderr, " %7s\n", "n/a");
+        }
+    }
+
+    (void)fprintf(stderr, "\n");
+}
+
+static void cxxWriteCsv(const cxxContext *aContext)
+{
+    uint32_t i;
+
+    (void)fprintf(stdout, "input,width,count,engine,comparator,stable,repeat,min_ns,median_ns,ns_per_elem\n");
+
+    for (i = 0; i < aContext->mResultCnt; i++)
+    {
+        const cxxResult *sResult = &aContext->mResult[i];
+
+        (void)fprintf(stdout, "%s,%zu,%u,%s,%s,%d,%d,%.0f,%.0f,%.3f\n",
+                      aContext->mInput,
+                      sResult->mWidth,
+                      aContext->mCount,
+                      gEngine[sResult->mEngine].mName,
+                      gCmpModeName[sResult->mMode],
+                      gEngine[sResult->mEngine].mStable,
+                      aContext->mRepeatCnt,
+                      sResult->mMin,
+                      sResult->mMedian,
+                      aContext->mCount > 0 ? sResult->mMedian / aContext->mCount : 0);
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Loading Keys
+ * -----------------------------------------------------------------------------
+ */
+static void cxxLoadKeys(cxxContext *aContext)
+{
+    patternGen   sGen;
+    datasetMap   sMap;
+    const char  *sError;
+
+    if (aContext->mFileName != NULL)
+    {
+        if (datasetMapFile(aContext->mFileName, &sMap) != 0)
+        {
+            (void)fprintf(stderr, "error : cannot map '%s'. %s (errno %d)\n"
+                                  "        Only binary datasets are read, see gendata.\n",
+                          aContext->mFileName, strerror(errno), errno);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        sError = datasetCheckHeader(sMap.mHeader, sMap.mSize);
+
+        if (sError != NULL)
+        {
+            (void)fprintf(stderr, "error : '%s' : %s.\n", aContext->mFileName, sError);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        if (sMap.mHeader->mCount > INT32_MAX)
+        {
+            (void)fprintf(stderr, "error : the count is out of range.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aContext->mCount    = (uint32_t)sMap.mHeader->mCount;
+        aContext->mKeyArray = (uint32_t *)malloc(sizeof(uint32_t) * aContext->mCount + 1);
+        assert(aContext->mKeyArray != NULL);
+
+        memcpy(aContext->mKeyArray, sMap.mKey, sizeof(uint32_t) * aContext->mCount);
+
+        datasetUnmapFile(&sMap);
+
+        aContext->mInput = aContext->mFileName;
+    }
+    else
+    {
+        uint32_t sDefault;
+        uint32_t sMin;
+        uint32_t sParam = 0;
+
+        aContext->mCount    = (uint32_t)aContext->mGenCount;
+        aContext->mKeyArray = (uint32_t *)malloc(sizeof(uint32_t) * aContext->mCount + 1);
+        assert(aContext->mKeyArray != NULL);
+
+        if (patternTakesParam(aContext->mPattern, aContext->mCount, &sDefault, &sMin) == 1) sParam = sDefault;
+
+        if (patternInit(&sGen, aContext->mPattern, aContext->mCount, sParam, (uint64_t)aContext->mSeed) != 0)
+        {
+            (void)fprintf(stderr, "error : malloc fail\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        patternFill(&sGen, 0, aContext->mCount, aContext->mKeyArray);
+        patternDestroy(&sGen);
+
+        aContext->mInput = patternName(aContext->mPattern);
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Processing Command Line Arguments
+ * -----------------------------------------------------------------------------
+ */
+static void printUsageAndExit(char *aProgramName)
+{
+    int32_t i;
+
+    (void)fprintf(stderr, "Usage : %s [ options ] <engine>[,<engine>...] [ <binary_dataset_file> ]\n"
+                          "  -g PATTERN  generate the keys (default random, if no file is given)\n"
+                          "  -n NUM      number of keys to generate (default %d)\n"
+                          "  -s NUM      seed of the generated keys (default 0)\n"
+                          "  -W LIST     comma separated element widths among 4,8,16,32,64 (default 4)\n"
+                          "  -m MODE     comparator : inline, callback or both (default both)\n"
+                          "  -r NUM      measured repetitions (default %d)\n"
+                          "  -w NUM      warmup runs, not measured (default %d)\n"
+                          "  -v          verify sorted array\n"
+                          "  -o csv      results as csv to stdout\n"
+                          "  Engines :\n"
+                          "        all\n",
+                          aProgramName, PERFCXX_DEFAULT_GEN_CNT, PERFCXX_DEFAULT_REPEAT_CNT,
+                          PERFCXX_DEFAULT_WARMUP_CNT);
+
+    for (i = 0; i < CXX_ENGINE_MAX; i++)
+    {
+        (void)fprintf(stderr, "        %-10s : %s%s%s\n",
+                      gEngine[i].mName, gEngine[i].mDesc,
+                      gEngine[i].mHasInline == 1 ? "" : ", callback only",
+                      gEngine[i].mAvailable == 1 ? "" : " (not built in : needs TBB)");
+    }
+
+    exit(1);
+}
+
+static int32_t processArgGetInteger(char *aProgramName, char *aOption, char *aValue, int32_t aMin)
+{
+    long  sValue;
+    char *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtol(aValue, &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue < aMin || sValue > INT32_MAX || *sEndPtr != '\0' || sEndPtr == aValue)
+    {
+        (void)fprintf(stderr, "error : option '%s' accepts an integer of at least %d.\n", aOption, aMin);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return (int32_t)sValue;
+}
+
+static void processArgDetermineEngine(char *aProgramName, char *aEngineList, cxxContext *aContext)
+{
+    char    *sName;
+    char    *sSavePtr = NULL;
+    int32_t  i;
+
+    for (sName = strtok_r(aEngineList, ",", &sSavePtr); sName != NULL; sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        for (i = 0; i < CXX_ENGINE_MAX; i++)
+        {
+            if (strcmp(sName, "all") == 0 ? gEngine[i].mAvailable == 1 : strcmp(sName, gEngine[i].mName) == 0)
+            {
+                if (gEngine[i].mAvailable == 0)
+                {
+                    (void)fprintf(stderr, "error : '%s' is not built in. Build with TBB for the parallel algorithms.\n",
+                                  sName);
+                    exit(1);
+                }
+                else
+                {
+                }
+
+                aContext->mEngineSelected[i] = 1;
+
+                if (strcmp(sName, "all") != 0) break;
+            }
+            else
+            {
+            }
+        }
+
+        if (strcmp(sName, "all") != 0 && i == CXX_ENGINE_MAX)
+        {
+            (void)fprintf(stderr, "error : unknown engine '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+    }
+}
+
+static void processArgDetermineWidth(char *aProgramName, char *aOption, char *aWidthList, cxxContext *aContext)
+{
+    char *sWidth;
+    char *sSavePtr = NULL;
+
+    if (aWidthList == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    for (sWidth = strtok_r(aWidthList, ",", &sSavePtr); sWidth != NULL; sWidth = strtok_r(NULL, ",", &sSavePtr))
+    {
+        int32_t sValue = processArgGetInteger(aProgramName, aOption, sWidth, 4);
+
+        if (sValue != 4 && sValue != 8 && sValue != 16 && sValue != 32 && sValue != 64)
+        {
+            (void)fprintf(stderr, "error : width %d is not instantiated. Use 4, 8, 16, 32 or 64.\n", sValue);
+            exit(1);
+        }
+        else if (aContext->mWidthCnt >= PERFCXX_MAX_WIDTH_CNT)
+        {
+            (void)fprintf(stderr, "error : too many widths.\n");
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        aContext->mWidth[aContext->mWidthCnt++] = sValue;
+    }
+}
+
+static void processArg(int32_t aArgc, char *aArgv[], cxxContext *aContext)
+{
+    char    *sEngineList = NULL;
+    int32_t  i;
+
+    for (i = 1; i < aArgc; i++)
+    {
+        char *sValue = (i + 1 < aArgc) ? aArgv[i + 1] : NULL;
+
+        if (strcmp(aArgv[i], "-g") == 0)
+        {
+            aContext->mPattern = sValue != NULL ? patternFind(sValue) : PATTERN_NONE;
+
+            if (aContext->mPattern == PATTERN_NONE)
+            {
+                (void)fprintf(stderr, "error : unknown pattern '%s'.\n", sValue != NULL ? sValue : "");
+                printUsageAndExit(aArgv[0]);
+            }
+            else
+            {
+            }
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-n") == 0)
+        {
+            aContext->mGenCount = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-s") == 0)
+        {
+            aContext->mSeed = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-W") == 0)
+        {
+            processArgDetermineWidth(aArgv[0], aArgv[i], sValue, aContext);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-m") == 0)
+        {
+            if (sValue != NULL && strcmp(sValue, "inline") == 0)
+            {
+                aContext->mModeSelected[CXX_CMP_CALLBACK] = 0;
+            }
+            else if (sValue != NULL && strcmp(sValue, "callback") == 0)
+            {
+                aContext->mModeSelected[CXX_CMP_INLINE] = 0;
+            }
+            else if (sValue == NULL || strcmp(sValue, "both") != 0)
+            {
+                printUsageAndExit(aArgv[0]);
+            }
+            else
+            {
+            }
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-r") == 0)
+        {
+            aContext->mRepeatCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-w") == 0)
+        {
+            aContext->mWarmupCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-v") == 0)
+        {
+            aContext->mDoVerify = 1;
+        }
+        else if (strcmp(aArgv[i], "-o") == 0)
+        {
+            if (sValue == NULL || strcmp(sValue, "csv") != 0) printUsageAndExit(aArgv[0]);
+
+            aContext->mCsv = 1;
+            i++;
+        }
+        else if (aArgv[i][0] == '-')
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+        else if (sEngineList == NULL)
+        {
+            sEngineList = aArgv[i];
+        }
+        else if (aContext->mFileName == NULL)
+        {
+            aContext->mFileName = aArgv[i];
+        }
+        else
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+    }
+
+    if (sEngineList == NULL) printUsageAndExit(aArgv[0]);
+
+    if (aContext->mFileName != NULL && (aContext->mPattern != PATTERN_NONE || aContext->mGenCount >= 0))
+    {
+        (void)fprintf(stderr, "error : either generate the keys with '-g' or read them from a file.\n");
+        printUsageAndExit(aArgv[0]);
+    }
+    else
+    {
+    }
+
+    processArgDetermineEngine(aArgv[0], sEngineList, aContext);
+
+    if (aContext->mPattern == PATTERN_NONE) aContext->mPattern  = PATTERN_RANDOM;
+    if (aContext->mGenCount < 0)            aContext->mGenCount = PERFCXX_DEFAULT_GEN_CNT;
+    if (aContext->mSeed < 0)                aContext->mSeed     = 0;
+
+    if (aContext->mWidthCnt == 0)
+    {
+        aContext->mWidth[0] = 4;
+        aContext->mWidthCnt = 1;
+    }
+    else
+    {
+    }
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Main
+ * -----------------------------------------------------------------------------
+ */
+int32_t main(int32_t aArgc, char *aArgv[])
+{
+    /* large : holds the results */
+    static cxxContext sContext;
+
+    int32_t i;
+
+    sContext.mFileName  = NULL;
+    sContext.mPattern   = PATTERN_NONE;
+    sContext.mGenCount  = -1;
+    sContext.mSeed      = -1;
+    sContext.mWidthCnt  = 0;
+    sContext.mRepeatCnt = PERFCXX_DEFAULT_REPEAT_CNT;
+    sContext.mWarmupCnt = PERFCXX_DEFAULT_WARMUP_CNT;
+    sContext.mDoVerify  = 0;
+    sContext.mCsv       = 0;
+    sContext.mResultCnt = 0;
+
+    for (i = 0; i < CXX_ENGINE_MAX; i++)
+    {
+        sContext.mEngineSelected[i] = 0;
+    }
+
+    for (i = 0; i < CXX_CMP_MAX; i++)
+    {
+        sContext.mModeSelected[i] = 1;
+    }
+
+    processArg(aArgc, aArgv, &sContext);
+
+    cxxLoadKeys(&sContext);
+
+    (void)fprintf(stderr, "Start sorting...\n");
+
+    cxxRun(&sContext);
+
+    (void)fprintf(stderr, "Completed sorting.\n");
+
+    cxxPrintReport(&sContext);
+
+    if (sContext.mCsv == 1) cxxWriteCsv(&sContext);
+
+    free(sContext.mKeyArray);
+
+    return 0;
+}
@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "timconf.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Profile
+ * -----------------------------------------------------------------------------
+ */
+typedef struct timConfEntry
+{
+    size_t   mWidth;
+    timConf  mConf;
+} timConfEntry;
+
+static const timConf   gDefaultConf =
+{
+    TIM_CONF_DEFAULT_MIN_MERGE,
+    TIM_CONF_DEFAULT_MIN_GALLOP,
+    TIM_CONF_DEFAULT_TEMP_SIZE,
+    TIM_CONF_DEFAULT_ADDRESSING,
+    TIM_CONF_DEFAULT_MOVE,
+    TIM_CONF_DEFAULT_MERGE,
+    TIM_CONF_DEFAULT_RUN_BLOCK,
+    TIM_CONF_DEFAULT_BUFFER,
+    TIM_CONF_DEFAULT_HUGE_PAGE,
+    TIM_CONF_DEFAULT_HUGE_TLB,
+    TIM_CONF_DEFAULT_STREAM,
+    TIM_CONF_DEFAULT_TAG
+};
+
+/*
+ * Names of the policies in a profile, by value
+ */
+static const char     *gAddressingName[TIM_ADDRESSING_CNT] = { "index", "pointer" };
+static const char     *gMoveName[TIM_MOVE_CNT]             = { "bytes", "block", "fixed" };
+static const char     *gMergeName[TIM_MERGE_CNT]           = { "gallop", "linear" };
+static const char     *gBufferName[TIM_BUFFER_CNT]         = { "run", "pingpong" };
+
+/*
+ * The entries of the profile for this CPU, ascending widths.
+ * Written before the first sort or by timConfLoadProfile(), read only otherwise.
+ */
+static timConfEntry    gProfile[TIM_PROFILE_MAX_ENTRY_CNT];
+static uint32_t        gProfileCnt = 0;
+static pthread_once_t  gProfileOnce = PTHREAD_ONCE_INIT;
+
+void timConfDefault(timConf *aConf)
+{
+    *aConf = gDefaultConf;
+}
+
+/*
+ * Returns what is wrong with aConf, NULL if nothing
+ */
+const char *timConfCheck(const timConf *aConf)
+{
+    if (aConf->mMinMerge < TIM_CONF_MIN_MIN_MERGE || aConf->mMinMerge > TIM_CONF_MAX_MIN_MERGE)
+    {
+        return "minmerge out of range";
+    }
+    else if (aConf->mMinGallop < 1 || aConf->mMinGallop > TIM_CONF_MAX_MIN_GALLOP)
+    {
+        return "mingallop out of range";
+    }
+    else if (aConf->mTempSize < 1 || aConf->mTempSize > TIM_CONF_MAX_TEMP_SIZE)
+    {
+        return "tempsize out of range";
+    }
+    else if (aConf->mAddressing >= TIM_ADDRESSING_CNT)
+    {
+        return "unknown addressing";
+    }
+    else if (aConf->mMove >= TIM_MOVE_CNT)
+    {
+        return "unknown move";
+    }
+    else if (aConf->mMerge >= TIM_MERGE_CNT)
+    {
+        return "unknown merge";
+    }
+    else if (aConf->mRunBlock > TIM_CONF_MAX_RUN_BLOCK)
+    {
+        return "runblock out of range";
+    }
+    else if (aConf->mBuffer >= TIM_BUFFER_CNT)
+    {
+        return "unknown buffer";
+    }
+    else if (aConf->mHugePage > TIM_CONF_MAX_HUGE_PAGE)
+    {
+        return "hugepage out of range";
+    }
+    else if (aConf->mHugeTlb > 1)
+    {
+        return "hugetlb is 0 or 1";
+    }
+    else if (aConf->mStream > TIM_CONF_MAX_STREAM)
+    {
+        return "stream out of range";
+    }
+    else if (aConf->mTag > TIM_CONF_MAX_TAG)
+    {
+        return "tag out of range";
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+/*
+ * "model name" of /proc/cpuinfo, "unknown" where there is none
+ */
+void timConfCpuName(char *aName, size_t aSize)
+{
+    FILE   *sFile;
+    char    sLine[256];
+    char   *sValue;
+    size_t  sLen;
+
+    (void)snprintf(aName, aSize, "unknown");
+
+    sFile = fopen("/proc/cpuinfo", "r");
+
+    if (sFile == NULL) return;
+
+    while (fgets(sLine, sizeof(sLine), sFile) != NULL)
+    {
+        if (strncmp(sLine, "model name", 10) != 0) continue;
+
+        sValue = strchr(sLine, ':');
+
+        if (sValue == NULL) continue;
+
+        sValue += strspn(sValue + 1, " \t") + 1;
+        sLen    = strcspn(sValue, "\r\n");
+
+        (void)snprintf(aName, aSize, "%.*s", (int)sLen, sValue);
+        break;
+    }
+
+    (void)fclose(sFile);
+}
+
+const char *timConfAddressingName(uint32_t aAddressing)
+{
+    return aAddressing < TIM_ADDRESSING_CNT ? gAddressingName[aAddressing] : "?";
+}
+
+const char *timConfMoveName(uint32_t aMove)
+{
+    return aMove < TIM_MOVE_CNT ? gMoveName[aMove] : "?";
+}
+
+const char *timConfMergeName(uint32_t aMerge)
+{
+    return aMerge < TIM_MERGE_CNT ? gMergeName[aMerge] : "?";
+}
+
+const char *timConfBufferName(uint32_t aBuffer)
+{
+    return aBuffer < TIM_BUFFER_CNT ? gBufferName[aBuffer] : "?";
+}
+
+/*
+ * Index of aName in aNameList, aNameCnt if it is not there
+ */
+static uint32_t timConfFindName(const char *aName, const char **aNameList, uint32_t aNameCnt)
+{
+    uint32_t i;
+
+    for (i = 0; i < aNameCnt; i++)
+    {
+        if (strcmp(aName, aNameList[i]) == 0) break;
+    }
+
+    return i;
+}
+
+/*
+ * Reads a width line, cut into words in place, into aWidth and aConf.
+ * Settings it leaves out are the defaults.
+ * Returns what is wrong with it, NULL if nothing.
+ */
+static const char *timConfParseLine(char *aLine, unsigned long *aWidth, timConf *aConf)
+{
+    char          *sSave;
+    char          *sKey;
+    char          *sValue;
+    char          *sEnd;
+    unsigned long  sNumber;
+
+    *aWidth = 0;
+    *aConf  = gDefaultConf;
+
+    for (sKey = strtok_r(aLine, " \t", &sSave); sKey != NULL; sKey = strtok_r(NULL, " \t", &sSave))
+    {
+        sValue = strtok_r(NULL, " \t", &sSave);
+
+        if (sValue == NULL) return "setting without a value";
+
+        if (strcmp(sKey, "addressing") == 0)
+        {
+            aConf->mAddressing = timConfFindName(sValue, gAddressingName, TIM_ADDRESSING_CNT);
+            continue;
+        }
+        else if (strcmp(sKey, "move") == 0)
+        {
+            aConf->mMove = timConfFindName(sValue, gMoveName, TIM_MOVE_CNT);
+            continue;
+        }
+        else if (strcmp(sKey, "merge") == 0)
+        {
+            aConf->mMerge = timConfFindName(sValue, gMergeName, TIM_MERGE_CNT);
+            continue;
+        }
+        else if (strcmp(sKey, "buffer") == 0)
+        {
+            aConf->mBuffer = timConfFindName(sValue, gBufferName, TIM_BUFFER_CNT);
+            continue;
+        }
+        else
+        {
+        }
+
+        errno   = 0;
+        sNumber = strtoul(sValue, &sEnd, 10);
+
+        if (sEnd == sValue || *sEnd != '\0' || errno != 0 || sNumber > UINT32_MAX) return "not a number";
+
+        if (strcmp(sKey, "width") == 0)
+        {
+            *aWidth = sNumber;
+        }
+        else if (strcmp(sKey, "minmerge") == 0)
+        {
+            aConf->mMinMerge = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "mingallop") == 0)
+        {
+            aConf->mMinGallop = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "tempsize") == 0)
+        {
+            aConf->mTempSize = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "runblock") == 0)
+        {
+            aConf->mRunBlock = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "hugepage") == 0)
+        {
+            aConf->mHugePage = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "hugetlb") == 0)
+        {
+            aConf->mHugeTlb = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "stream") == 0)
+        {
+            aConf->mStream = (uint32_t)sNumber;
+        }
+        else if (strcmp(sKey, "tag") == 0)
+        {
+            aConf->mTag = (uint32_t)sNumber;
+        }
+        else
+        {
+            return "unknown setting";
+        }
+    }
+
+    return *aWidth == 0 ? "width out of range" : timConfCheck(aConf);
+}
+
+static int timConfCompareEntry(const void *aEntry1, const void *aEntry2)
+{
+    size_t sWidth1 = ((const timConfEntry *)aEntry1)->mWidth;
+    size_t sWidth2 = ((const timConfEntry *)aEntry2)->mWidth;
+
+    return (sWidth1 > sWidth2) - (sWidth1 < sWidth2);
+}
+
+/*
+ * Loads the entries of aFileName for this CPU in place of the current ones.
+ * On error, returns -1 with a message in aError and keeps the current ones.
+ */
+static int32_t timConfReadProfile(const char *aFileName, char *aError, size_t aErrorSize)
+{
+    timConfEntry  sEntry[TIM_PROFILE_MAX_ENTRY_CNT];
+    uint32_t      sEntryCnt = 0;
+    char          sCpuName[TIM_CPU_NAME_LEN];
+    char          sLine[256];
+    int32_t       sForThisCpu = 0;
+    uint32_t      sLineNo = 0;
+    char          sWords[256];
+    unsigned long sWidth;
+    timConf       sConf;
+    const char   *sError;
+    FILE         *sFile;
+    size_t        sLen;
+
+    timConfCpuName(sCpuName, sizeof(sCpuName));
+
+    sFile = fopen(aFileName, "r");
+
+    if (sFile == NULL)
+    {
+        (void)snprintf(aError, aErrorSize, "cannot open '%s'. %s (errno %d)", aFileName, strerror(errno), errno);
+        return -1;
+    }
+    else
+    {
+    }
+
+    while (fgets(sLine, sizeof(sLine), sFile) != NULL)
+    {
+        sLineNo++;
+        sLen = strcspn(sLine, "\r\n");
+        sLine[sLen] = '\0';
+
+        if (sLineNo == 1 && strcmp(sLine, TIM_PROFILE_MAGIC) != 0)
+        {
+            (void)snprintf(aError, aErrorSize, "'%s' is not a timsort profile", aFileName);
+            (void)fclose(sFile);
+            return -1;
+        }
+        else if (sLine[0] == '#' || sLine[0] == '\0')
+        {
+            continue;
+        }
+        else if (strncmp(sLine, "cpu ", 4) == 0)
+        {
+            sForThisCpu = strcmp(sLine + 4, "*") == 0 || strcmp(sLine + 4, sCpuName) == 0;
+        }
+        else if (strncmp(sLine, "width ", 6) == 0)
+        {
+            memcpy(sWords, sLine, sLen + 1);
+
+            sError = timConfParseLine(sWords, &sWidth, &sConf);
+
+            if (sError != NULL)
+            {
+                (void)snprintf(aError, aErrorSize, "%s:%u : %s in '%s'", aFileName, sLineNo, sError, sLine);
+                (void)fclose(sFile);
+                return -1;
+            }
+            else
+            {
+            }
+
+            if (sForThisCpu == 0) continue;
+
+            if (sEntryCnt >= TIM_PROFILE_MAX_ENTRY_CNT)
+            {
+                (void)snprintf(aError, aErrorSize, "%s:%u : more than %d widths", aFileName, sLineNo,
+                               TIM_PROFILE_MAX_ENTRY_CNT);
+                (void)fclose(sFile);
+                return -1;
+            }
+            else
+            {
+            }
+
+            sEntry[sEntryCnt].mWidth = sWidth;
+            sEntry[sEntryCnt].mConf  = sConf;
+            sEntryCnt++;
+        }
+        else
+        {
+            (void)snprintf(aError, aErrorSize, "%s:%u : cannot parse '%s'", aFileName, sLineNo, sLine);
+            (void)fclose(sFile);
+            return -1;
+        }
+    }
+
+    (void)fclose(sFile);
+
+    if (sLineNo == 0)
+    {
+        (void)snprintf(aError, aErrorSize, "'%s' is empty", aFileName);
+        return -1;
+    }
+    else
+    {
+    }
+
+    qsort(sEntry, sEntryCnt, sizeof(timConfEntry), timConfCompareEntry);
+
+    memcpy(gProfile, sEntry, sizeof(timConfEntry) * sEntryCnt);
+    gProfileCnt = sEntryCnt;
+
+    return 0;
+}
+
+static void timConfLoadEnvProfile(void)
+{
+    const char *sFileName = getenv(TIM_PROFILE_ENV);
+    char        sError[512];
+
+    if (sFileName == NULL || sFileName[0] == '\0') return;
+
+    if (timConfReadProfile(sFileName, sError, sizeof(sError)) != 0)
+    {
+        (void)fprintf(stderr, "warning : %s : %s, using the defaults.\n", TIM_PROFILE_ENV, sError);
+    }
+    else
+    {
+    }
+}
+
+/*
+ * To be called before sorting in other threads
+ */
+int32_t timConfLoadProfile(const char *aFileName, char *aError, size_t aErrorSize)
+{
+    /* not to be replaced by the profile of the environment by the first sort */
+    (void)pthread_once(&gProfileOnce, timConfLoadEnvProfile);
+
+    return timConfReadProfile(aFileName, aError, aErrorSize);
+}
+
+/*
+ * The settings for elements of aWidth bytes
+ */
+const timConf *timConfGet(size_t aWidth)
+{
+    uint32_t i;
+
+    (void)pthread_once(&gProfileOnce, timConfLoadEnvProfile);
+
+    if (gProfileCnt == 0) return &gDefaultConf;
+
+    for (i = gProfileCnt; i > 1; i--)
+    {
+        if (gProfile[i - 1].mWidth <= aWidth) break;
+    }
+
+    return &gProfile[i - 1].mConf;
+}
@@ -0,0 +1,114 @@
+#ifndef __TIM_CONF_H__
+#define __TIM_CONF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Tunables of timsort() and timsort1(), once MIN_MERGE, TIM_MIN_GALLOP and
+ * TIM_MERGE_TEMP_ARRAY_SIZE, and the policies of the engine (see timsort.c).
+ * timsort1() takes the numbers only, its policies are pointer, bytes, gallop
+ * and run, and it forms no blocks and sorts no tags.
+ *
+ * The sorts take them from a profile written by timtune, for the width of
+ * the elements and the CPU the program runs on. The profile named by the
+ * TIMSORT_PROFILE environment variable is loaded by the first sort, or
+ * timConfLoadProfile() loads one explicitly. Without a profile, or for a CPU
+ * it does not know, the defaults below are used.
+ *
+ * Profile, one setting per line :
+ *
+ *      #timsort-profile 1
+ *      cpu <model name, as in /proc/cpuinfo, or * for any>
+ *      width <bytes> minmerge <n> mingallop <n> tempsize <n> [ addressing <a> move <m> merge <g> ]
+ *            [ runblock <KiB> ] [ buffer <b> ] [ hugepage <KiB> hugetlb <0|1> ] [ stream <KiB> ]
+ *            [ tag <bytes> ]
+ *      ...
+ *
+ * A width line belongs to the cpu line above it. A width that is not listed
+ * takes the line of the largest width below it, or of the smallest one.
+ * Settings a line leaves out are the defaults.
+ */
+typedef struct timConf
+{
+    uint32_t  mMinMerge;    /* arrays shorter than this are binary sorted,
+                               runs are extended to between half of it and it */
+    uint32_t  mMinGallop;   /* wins in a row after which a merge starts galloping */
+    uint32_t  mTempSize;    /* elements of merge memory each sort preallocates */
+    uint32_t  mAddressing;  /* TIM_ADDRESSING_xxx : how runs are scanned and insertion sorted */
+    uint32_t  mMove;        /* TIM_MOVE_xxx : how elements are moved */
+    uint32_t  mMerge;       /* TIM_MERGE_xxx : whether merges gallop */
+    uint32_t  mRunBlock;    /* KiB of the blocks short runs are merged into before the
+                               main merges, 0 : none (see timsort.c, Run Formation) */
+    uint32_t  mBuffer;      /* TIM_BUFFER_xxx : where merges put the runs */
+    uint32_t  mHugePage;    /* KiB from which merge memory is of 2MB pages, 0 : never */
+    uint32_t  mHugeTlb;     /* 1 : hugetlbfs pages if the system has some reserved,
+                               transparent huge pages otherwise */
+    uint32_t  mStream;      /* KiB of merged output from which merges store around the
+                               caches, 0 : never. x86-64 builds of fixed moves only */
+    uint32_t  mTag;         /* width from which pointers to the elements are sorted and the
+                               elements then permuted, 0 : never (see timdispatch.c, Tag Sort) */
+} timConf;
+
+/*
+ * Policies. Numbers, as the Makefile builds the engine with them (-DTIM_ADDRESSING, -DTIM_MOVE).
+ */
+#define TIM_ADDRESSING_INDEX            0   /* indexes into the array */
+#define TIM_ADDRESSING_POINTER          1   /* pointers */
+#define TIM_ADDRESSING_CNT              2
+
+#define TIM_MOVE_BYTES                  0   /* byte by byte */
+#define TIM_MOVE_BLOCK                  1   /* memcpy() of the width */
+#define TIM_MOVE_FIXED                  2   /* 4, 8 and 16 bytes by one load and store, others as block */
+#define TIM_MOVE_CNT                    3
+
+#define TIM_MERGE_GALLOP                0   /* gallop after mMinGallop wins in a row */
+#define TIM_MERGE_LINEAR                1   /* one element at a time */
+#define TIM_MERGE_CNT                   2
+
+#define TIM_BUFFER_RUN                  0   /* the shorter run is copied out, merged back */
+#define TIM_BUFFER_PINGPONG             1   /* a buffer of n elements, merges go between it
+                                               and the array, about a third fewer moves */
+#define TIM_BUFFER_CNT                  2
+
+#define TIM_CONF_DEFAULT_MIN_MERGE      64
+#define TIM_CONF_DEFAULT_MIN_GALLOP     7
+#define TIM_CONF_DEFAULT_TEMP_SIZE      256
+#define TIM_CONF_DEFAULT_ADDRESSING     TIM_ADDRESSING_POINTER
+#define TIM_CONF_DEFAULT_MOVE           TIM_MOVE_FIXED
+#define TIM_CONF_DEFAULT_MERGE          TIM_MERGE_GALLOP
+#define TIM_CONF_DEFAULT_RUN_BLOCK      0
+#define TIM_CONF_DEFAULT_BUFFER         TIM_BUFFER_RUN
+#define TIM_CONF_DEFAULT_HUGE_PAGE      4096
+#define TIM_CONF_DEFAULT_HUGE_TLB       0
+#define TIM_CONF_DEFAULT_STREAM         0
+#define TIM_CONF_DEFAULT_TAG            512
+
+#define TIM_CONF_MIN_MIN_MERGE          4
+#define TIM_CONF_MAX_MIN_MERGE          4096
+#define TIM_CONF_MAX_MIN_GALLOP         1024
+#define TIM_CONF_MAX_TEMP_SIZE          (1 << 24)
+#define TIM_CONF_MAX_RUN_BLOCK          (1 << 20)
+#define TIM_CONF_MAX_HUGE_PAGE          (1 << 24)
+#define TIM_CONF_MAX_STREAM             (1 << 30)
+#define TIM_CONF_MAX_TAG                (1 << 30)
+
+#define TIM_PROFILE_ENV                 "TIMSORT_PROFILE"
+#define TIM_PROFILE_MAGIC               "#timsort-profile 1"
+#define TIM_PROFILE_MAX_ENTRY_CNT       64
+#define TIM_CPU_NAME_LEN                128
+
+void            timConfDefault(timConf *aConf);
+const char     *timConfCheck(const timConf *aConf);
+
+const timConf  *timConfGet(size_t aWidth);
+int32_t         timConfLoadProfile(const char *aFileName, char *aError, size_t aErrorSize);
+
+void            timConfCpuName(char *aName, size_t aSize);
+
+const char     *timConfAddressingName(uint32_t aAddressing);
+const char     *timConfMoveName(uint32_t aMove);
+const char     *timConfMergeName(uint32_t aMerge);
+const char     *timConfBufferName(uint32_t aBuffer);
+
+#endif
@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "timsort.h"
+#include "timsort1.h"
+#include "timisa.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Builds
+ * -----------------------------------------------------------------------------
+ */
+typedef void timConfSortFunc(void *, size_t, size_t, int (*)(const void *, const void *), const timConf *, timStat *);
+
+/*
+ * Builds of one instruction set, by addressing and move policy.
+ * Moves : bytes, block, then the widths TIM_MOVE_FIXED has a build of.
+ */
+#define TIM_MOVE_BUILD_CNT          5
+#define TIM_MOVE_BUILD_FIXED        2
+
+static const size_t gFixedWidth[TIM_MOVE_BUILD_CNT] = { 0, 0, 4, 8, 16 };
+
+#define TIM_ISA_DECLARE(_aIsa)                                                          \
+    timConfSortFunc timsortEngine_index_bytes_ ## _aIsa;                                \
+    timConfSortFunc timsortEngine_index_block_ ## _aIsa;                                \
+    timConfSortFunc timsortEngine_index_w4_ ## _aIsa;                                   \
+    timConfSortFunc timsortEngine_index_w8_ ## _aIsa;                                   \
+    timConfSortFunc timsortEngine_index_w16_ ## _aIsa;                                  \
+    timConfSortFunc timsortEngine_pointer_bytes_ ## _aIsa;                              \
+    timConfSortFunc timsortEngine_pointer_block_ ## _aIsa;                              \
+    timConfSortFunc timsortEngine_pointer_w4_ ## _aIsa;                                 \
+    timConfSortFunc timsortEngine_pointer_w8_ ## _aIsa;                                 \
+    timConfSortFunc timsortEngine_pointer_w16_ ## _aIsa
+
+#define TIM_ISA_ENGINES(_aIsa)                                                          \
+    {                                                                                   \
+        { timsortEngine_index_bytes_ ## _aIsa,   timsortEngine_index_block_ ## _aIsa,   \
+          timsortEngine_index_w4_ ## _aIsa,      timsortEngine_index_w8_ ## _aIsa,      \
+          timsortEngine_index_w16_ ## _aIsa },                                          \
+        { timsortEngine_pointer_bytes_ ## _aIsa, timsortEngine_pointer_block_ ## _aIsa, \
+          timsortEngine_pointer_w4_ ## _aIsa,    timsortEngine_pointer_w8_ ## _aIsa,    \
+          timsortEngine_pointer_w16_ ## _aIsa }                                         \
+    }
+
+TIM_ISA_DECLARE(generic);
+#ifdef TIM_HAVE_ISA_X86
+TIM_ISA_DECLARE(sse42);
+TIM_ISA_DECLARE(avx2);
+TIM_ISA_DECLARE(avx512);
+#endif
+
+typedef struct timIsaBuild
+{
+    const char       *mName;
+    const char       *mLevel;       /* for __builtin_cpu_supports(), NULL : every CPU */
+    timConfSortFunc  *mEngine[TIM_ADDRESSING_CNT][TIM_MOVE_BUILD_CNT];
+} timIsaBuild;
+
+/*
+ * Ascending levels, the last one the CPU supports is taken
+ */
+static const timIsaBuild gBuild[] =
+{
+    { "generic", NULL,        TIM_ISA_ENGINES(generic) },
+#ifdef TIM_HAVE_ISA_X86
+    { "sse4.2",  "x86-64-v2", TIM_ISA_ENGINES(sse42)   },
+    { "avx2",    "x86-64-v3", TIM_ISA_ENGINES(avx2)    },
+    { "avx512",  "x86-64-v4", TIM_ISA_ENGINES(avx512)  },
+#endif
+    { NULL,      NULL,        { { NULL } }             }
+};
+
+static const timIsaBuild *gSelected = &gBuild[0];
+static pthread_once_t     gSelectOnce = PTHREAD_ONCE_INIT;
+
+static int32_t timIsaSupported(const timIsaBuild *aBuild)
+{
+    if (aBuild->mLevel == NULL) return 1;
+
+#ifdef TIM_HAVE_ISA_X86
+    __builtin_cpu_init();
+
+    if (strcmp(aBuild->mLevel, "x86-64-v2") == 0) return __builtin_cpu_supports("x86-64-v2") != 0;
+    if (strcmp(aBuild->mLevel, "x86-64-v3") == 0) return __builtin_cpu_supports("x86-64-v3") != 0;
+    if (strcmp(aBuild->mLevel, "x86-64-v4") == 0) return __builtin_cpu_supports("x86-64-v4") != 0;
+#endif
+
+    return 0;
+}
+
+static void timIsaSelect(void)
+{
+    const char *sForced = getenv(TIM_ISA_ENV);
+    uint32_t    i;
+
+    for (i = 0; gBuild[i].mName != NULL; i++)
+    {
+        if (timIsaSupported(&gBuild[i]) == 1)
+        {
+            gSelected = &gBuild[i];
+        }
+        else
+        {
+        }
+    }
+
+    if (sForced == NULL || sForced[0] == '\0') return;
+
+    for (i = 0; gBuild[i].mName != NULL; i++)
+    {
+        if (strcmp(sForced, gBuild[i].mName) == 0) break;
+    }
+
+    if (gBuild[i].mName == NULL)
+    {
+        (void)fprintf(stderr, "warning : %s : unknown instruction set '%s', using %s.\n",
+                      TIM_ISA_ENV, sForced, gSelected->mName);
+    }
+    else if (timIsaSupported(&gBuild[i]) == 0)
+    {
+        (void)fprintf(stderr, "warning : %s : this CPU cannot run %s, using %s.\n",
+                      TIM_ISA_ENV, sForced, gSelected->mName);
+    }
+    else
+    {
+        gSelected = &gBuild[i];
+    }
+}
+
+/*
+ * The build the sorts run, e.g. "avx2"
+ */
+const char *timIsaName(void)
+{
+    (void)pthread_once(&gSelectOnce, timIsaSelect);
+
+    return gSelected->mName;
+}
+
+/*
+ * The build of the policies of aConf for elements of aWidth bytes
+ */
+static timConfSortFunc *timEngineSelect(const timConf *aConf, size_t aWidth)
+{
+    uint32_t sMove;
+
+    (void)pthread_once(&gSelectOnce, timIsaSelect);
+
+    if (aConf->mMove == TIM_MOVE_FIXED)
+    {
+        /* the build of aWidth, block if there is none */
+        for (sMove = TIM_MOVE_BUILD_CNT - 1; sMove > TIM_MOVE_BUILD_FIXED; sMove--)
+        {
+            if (gFixedWidth[sMove] == aWidth) break;
+        }
+
+        if (gFixedWidth[sMove] != aWidth) sMove = TIM_MOVE_BLOCK;
+    }
+    else
+    {
+        sMove = aConf->mMove;
+    }
+
+    return gSelected->mEngine[aConf->mAddressing][sMove];
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Tag Sort
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Elements of mTag bytes or more are not merged themselves : an array of
+ * pointers to them, the tags, is sorted by the engine of the pointer width,
+ * then each element is moved once into its place, cycle by cycle, through
+ * one element of scratch.
+ *
+ *      tags after the sort : [ &a[2] | &a[0] | &a[1] | &a[3] ]
+ *
+ *      cycle from 0 :  hold <- a[0], a[0] <- a[2], a[2] <- a[1], a[1] <- hold
+ *
+ * Merges then move a pointer instead of the element, and the merge memory
+ * is of n/2 pointers, the tags n pointers more. The tags start in the
+ * order of the elements, so the sort stays stable.
+ *
+ * The comparison callback of the tags is that of the elements through a
+ * thread local, saved and restored so that a callback may sort too.
+ */
+static __thread int (*gTagCmpCb)(const void *, const void *) = NULL;
+
+static int timTagCompare(const void *aTag1, const void *aTag2)
+{
+    return (*gTagCmpCb)(*(const void * const *)aTag1, *(const void * const *)aTag2);
+}
+
+/*
+ * Moves the element each tag points to into the place of the tag.
+ * Returns the elements written.
+ */
+static uint64_t timTagPermute(uint8_t *aArray, uint8_t **aTag, size_t aElementCnt, size_t aWidth, uint8_t *aHold)
+{
+    uint64_t sMoveCnt = 0;
+    size_t   sDst;
+    size_t   sSrc;
+    size_t   i;
+
+    for (i = 0; i < aElementCnt; i++)
+    {
+        if (aTag[i] == aArray + i * aWidth) continue;
+
+        /* a place takes the element of its tag, the first one is held until the cycle closes */
+        memcpy(aHold, aArray + i * aWidth, aWidth);
+        sDst = i;
+
+        while (1)
+        {
+            sSrc       = (size_t)(aTag[sDst] - aArray) / aWidth;
+            aTag[sDst] = aArray + sDst * aWidth;
+
+            if (sSrc == i) break;
+
+            memcpy(aArray + sDst * aWidth, aArray + sSrc * aWidth, aWidth);
+            sMoveCnt++;
+            sDst = sSrc;
+        }
+
+        memcpy(aArray + sDst * aWidth, aHold, aWidth);
+        sMoveCnt += 2;
+    }
+
+    return sMoveCnt;
+}
+
+/*
+ * 0 if the tags or the scratch element cannot be allocated, the caller sorts the elements then
+ */
+static int32_t timTagSort(void          *aArray,
+                          size_t         aElementCnt,
+                          size_t         aWidth,
+                          int          (*aCmpCb)(const void *, const void *),
+                          const timConf *aConf,
+                          timStat       *aStat)
+{
+    const timConf  *sConf = aConf != NULL ? aConf : timConfGet(sizeof(void *));
+    uint8_t       **sTag  = malloc(sizeof(uint8_t *) * aElementCnt);
+    uint8_t        *sHold = malloc(aWidth);
+    int           (*sOuterCmpCb)(const void *, const void *) = gTagCmpCb;
+    uint64_t        sMoveCnt;
+    size_t          i;
+
+    if (sTag == NULL || sHold == NULL)
+    {
+        free(sTag);
+        free(sHold);
+
+        return 0;
+    }
+    else
+    {
+    }
+
+    for (i = 0; i < aElementCnt; i++)
+    {
+        sTag[i] = (uint8_t *)aArray + i * aWidth;
+    }
+
+    gTagCmpCb = aCmpCb;
+    (*timEngineSelect(sConf, sizeof(void *)))(sTag, aElementCnt, sizeof(void *), timTagCompare, sConf, aStat);
+    gTagCmpCb = sOuterCmpCb;
+
+    sMoveCnt = timTagPermute((uint8_t *)aArray, sTag, aElementCnt, aWidth, sHold);
+
+    if (aStat != NULL)
+    {
+        aStat->mMergeMemPeak += sizeof(uint8_t *) * aElementCnt;
+
+        if (aStat->mEnabled == 1) aStat->mMoveCnt += sMoveCnt;
+    }
+    else
+    {
+    }
+
+    free(sTag);
+    free(sHold);
+
+    return 1;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Entry Points
+ * -----------------------------------------------------------------------------
+ */
+/*
+ * -1, the array untouched, if aConf does not pass timConfCheck(), as a
+ * profile line that does not is refused by timConfLoadProfile()
+ */
+int32_t timsortConf(void          *aArray,
+                    size_t         aElementCnt,
+                    size_t         aWidth,
+                    int          (*aCmpCb)(const void *, const void *),
+                    const timConf *aConf,
+                    timStat       *aStat)
+{
+    const timConf *sConf = aConf != NULL ? aConf : timConfGet(aWidth);
+
+    if (aConf != NULL && timConfCheck(aConf) != NULL) return -1;
+
+    if (sConf->mTag != 0 && aWidth >= sConf->mTag && aElementCnt > 1 &&
+        timTagSort(aArray, aElementCnt, aWidth, aCmpCb, aConf, aStat) == 1)
+    {
+        return 0;
+    }
+    else
+    {
+    }
+
+    (*timEngineSelect(sConf, aWidth))(aArray, aElementCnt, aWidth, aCmpCb, sConf, aStat);
+
+    return 0;
+}
+
+void timsortStat(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *), timStat *aStat)
+{
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, NULL, aStat);
+}
+
+void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *))
+{
+    (void)timsortConf(aArray, aElementCnt, aWidth, aCmpCb, NULL, NULL);
+}
+
+/*
+ * The policies of the former timsort1.c whatever aConf says, for comparisons.
+ * -1, the array untouched, if aConf does not pass timConfCheck().
+ */
+int32_t timsort1Conf(void          *aArray,
+                     size_t         aElementCnt,
+                     size_t         aWidth,
+                     int          (*aCmpCb)(const void *, const void *),
+                     const timConf *aConf,
+                     timStat       *aStat)
+{
+    timConf sConf;
+
+    if (aConf != NULL && timConfCheck(aConf) != NULL) return -1;
+
+    sConf = *(aConf != NULL ? aConf : timConfGet(aWidth));
+
+    sConf.mAddressing = TIM_ADDRESSING_POINTER;
+    sConf.mMove       = TIM_MOVE_BYTES;
+    sConf.mMerge      = TIM_MERGE_GALLOP;
+    sConf.mRunBlock   = 0;
+    sConf.mBuffer     = TIM_BUFFER_RUN;
+    sConf.mTag        = 0;
+
+    (*timEngineSelect(&sConf, aWidth))(aArray, aElementCnt, aWidth, aCmpCb, &sConf, aStat);
+
+    return 0;
+}
+
+void timsort1Stat(void     *aArray,
+                  size_t    aElementCnt,
+                  size_t    aWidth,
+                  int     (*aCmpCb)(const void *, const void *),
+                  timStat  *aStat)
+{
+    (void)timsort1Conf(aArray, aElementCnt, aWidth, aCmpCb, NULL, aStat);
+}
+
+void timsort1(void    *aArray,
+              size_t   aElementCnt,
+              size_t   aWidth,
+              int    (*aCmpCb)(const void *, const void *))
+{
+    (void)timsort1Conf(aArray, aElementCnt, aWidth, aCmpCb, NULL, NULL);
+}
@@ -0,0 +1,38 @@
+#ifndef __TIM_ISA_H__
+#define __TIM_ISA_H__
+
+#include <stdint.h>
+
+/*
+ * One binary for several CPU generations.
+ *
+ * The Makefile compiles timsort.c once per policy (see timsort.c) and
+ * instruction set, with -DTIM_POLICY=<policy> -DTIM_ISA=<name> and the matching
+ * -march. Each build has the entry point timsortEngine_<policy>_<name>() and
+ * nothing else public. timdispatch.c has timsort(), timsortStat() and
+ * timsortConf(), and the same for timsort1. The first sort picks the best
+ * instruction set the CPU can run, each sort the policy of its settings.
+ *
+ *      generic     whatever CFLAGS is, every CPU
+ *      sse4.2      x86-64-v2 : SSE4.2, POPCNT
+ *      avx2        x86-64-v3 : AVX2, BMI2, FMA
+ *      avx512      x86-64-v4 : AVX-512 F, BW, CD, DQ, VL
+ *
+ * TIMSORT_ISA=<name> in the environment forces one, for benchmarking.
+ * A level the CPU cannot run is refused with a warning.
+ * Without TIM_ISA, as for kernelbench and fuzz, a build is the generic one.
+ */
+#define TIM_ISA_ENV     "TIMSORT_ISA"
+
+#ifndef TIM_ISA
+#define TIM_ISA                         generic
+#endif
+
+#define TIM_ISA_CAT(_aName, _aIsa)      _aName ## _ ## _aIsa
+#define TIM_ISA_EXPAND(_aName, _aIsa)   TIM_ISA_CAT(_aName, _aIsa)
+#define TIM_ISA_NAME(_aName)            TIM_ISA_EXPAND(_aName, TIM_ISA)
+#define TIM_ENGINE_NAME(_aName)         TIM_ISA_NAME(TIM_ISA_EXPAND(_aName, TIM_POLICY))
+
+const char *timIsaName(void);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef __TIM_KERNEL_H__
+#define __TIM_KERNEL_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * The building blocks of timsort() and timsort1(), for kernelbench only.
+ *
+ * They are static in the library. Compiling timsort.c with -DTIM_KERNEL
+ * adds a timKernelSet that calls them on a whole array, one per addressing
+ * policy, with byte moves :
+ *
+ *      mCountRun    : timCountRunAndMakeAscending() on [0, aCount)
+ *      mBinarySort  : timDoBinarySort() on [0, aCount), [0, aSortedCnt) being sorted
+ *      mGallopLeft  : timGallopLeft() with base 0
+ *      mGallopRight : timGallopRight() with base 0
+ *      mMergeLow    : timMergeLow() of [0, aLen1) and [aLen1, aLen1 + aLen2)
+ *      mMergeHigh   : timMergeHigh() of the same
+ *
+ * The merges have the preconditions of timMergeLow() and timMergeHigh() :
+ * the first element of the second run goes before the whole first run and
+ * the last element of the first run after the whole second run.
+ * Every merge starts with mMinGallop at mMinGallop of the settings.
+ */
+typedef int timKernelCmp(const void *, const void *);
+
+typedef struct timKernelSet
+{
+    const char  *mName;
+
+    void       *(*mCreate)(size_t aWidth);
+    void        (*mDestroy)(void *aState);
+
+    size_t      (*mCountRun)(void *aState, void *aArray, size_t aCount, timKernelCmp *aCmpCb);
+    void        (*mBinarySort)(void         *aState,
+                               void         *aArray,
+                               size_t        aCount,
+                               size_t        aSortedCnt,
+                               timKernelCmp *aCmpCb);
+    int32_t     (*mGallopLeft)(const void   *aKey,
+                               const void   *aArray,
+                               size_t        aWidth,
+                               int32_t       aLen,
+                               int32_t       aHint,
+                               timKernelCmp *aCmpCb);
+    int32_t     (*mGallopRight)(const void   *aKey,
+                                const void   *aArray,
+                                size_t        aWidth,
+                                int32_t       aLen,
+                                int32_t       aHint,
+                                timKernelCmp *aCmpCb);
+    void        (*mMergeLow)(void *aState, void *aArray, size_t aLen1, size_t aLen2, timKernelCmp *aCmpCb);
+    void        (*mMergeHigh)(void *aState, void *aArray, size_t aLen1, size_t aLen2, timKernelCmp *aCmpCb);
+} timKernelSet;
+
+extern const timKernelSet gTimKernelIndex;      /* TIM_ADDRESSING_INDEX */
+extern const timKernelSet gTimKernelPointer;    /* TIM_ADDRESSING_POINTER */
+
+#endif
@@ -1,19 +1,122 @@
 #include "timsort.h"
+#include "timisa.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 typedef int cmpFunc(const void *, const void *);
 
-#define TIM_MERGE_TEMP_ARRAY_SIZE   256
 #define TIM_MAX_PENDING_RUN_CNT     85
-#define TIM_MIN_GALLOP              7
+
+#define TIM_HUGE_PAGE_SIZE          ((size_t)2 << 20)
+
+/*
+ * MIN_MERGE, MIN_GALLOP and the size of the preallocated merge memory are
+ * in mConf of the merge state, see timconf.h.
+ * Python's timsort uses a MIN_MERGE of 64, the Java implementation 32.
+ */
+
+/*
+ * Work counters, see timstat.h
+ */
+#ifdef TIM_STAT
+#define TIM_STAT_ENABLED                            1
+#define TIM_STAT_ADD(_aState, _aField, _aCount)     ((_aState)->mStat._aField += (_aCount))
+#define TIM_STAT_MAX(_aState, _aField, _aValue)     \
+    ((_aState)->mStat._aField = (_aValue) > (_aState)->mStat._aField ? (_aValue) : (_aState)->mStat._aField)
+#else
+#define TIM_STAT_ENABLED                            0
+#define TIM_STAT_ADD(_aState, _aField, _aCount)     do { } while (0)
+#define TIM_STAT_MAX(_aState, _aField, _aValue)     do { } while (0)
+#endif
 
 /*
- * MIN_MERGE : The minimun size that an array will be merged.
- *             Python's timsort : 64
- *             Java implementation : 32
- *             One should test and determine its value.
+ * The peak of the merge memory is kept in every build : the buffers
+ * timAllocBuffer() maps are out of sight of a malloc() that counts
  */
-#define MIN_MERGE   64
+#define TIM_MERGE_MEM_PEAK(_aState, _aBytes)        \
+    ((_aState)->mStat.mMergeMemPeak = (_aBytes) > (_aState)->mStat.mMergeMemPeak ? (_aBytes) : (_aState)->mStat.mMergeMemPeak)
+
+
+/*
+ * Policies, given by the Makefile for each build of this file :
+ *
+ *      TIM_POLICY      the name of the build, <addressing>_<move>, e.g. pointer_w8
+ *      TIM_ADDRESSING  how runs are scanned, reversed and insertion sorted.
+ *                      TIM_ADDRESSING_INDEX : through indexes into the array (once timsort.c),
+ *                      TIM_ADDRESSING_POINTER : through pointers (once timsort1.c).
+ *                      The merges are the same for both.
+ *      TIM_MOVE        how an element is moved.
+ *                      TIM_MOVE_BYTES : byte by byte, any width.
+ *                      TIM_MOVE_BLOCK : memcpy() of the width, any width.
+ *                      TIM_MOVE_FIXED : elements of exactly TIM_MOVE_WIDTH bytes (4, 8 or 16),
+ *                      memcpy() of a constant size, which compiles to one load and one store.
+ *
+ * The merge policy is mMerge of timConf, chosen at runtime : galloping merges,
+ * or linear ones that never gallop within a merge (see timMinGallop()).
+ * So is the merge buffer, mBuffer : the shorter run is copied out before each
+ * merge, or the merges go back and forth between the array and a buffer as
+ * large as it (see timMergePingPong()).
+ * timdispatch.c runs the build that the settings for the width ask for.
+ */
+#ifndef TIM_POLICY
+#define TIM_POLICY                  pointer_bytes
+#define TIM_ADDRESSING              TIM_ADDRESSING_POINTER
+#define TIM_MOVE                    TIM_MOVE_BYTES
+#endif
+
+#define TIM_SWAP_CHUNK              64
+
+#if TIM_MOVE == TIM_MOVE_FIXED
+
+#define TIM_WIDTH(_aState)          ((size_t)TIM_MOVE_WIDTH)
+
+#define COPY(_aDst, _aSrc, _aWidth) memcpy((_aDst), (_aSrc), TIM_MOVE_WIDTH)
+
+#define SWAP(_aArg1, _aArg2, _aWidth)                                               \
+    do                                                                              \
+    {                                                                               \
+        uint8_t _sTmp[TIM_MOVE_WIDTH];                                              \
+                                                                                    \
+        memcpy(_sTmp, (_aArg1), TIM_MOVE_WIDTH);                                    \
+        memcpy((_aArg1), (_aArg2), TIM_MOVE_WIDTH);                                 \
+        memcpy((_aArg2), _sTmp, TIM_MOVE_WIDTH);                                    \
+    } while (0)
+
+#elif TIM_MOVE == TIM_MOVE_BLOCK
+
+#define TIM_WIDTH(_aState)          ((_aState)->mWidth)
+
+#define COPY(_aDst, _aSrc, _aWidth) memcpy((_aDst), (_aSrc), (_aWidth))
+
+/* through a buffer on the stack, TIM_SWAP_CHUNK bytes at a time */
+#define SWAP(_aArg1, _aArg2, _aWidth)                                               \
+    do                                                                              \
+    {                                                                               \
+        uint8_t  _sTmp[TIM_SWAP_CHUNK];                                             \
+        uint8_t *_sArg1  = (uint8_t *)(_aArg1);                                     \
+        uint8_t *_sArg2  = (uint8_t *)(_aArg2);                                     \
+        size_t   _sWidth = (_aWidth);                                               \
+        size_t   _sLen;                                                             \
+                                                                                    \
+        while (_sWidth > 0)                                                         \
+        {                                                                           \
+            _sLen = _sWidth < TIM_SWAP_CHUNK ? _sWidth : TIM_SWAP_CHUNK;            \
+                                                                                    \
+            memcpy(_sTmp, _sArg1, _sLen);                                           \
+            memcpy(_sArg1, _sArg2, _sLen);                                          \
+            memcpy(_sArg2, _sTmp, _sLen);                                           \
+                                                                                    \
+            _sArg1  += _sLen;                                                       \
+            _sArg2  += _sLen;                                                       \
+            _sWidth -= _sLen;                                                       \
+        }                                                                           \
+    } while (0)
 
+#else
+
+#define TIM_WIDTH(_aState)          ((_aState)->mWidth)
 
 #define COPY(_aDst, _aSrc, _aWidth)                                                 \
     do                                                                              \
@@ -27,10 +130,98 @@ typedef int cmpFunc(const void *, const void *);
         } while (_sWidth > 0);                                                      \
     } while (0)
 
+#define SWAP(_aArg1, _aArg2, _aWidth)                                               \
+    do                                                                              \
+    {                                                                               \
+        register size_t   _sWidth = (_aWidth);                                      \
+        register uint8_t *_sArg1  = (uint8_t *)(_aArg1);                            \
+        register uint8_t *_sArg2  = (uint8_t *)(_aArg2);                            \
+                                                                                    \
+        do                                                                          \
+        {                                                                           \
+            uint8_t _sTmp = *_sArg1;                                                \
+                                                                                    \
+            *_sArg1++ = *_sArg2;                                                    \
+            *_sArg2++ = _sTmp;                                                      \
+        } while (--_sWidth > 0);                                                    \
+    } while (0)
+
+#endif
+
+/*
+ * Stores of the merges of mConf.mStream KiB or more (see timIsStream()) :
+ * non-temporal, so that merges far larger than the last level cache neither
+ * evict what is in it nor read every line before overwriting it, with both
+ * runs prefetched ahead. Fixed moves of x86-64 builds only, movnti of 4 or 8
+ * bytes having no alignment to respect; other builds store as usual.
+ */
+#if TIM_MOVE == TIM_MOVE_FIXED && defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define TIM_HAVE_STREAM             1
+
+#if TIM_MOVE_WIDTH == 4
+#define STREAM(_aDst, _aSrc)                                                        \
+    do                                                                              \
+    {                                                                               \
+        int _sWord;                                                                 \
+                                                                                    \
+        memcpy(&_sWord, (_aSrc), 4);                                                \
+        _mm_stream_si32((int *)(_aDst), _sWord);                                    \
+    } while (0)
+#else
+#define STREAM(_aDst, _aSrc)                                                        \
+    do                                                                              \
+    {                                                                               \
+        long long _sWord;                                                           \
+        size_t    _sOffset;                                                         \
+                                                                                    \
+        for (_sOffset = 0; _sOffset < TIM_MOVE_WIDTH; _sOffset += 8)                \
+        {                                                                           \
+            memcpy(&_sWord, (const uint8_t *)(_aSrc) + _sOffset, 8);                \
+            _mm_stream_si64((long long *)((uint8_t *)(_aDst) + _sOffset), _sWord);  \
+        }                                                                           \
+    } while (0)
+#endif
+
+#define TIM_PUT(_aStream, _aDst, _aSrc, _aWidth)                                    \
+    do                                                                              \
+    {                                                                               \
+        if (_aStream) STREAM(_aDst, _aSrc); else COPY(_aDst, _aSrc, _aWidth);       \
+    } while (0)
+
+#define TIM_PUT_BLOCK(_aStream, _aDst, _aSrc, _aSize)                               \
+    do                                                                              \
+    {                                                                               \
+        if (_aStream) timStreamBlock((_aDst), (_aSrc), (_aSize));                   \
+        else memcpy((_aDst), (_aSrc), (_aSize));                                    \
+    } while (0)
+
+/* bytes ahead of the cursors, about the latency of memory at full bandwidth */
+#define TIM_PREFETCH_DISTANCE       512
+
+#define TIM_PREFETCH(_aStream, _aAddr)                                              \
+    do                                                                              \
+    {                                                                               \
+        if (_aStream) __builtin_prefetch((_aAddr), 0, 0);                           \
+    } while (0)
+
+#else
+
+#define TIM_HAVE_STREAM             0
+
+#define TIM_PUT(_aStream, _aDst, _aSrc, _aWidth)        COPY(_aDst, _aSrc, _aWidth)
+#define TIM_PUT_BLOCK(_aStream, _aDst, _aSrc, _aSize)   memcpy((_aDst), (_aSrc), (_aSize))
+#define TIM_PREFETCH(_aStream, _aAddr)                  do { } while (0)
+
+#endif
+
 typedef struct timSlice
 {
     int32_t  mBaseIndex;
     uint32_t mLen;
+    uint32_t mInAlt;    /* 1 : the run is in mAltArray, at the same index */
 } timSlice;
 
 typedef struct timMergeState
@@ -49,44 +240,82 @@ typedef struct timMergeState
      */
     uint32_t   mMergeMemSize;
     void      *mMergeMem;
+    size_t     mMergeMemMapped;     /* see timAllocBuffer() */
+    uint32_t   mMergeLenMax;        /* the most a merge of this sort can need, n / 2,
+                                       0 : unknown */
     void      *mMergeArray; /* pre-allocated in timMergeStateInit().
-                               size : TIM_MERGE_TEMP_ARRAY_SIZE * mWidth */
+                               size : mConf.mTempSize * mWidth */
+
+    /*
+     * AltArray : with TIM_BUFFER_PINGPONG, as many elements as the array.
+     *            A run is either in the array or in mAltArray, at the same
+     *            indexes, and the same indexes of the other are free.
+     *            NULL : merges use mMergeMem.
+     */
+    void      *mAltArray;
+    size_t     mAltArrayMapped;
 
     uint32_t   mPendingRunCnt;
+    uint32_t   mPendingRunFloor;    /* runs below are out of reach of the collapses,
+                                       the runs of a block being formed are above */
     timSlice   mPendingRun[TIM_MAX_PENDING_RUN_CNT];
 
     uint32_t   mMinGallop;
 
+    timConf    mConf;
+
     void      *mPivot;      /* memory for pivot value in binary insertion sort */
 
+    timStat    mStat;
+
 } timMergeState;
 
-static void timMergeStateInit(timMergeState *aState, void *aArray, size_t aWidth)
+/*
+ * Wins in a row a merge starts galloping after. Linear merges never get there.
+ */
+static uint32_t timMinGallop(const timConf *aConf)
+{
+    return aConf->mMerge == TIM_MERGE_LINEAR ? UINT32_MAX : aConf->mMinGallop;
+}
+
+static void timMergeStateInit(timMergeState *aState, void *aArray, size_t aWidth, const timConf *aConf)
 {
     aState->mWidth         = aWidth;
     aState->mArray         = aArray;
+    aState->mConf          = *aConf;
 
-    aState->mMergeArray    = malloc(aWidth * TIM_MERGE_TEMP_ARRAY_SIZE);
+    aState->mMergeArray    = malloc(aWidth * aConf->mTempSize);
     // assert(aState->mMergeArray != NULL);
 
     aState->mPivot         = malloc(aWidth);
     // assert(aState->mPivot != NULL);
 
-    aState->mMergeMem      = aState->mMergeArray;
-    aState->mMergeMemSize  = TIM_MERGE_TEMP_ARRAY_SIZE;
-    aState->mPendingRunCnt = 0;
-    aState->mMinGallop     = TIM_MIN_GALLOP;
+    aState->mAltArray       = NULL;
+    aState->mAltArrayMapped = 0;
+
+    aState->mMergeMem        = aState->mMergeArray;
+    aState->mMergeMemSize    = aConf->mTempSize;
+    aState->mMergeMemMapped  = 0;
+    aState->mMergeLenMax     = 0;
+    aState->mPendingRunCnt   = 0;
+    aState->mPendingRunFloor = 0;
+    aState->mMinGallop       = timMinGallop(aConf);
+
+    memset(&aState->mStat, 0, sizeof(aState->mStat));
+    aState->mStat.mEnabled = TIM_STAT_ENABLED;
+
+    TIM_MERGE_MEM_PEAK(aState, (uint64_t)aWidth * aConf->mTempSize);
 }
 
 /*
- * if aSize < MIN_MERGE, returns aSize
+ * if aSize < aMinMerge, returns aSize
  * else
- * if aSize is a power of 2 then returns MIN_MERGE / 2
+ * if aSize is a power of 2 then returns aMinMerge / 2
  * else
- * returns an integer k where MIN_MERGE / 2 <= k <= MIN_MERGE, such that
+ * returns an integer k where aMinMerge / 2 <= k <= aMinMerge, such that
  * aSize / k is close to, but strictly less than, an exact power of 2.
  */
-static uint32_t timCalcMinRunLen(uint32_t aSize)
+static uint32_t timCalcMinRunLen(uint32_t aSize, uint32_t aMinMerge)
 {
     uint32_t sBumper = 0;
     uint32_t sMinRun;
@@ -95,7 +324,7 @@ static uint32_t timCalcMinRunLen(uint32_t aSize)
 
     sMinRun = aSize;
 
-    while (sMinRun >= MIN_MERGE)
+    while (sMinRun >= aMinMerge)
     {
         sBumper |= (sMinRun & 1);
         sMinRun >>= 1;
@@ -104,31 +333,20 @@ static uint32_t timCalcMinRunLen(uint32_t aSize)
     return sMinRun + sBumper;
 }
 
+#if TIM_ADDRESSING == TIM_ADDRESSING_INDEX
+
 static void timReverseSlice(timMergeState *aState, uint32_t aIndexLow, uint32_t aIndexHigh)
 {
-    register size_t   sWidth;
-    register uint8_t *sPtr1;
-    register uint8_t *sPtr2;
-    uint8_t           sTemp;
+    const size_t sWidth = TIM_WIDTH(aState);
+    uint8_t     *sArray = (uint8_t *)aState->mArray;
 
     aIndexHigh--;
 
     while (aIndexLow < aIndexHigh)
     {
-        sWidth = aState->mWidth;
-
-        /*
-         * Swap two elements
-         */
-        sPtr1 = ((uint8_t *)aState->mArray) + sWidth * aIndexLow;
-        sPtr2 = ((uint8_t *)aState->mArray) + sWidth * aIndexHigh;
+        SWAP(sArray + sWidth * aIndexLow, sArray + sWidth * aIndexHigh, sWidth);
 
-        do
-        {
-            sTemp    = *sPtr1;
-            *sPtr1++ = *sPtr2;
-            *sPtr2++ = sTemp;
-        } while (--sWidth > 0);
+        TIM_STAT_ADD(aState, mMoveCnt, 2);
 
         aIndexLow++;
         aIndexHigh--;
@@ -140,7 +358,7 @@ static uint32_t timCountRunAndMakeAscending(timMergeState *aState,
                                             int32_t        aIndexHigh,
                                             cmpFunc       *aCmpCb)
 {
-    const size_t sWidth = aState->mWidth;
+    const size_t sWidth = TIM_WIDTH(aState);
 
     int32_t  sIndexCur;
     uint8_t *sArray = (uint8_t *)aState->mArray;
@@ -161,7 +379,7 @@ static uint32_t timCountRunAndMakeAscending(timMergeState *aState,
      * And then start checking how long respective patterns go.
      */
     if ((*aCmpCb)(sArray + (aIndexLow * sWidth), 
-                  sArray + ((aIndexLow + 1) * sWidth)) == -1)
+                  sArray + ((aIndexLow + 1) * sWidth)) <= 0)
     {
         /*
          * The first two elements are in ASCENDING order
@@ -175,7 +393,7 @@ static uint32_t timCountRunAndMakeAscending(timMergeState *aState,
         while (sIndexCur < aIndexHigh)
         {
             if ((*aCmpCb)(sArray + ((sIndexCur - 1) * sWidth), 
-                          sArray + (sIndexCur * sWidth)) != 1)
+                          sArray + (sIndexCur * sWidth)) <= 0)
             {
                 /* <= */
                 sIndexCur++;
@@ -203,7 +421,7 @@ static uint32_t timCountRunAndMakeAscending(timMergeState *aState,
         while (sIndexCur < aIndexHigh)
         {
             if ((*aCmpCb)(sArray + ((sIndexCur - 1) * sWidth), 
-                          sArray + (sIndexCur * sWidth)) == 1)
+                          sArray + (sIndexCur * sWidth)) > 0)
             {
                 /* > */
                 sIndexCur++;
@@ -227,8 +445,8 @@ static void timDoBinarySort(timMergeState *aState,
                             int32_t        aIndexStart,
                             cmpFunc       *aCmpCb)
 {
-    const size_t   sWidth = aState->mWidth;
-    const uint8_t *sArray = (uint8_t *)aState->mArray;
+    const size_t   sWidth = TIM_WIDTH(aState);
+    uint8_t       *sArray = (uint8_t *)aState->mArray;
 
     int32_t        sLeft;
     int32_t        sRight;
@@ -259,7 +477,7 @@ static void timDoBinarySort(timMergeState *aState,
         {
             sMiddle = (sLeft + sRight) >> 1;
 
-            if ((*aCmpCb)(aState->mPivot, sArray + sMiddle * sWidth) == -1)
+            if ((*aCmpCb)(aState->mPivot, sArray + sMiddle * sWidth) < 0)
             {
                 sRight = sMiddle;
             }
@@ -280,15 +498,179 @@ static void timDoBinarySort(timMergeState *aState,
         }
 
         COPY(sArray + sLeft * sWidth, aState->mPivot, sWidth);
+        TIM_STAT_ADD(aState, mMoveCnt, aIndexStart - sLeft + 2);
+    }
+}
+
+#else /* TIM_ADDRESSING_POINTER */
+
+/*
+ * Reverse Slice.
+ * Range will be from aIndexLow to aIndexHigh - 1. (excluding aIndexHigh)
+ */
+static void timReverseSlice(timMergeState *aState, uint32_t aIndexLow, uint32_t aIndexHigh)
+{
+    const size_t sWidth = TIM_WIDTH(aState);
+    uint8_t     *sLow   = (uint8_t *)aState->mArray + aIndexLow * sWidth;
+    uint8_t     *sHigh  = (uint8_t *)aState->mArray + (aIndexHigh - 1) * sWidth;
+
+    while (sLow < sHigh)
+    {
+        SWAP(sLow, sHigh, sWidth);
+        TIM_STAT_ADD(aState, mMoveCnt, 2);
+
+        sLow  += sWidth;
+        sHigh -= sWidth;
+    }
+}
+
+static uint32_t timCountRunAndMakeAscending(timMergeState *aState,
+                                            int32_t        aIndexLow,
+                                            int32_t        aIndexHigh,
+                                            cmpFunc       *aCmpCb)
+{
+    const size_t    sWidth = TIM_WIDTH(aState);
+    const uint8_t  *sHigh  = (const uint8_t *)aState->mArray + aIndexHigh * sWidth;
+
+    register uint32_t  sRunLen = 2;   /* the first two elements */
+    const uint8_t     *sCursor;
+
+    // assert(aIndexLow < aIndexHigh);
+
+    sCursor = (const uint8_t *)aState->mArray + (aIndexLow + 1) * sWidth;
+    if (sCursor == sHigh) return 1;
+
+    /*
+     * Check the values of the first two elements of the aArray
+     * and determine if it is assencing or descending.
+     * And then start checking how long respective patterns go.
+     */
+    if ((*aCmpCb)(sCursor - sWidth, sCursor) > 0)
+    {
+        /*
+         * The first two elements are in DESCENDING order.
+         * "DESCENDING" is STRICTLY defined as
+         *      a[0] > a[1] > a[2] > ...
+         * strictly defining "descending" enables preserving stableness.
+         */
+        sCursor += sWidth;
+
+        while (sCursor < sHigh)
+        {
+            if ((*aCmpCb)(sCursor - sWidth, sCursor) > 0)
+            {
+                /* > */
+                sRunLen++;
+            }
+            else
+            {
+                /* <= */
+                break;
+            }
+
+            sCursor += sWidth;
+        }
+
+        timReverseSlice(aState, aIndexLow, aIndexLow + sRunLen);
+    }
+    else
+    {
+        /*
+         * The first two elements are in ASCENDING order.
+         * "ASCENDING" is defined as
+         *      a[0] <= a[1] <= a[2] <= ...
+         */
+        sCursor += sWidth;
+
+        while (sCursor < sHigh)
+        {
+            if ((*aCmpCb)(sCursor - sWidth, sCursor) > 0)
+            {
+                /* > */
+                break;
+            }
+            else
+            {
+                /* <= */
+                sRunLen++;
+            }
+
+            sCursor += sWidth;
+        }
+    }
+
+    return sRunLen;
+}
+
+static void timDoBinarySort(timMergeState *aState,
+                            int32_t        aIndexLow,
+                            int32_t        aIndexHigh,
+                            int32_t        aIndexStart,
+                            cmpFunc       *aCmpCb)
+{
+    const size_t      sWidth = TIM_WIDTH(aState);
+    uint8_t          *sLow   = (uint8_t *)aState->mArray + aIndexLow * sWidth;
+    uint8_t          *sHigh  = (uint8_t *)aState->mArray + aIndexHigh * sWidth;
+    uint8_t          *sStart = (uint8_t *)aState->mArray + aIndexStart * sWidth;
+
+    register uint8_t *sLeft;
+    register uint8_t *sRight;
+    register uint8_t *sPtr;
+
+    // assert(sLow <= sStart && sStart <= sHigh);
+
+    if (sLow == sStart) sStart += sWidth;
+
+    for (; sStart < sHigh; sStart += sWidth)
+    {
+        sLeft  = sLow;
+        sRight = sStart;
+
+        // assert(sLeft < sRight);
+
+        COPY(aState->mPivot, sStart, sWidth);
+
+        do
+        {
+            /*
+             * Halve the element count, not the byte distance.
+             * Rounding the address down to a multiple of sWidth only works
+             * if the array itself is aligned to sWidth.
+             */
+            sPtr = sLeft + ((size_t)(sRight - sLeft) / sWidth / 2) * sWidth;
+
+            if ((*aCmpCb)(aState->mPivot, sPtr) < 0)
+            {
+                sRight = sPtr;
+            }
+            else
+            {
+                sLeft = sPtr + sWidth;
+            }
+        } while (sLeft < sRight);
+
+        /*
+         * Slide over to make room (using memmove is much slower under MSVC 5)
+         */
+        for (sPtr = sStart; sPtr > sLeft; sPtr -= sWidth)
+        {
+            COPY(sPtr, sPtr - sWidth, sWidth);
+        }
+
+        COPY(sLeft, aState->mPivot, sWidth);
+        TIM_STAT_ADD(aState, mMoveCnt, (size_t)(sStart - sLeft) / sWidth + 2);
     }
 }
 
+#endif
+
 static void timMergeStatePushRun(timMergeState *aState, int32_t aBase, uint32_t aRunLen)
 {
     // assert(aState->mPendingRunCnt < TIM_MAX_PENDING_RUN_CNT);
 
     aState->mPendingRun[aState->mPendingRunCnt].mBaseIndex = aBase;
     aState->mPendingRun[aState->mPendingRunCnt].mLen       = aRunLen;
+    aState->mPendingRun[aState->mPendingRunCnt].mInAlt     = 0;
     aState->mPendingRunCnt++;
 }
 
@@ -339,7 +721,7 @@ static int32_t timGallopLeft(const void    *aKey,
     sLastOffset = 0;
     sOffset     = 1;
 
-    if ((*aCmpCb)(aKey, aArray + (aBase + aHint) * aWidth) == 1)
+    if ((*aCmpCb)(aKey, aArray + (aBase + aHint) * aWidth) > 0)
     {
         /*
          * key > a[b+h]
@@ -350,7 +732,7 @@ static int32_t timGallopLeft(const void    *aKey,
 
         while (sOffset < sMaxOffset)
         {
-            if ((*aCmpCb)(aKey, aArray + (aBase + aHint + sOffset) * aWidth) == 1)
+            if ((*aCmpCb)(aKey, aArray + (aBase + aHint + sOffset) * aWidth) > 0)
             {
                 sLastOffset = sOffset;
                 sOffset     = (sOffset << 1) + 1;
@@ -381,7 +763,7 @@ static int32_t timGallopLeft(const void    *aKey,
 
         while (sOffset < sMaxOffset)
         {
-            if ((*aCmpCb)(aKey, aArray + (aBase + aHint - sOffset) * aWidth) == 1)
+            if ((*aCmpCb)(aKey, aArray + (aBase + aHint - sOffset) * aWidth) > 0)
             {
                 break;
             }
@@ -420,7 +802,7 @@ static int32_t timGallopLeft(const void    *aKey,
     {
         sMiddle = sLastOffset + ((sOffset - sLastOffset) >> 1);
 
-        if ((*aCmpCb)(aKey, aArray + (aBase + sMiddle) * aWidth) == 1)
+        if ((*aCmpCb)(aKey, aArray + (aBase + sMiddle) * aWidth) > 0)
         {
             /* a[b+m] < key */
             sLastOffset = sMiddle + 1;
@@ -473,7 +855,7 @@ static int32_t timGallopRight(const void    *aKey,
     sLastOffset = 0;
     sOffset     = 1;
 
-    if ((*aCmpCb)(aKey, aArray + (aBase + aHint) * aWidth) == -1)
+    if ((*aCmpCb)(aKey, aArray + (aBase + aHint) * aWidth) < 0)
     {
         /*
          * key < a[b+h]
@@ -484,7 +866,7 @@ static int32_t timGallopRight(const void    *aKey,
 
         while (sOffset < sMaxOffset)
         {
-            if ((*aCmpCb)(aKey, aArray + (aBase + aHint - sOffset) * aWidth) == -1)
+            if ((*aCmpCb)(aKey, aArray + (aBase + aHint - sOffset) * aWidth) < 0)
             {
                 sLastOffset = sOffset;
                 sOffset     = (sOffset << 1) + 1;
@@ -516,7 +898,7 @@ static int32_t timGallopRight(const void    *aKey,
 
         while (sOffset < sMaxOffset)
         {
-            if ((*aCmpCb)(aKey, aArray + (aBase + aHint + sOffset) * aWidth) == -1)
+            if ((*aCmpCb)(aKey, aArray + (aBase + aHint + sOffset) * aWidth) < 0)
             {
                 break;
             }
@@ -554,7 +936,7 @@ static int32_t timGallopRight(const void    *aKey,
     {
         sMiddle = sLastOffset + ((sOffset - sLastOffset) >> 1);
 
-        if ((*aCmpCb)(aKey, aArray + (aBase + sMiddle) * aWidth) == -1)
+        if ((*aCmpCb)(aKey, aArray + (aBase + sMiddle) * aWidth) < 0)
         {
             /* key < a[b+m] */
             sOffset = sMiddle;
@@ -571,15 +953,115 @@ static int32_t timGallopRight(const void    *aKey,
     return sOffset;
 }
 
+/*
+ * -----------------------------------------------------------------------------
+ *  Merge Memory
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Whether a buffer of aSize bytes is to be of huge pages : mConf.mHugePage KiB
+ * or more, on a system that has them
+ */
+static int32_t timIsHuge(timMergeState *aState, size_t aSize)
+{
+#ifdef MADV_HUGEPAGE
+    return aState->mConf.mHugePage != 0 && aSize >= ((size_t)aState->mConf.mHugePage << 10);
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Memory of aSize bytes for the merges. Huge ones (timIsHuge()) are mapped on
+ * their own, 2MB aligned, and backed by transparent huge pages, or by
+ * hugetlbfs pages with mConf.mHugeTlb if the system has some reserved, so
+ * that the merge loops do not miss the dTLB every 4K.
+ * *aMapped is what to give timFreeBuffer() : the size mapped, 0 for malloc().
+ */
+static void *timAllocBuffer(timMergeState *aState, size_t aSize, size_t *aMapped)
+{
+#ifdef MADV_HUGEPAGE
+    size_t   sSize = (aSize + TIM_HUGE_PAGE_SIZE - 1) & ~(TIM_HUGE_PAGE_SIZE - 1);
+    uint8_t *sMap;
+    uint8_t *sAligned;
+
+    if (timIsHuge(aState, aSize) == 1)
+    {
+#ifdef MAP_HUGETLB
+        if (aState->mConf.mHugeTlb == 1)
+        {
+            sMap = mmap(NULL, sSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if (sMap != MAP_FAILED)
+            {
+                *aMapped = sSize;
+                return sMap;
+            }
+            else
+            {
+                /* none reserved, vm.nr_hugepages */
+            }
+        }
+        else
+        {
+        }
+#endif
+
+        /* a huge page more, to cut the aligned part out of */
+        sMap = mmap(NULL, sSize + TIM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (sMap != MAP_FAILED)
+        {
+            sAligned = (uint8_t *)(((uintptr_t)sMap + TIM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(TIM_HUGE_PAGE_SIZE - 1));
+
+            if (sAligned > sMap) (void)munmap(sMap, sAligned - sMap);
+            (void)munmap(sAligned + sSize, sMap + TIM_HUGE_PAGE_SIZE - sAligned);
+
+            (void)madvise(sAligned, sSize, MADV_HUGEPAGE);
+
+            *aMapped = sSize;
+            return sAligned;
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+    }
+#endif
+
+    *aMapped = 0;
+    return malloc(aSize);
+}
+
+static void timFreeBuffer(void *aBuffer, size_t aMapped)
+{
+#ifdef MADV_HUGEPAGE
+    if (aMapped > 0)
+    {
+        (void)munmap(aBuffer, aMapped);
+        return;
+    }
+    else
+    {
+    }
+#endif
+
+    free(aBuffer);
+}
+
 static void timMergeFreeMem(timMergeState *aState)
 {
     if (aState->mMergeMem != aState->mMergeArray)
     {
-        free(aState->mMergeMem);
+        timFreeBuffer(aState->mMergeMem, aState->mMergeMemMapped);
     }
 
-    aState->mMergeMem     = aState->mMergeArray;
-    aState->mMergeMemSize = TIM_MERGE_TEMP_ARRAY_SIZE;
+    aState->mMergeMem       = aState->mMergeArray;
+    aState->mMergeMemSize   = aState->mConf.mTempSize;
+    aState->mMergeMemMapped = 0;
 }
 
 static void timMergeGetMem(timMergeState *aState, uint32_t aNeed)
@@ -588,25 +1070,77 @@ static void timMergeGetMem(timMergeState *aState, uint32_t aNeed)
 
     timMergeFreeMem(aState);
 
-    aState->mMergeMem = malloc(aNeed * aState->mWidth);
+    /* huge pages are mapped once, for the longest merge of the sort */
+    if (timIsHuge(aState, (size_t)aNeed * aState->mWidth) == 1 && aNeed < aState->mMergeLenMax)
+    {
+        aNeed = aState->mMergeLenMax;
+    }
+    else
+    {
+    }
+
+    aState->mMergeMem = timAllocBuffer(aState, (size_t)aNeed * aState->mWidth, &aState->mMergeMemMapped);
     // assert(aState->mMergeMem != NULL);
 
     aState->mMergeMemSize = aNeed;
+
+    /* what is mapped is rounded up to huge pages */
+    TIM_MERGE_MEM_PEAK(aState, aState->mMergeMemMapped > 0 ? (uint64_t)aState->mMergeMemMapped
+                                                           : (uint64_t)aNeed * aState->mWidth);
 }
 
 /*
- * Merges two adjacent runs in place, in a stable way.
+ * Releases what timMergeStateInit() and timMergeGetMem() allocated
+ */
+static void timMergeStateDestroy(timMergeState *aState)
+{
+    timMergeFreeMem(aState);
+
+    free(aState->mMergeArray);
+    free(aState->mPivot);
+
+    if (aState->mAltArray != NULL) timFreeBuffer(aState->mAltArray, aState->mAltArrayMapped);
+
+    aState->mMergeArray = NULL;
+    aState->mMergeMem   = NULL;
+    aState->mPivot      = NULL;
+    aState->mAltArray   = NULL;
+}
+
+#if TIM_HAVE_STREAM
+/*
+ * Whether a merge of aLen elements streams its stores, see STREAM
+ */
+static int32_t timIsStream(timMergeState *aState, int32_t aLen)
+{
+    return aState->mConf.mStream != 0 &&
+           (size_t)aLen * TIM_WIDTH(aState) >= ((size_t)aState->mConf.mStream << 10);
+}
+
+static void timStreamBlock(uint8_t *aDst, const uint8_t *aSrc, size_t aSize)
+{
+    size_t sOffset;
+
+    for (sOffset = 0; sOffset < aSize; sOffset += TIM_MOVE_WIDTH)
+    {
+        STREAM(aDst + sOffset, aSrc + sOffset);
+    }
+}
+#endif
+
+/*
+ * Merges two runs into aDst, in a stable way.
  * The first element of the first run must be greater than the first
  * element of the second run.
  *
- *      a[aBase1] > a[aBase2]
+ *      aRun1[0] > aRun2[0]
  *
  * and the last element of the first run must be greater than
  * all elements of the second run.
  *
- *      a[aBase1 + aLen1] > every a[aBase2 .. aBase2 + aLen2]
+ *      aRun1[aLen1 - 1] > every aRun2[0 .. aLen2 - 1]
  *
- *      IOW, a[aBase1 + aLen1] is the maximum.
+ *      IOW, aRun1[aLen1 - 1] is the maximum.
  *
  *      timGallopRight() and timGallopLeft() called just before
  *      timMergeLow() or timMergeHigh() is called creates this condition.
@@ -618,12 +1152,20 @@ static void timMergeGetMem(timMergeState *aState, uint32_t aNeed)
  * its counterpart, timMergeHigh() should be called if aLen1 >= aLen2.
  * Either can be called if aLen1 == aLen2.
  *
+ * aRun1 is out of aDst : the merge memory the caller copied run1 to, or the
+ * other one of the array and the ping-pong buffer. aRun2 either follows
+ * run1's place in aDst, as drawn below, or is out of aDst as well, in which
+ * case whatever is left of it at the end is copied.
+ *
+ * aStream : the stores into aDst are STREAM ones. A constant for each caller,
+ * so that the body is compiled once for each, see timMergeLow() below it.
+ *
  *            sCursor1
  *                |
  *                |- - - >
  *                V
  *                +-------------+
- *           sTmp |  RUN1_copy  |
+ *          aRun1 |  RUN1_copy  |
  *                +-------------+
  *                ^
  *                |copy
@@ -639,47 +1181,39 @@ static void timMergeGetMem(timMergeState *aState, uint32_t aNeed)
  *          |             |                     |
  *          |<-- aLen1 -->|<------ aLen2 ------>|
  *          |             |
- *        aBase1        aBase2
+ *         aDst         aRun2
  *
  * timMergeLow() conducts merge from left to right.
  */
-static void timMergeLow(timMergeState *aState,
-                        int32_t        aBase1,
-                        int32_t        aLen1,
-                        int32_t        aBase2,
-                        int32_t        aLen2,
-                        cmpFunc       *aCmpCb)
+static inline __attribute__((always_inline))
+void timMergeLowCore(timMergeState *aState,
+                     uint8_t       *aDst,
+                     const uint8_t *aRun1,
+                     int32_t        aLen1,
+                     const uint8_t *aRun2,
+                     int32_t        aLen2,
+                     cmpFunc       *aCmpCb,
+                     const int32_t  aStream)
 {
-    const size_t  sWidth = aState->mWidth;
-
-    uint8_t      *sArray = (uint8_t *)aState->mArray;
-    uint8_t      *sTmp;
+    const size_t  sWidth = TIM_WIDTH(aState);
 
     uint32_t      sMinGallop;
 
-    int32_t       sCursor1;    /* Indexes into tmp array (run1) */
-    int32_t       sCursor2;    /* Indexes into original array. run2 */
-    int32_t       sDestIndex;  /* Indexes into original array. merge buffer */
+    int32_t       sCursor1;    /* Indexes into run1 */
+    int32_t       sCursor2;    /* Indexes into run2 */
+    int32_t       sDestIndex;  /* Indexes into aDst */
 
-    // assert(aLen1 > 0 && aLen2 > 0 && aBase1 + aLen1 == aBase2);
-
-    /*
-     * Should always prepare temp memory with size s; s = min(len(run1), len(run2))
-     *
-     * In MergeLow, aLen1 is always less than aLen2
-     */
-    timMergeGetMem(aState, aLen1);
-    memcpy(aState->mMergeMem, sArray + aBase1 * sWidth, sWidth * aLen1);
-    sTmp = aState->mMergeMem;
+    // assert(aLen1 > 0 && aLen2 > 0);
 
     sCursor1    = 0;
-    sCursor2    = aBase2;
-    sDestIndex  = aBase1;
+    sCursor2    = 0;
+    sDestIndex  = 0;
 
     /*
      * Move first element of second run
      */
-    COPY(sArray + sDestIndex * sWidth, sArray + sCursor2 * sWidth, sWidth);
+    TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+    TIM_STAT_ADD(aState, mMoveCnt, 1);
     sDestIndex++;
     sCursor2++;
     aLen2--;
@@ -705,9 +1239,13 @@ static void timMergeLow(timMergeState *aState,
         {
             // assert(aLen1 > 1 && aLen2 > 0);
 
-            if ((*aCmpCb)(sArray + sCursor2 * sWidth, sTmp + sCursor1 * sWidth) == -1)
+            TIM_PREFETCH(aStream, aRun1 + sCursor1 * sWidth + TIM_PREFETCH_DISTANCE);
+            TIM_PREFETCH(aStream, aRun2 + sCursor2 * sWidth + TIM_PREFETCH_DISTANCE);
+
+            if ((*aCmpCb)(aRun2 + sCursor2 * sWidth, aRun1 + sCursor1 * sWidth) < 0)
             {
-                COPY(sArray + sDestIndex * sWidth, sArray + sCursor2 * sWidth, sWidth);
+                TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+                TIM_STAT_ADD(aState, mMoveCnt, 1);
                 sDestIndex++;
                 sCursor2++;
                 aLen2--;
@@ -719,7 +1257,8 @@ static void timMergeLow(timMergeState *aState,
             }
             else
             {
-                COPY(sArray + sDestIndex * sWidth, sTmp + sCursor1 * sWidth, sWidth);
+                TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+                TIM_STAT_ADD(aState, mMoveCnt, 1);
                 sDestIndex++;
                 sCursor1++;
                 aLen1--;
@@ -745,8 +1284,10 @@ static void timMergeLow(timMergeState *aState,
             sMinGallop -= sMinGallop > 1;
             aState->mMinGallop = sMinGallop;
 
-            sCount1 = timGallopRight(sArray + sCursor2 * sWidth,    /* key */
-                                     sTmp,                          /* array */
+            TIM_STAT_ADD(aState, mGallopCnt, 1);
+
+            sCount1 = timGallopRight(aRun2 + sCursor2 * sWidth,    /* key */
+                                     aRun1,                         /* array */
                                      sWidth,                        /* width */
                                      sCursor1,                      /* base */
                                      aLen1,                         /* len */
@@ -755,7 +1296,8 @@ static void timMergeLow(timMergeState *aState,
 
             if (sCount1 != 0)
             {
-                memcpy(sArray + sDestIndex * sWidth, sTmp + sCursor1 * sWidth, sWidth * sCount1);
+                TIM_PUT_BLOCK(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth * sCount1);
+                TIM_STAT_ADD(aState, mMoveCnt, sCount1);
                 sDestIndex += sCount1;
                 sCursor1   += sCount1;
                 aLen1      -= sCount1;
@@ -763,7 +1305,8 @@ static void timMergeLow(timMergeState *aState,
                 if (aLen1 == 0) goto LABEL_SUCCEED;
             }
 
-            COPY(sArray + sDestIndex * sWidth, sArray + sCursor2 * sWidth, sWidth);
+            TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+            TIM_STAT_ADD(aState, mMoveCnt, 1);
             sDestIndex++;
             sCursor2++;
             aLen2--;
@@ -772,8 +1315,10 @@ static void timMergeLow(timMergeState *aState,
 
             /* - - - - - C u t  H e r e - - - - - */
 
-            sCount2 = timGallopLeft(sTmp + sCursor1 * sWidth,
-                                    sArray,
+            TIM_STAT_ADD(aState, mGallopCnt, 1);
+
+            sCount2 = timGallopLeft(aRun1 + sCursor1 * sWidth,
+                                    aRun2,
                                     sWidth,
                                     sCursor2,
                                     aLen2,
@@ -783,21 +1328,23 @@ static void timMergeLow(timMergeState *aState,
             if (sCount2 != 0)
             {
                 /* src and dst may overlap, so we should call memmove instead of memcpy */
-                memmove(sArray + sDestIndex * sWidth, sArray + sCursor2 * sWidth, sWidth * sCount2);
+                memmove(aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth * sCount2);
+                TIM_STAT_ADD(aState, mMoveCnt, sCount2);
                 sDestIndex += sCount2;
                 sCursor2   += sCount2;
                 aLen2      -= sCount2;
                 if (aLen2 == 0) goto LABEL_SUCCEED;
             }
 
-            COPY(sArray + sDestIndex * sWidth, sTmp + sCursor1 * sWidth, sWidth);
+            TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+            TIM_STAT_ADD(aState, mMoveCnt, 1);
             sDestIndex++;
             sCursor1++;
             aLen1--;
 
             if (aLen1 == 1) goto LABEL_COPY_B;
 
-        } while (sCount1 >= TIM_MIN_GALLOP || sCount2 >= TIM_MIN_GALLOP);
+        } while (sCount1 >= aState->mConf.mMinGallop || sCount2 >= aState->mConf.mMinGallop);
 
         sMinGallop++;   /* penalize it for leaving galloping mode */
         aState->mMinGallop = sMinGallop;
@@ -807,7 +1354,17 @@ LABEL_SUCCEED:
 
     if (aLen1 > 0)
     {
-        memcpy(sArray + sDestIndex * sWidth, sTmp + sCursor1 * sWidth, sWidth * aLen1);
+        TIM_PUT_BLOCK(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth * aLen1);
+        TIM_STAT_ADD(aState, mMoveCnt, aLen1);
+    }
+    else if (aLen2 > 0 && aDst + sDestIndex * sWidth != aRun2 + sCursor2 * sWidth)
+    {
+        /* run2 was not in place */
+        TIM_PUT_BLOCK(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth * aLen2);
+        TIM_STAT_ADD(aState, mMoveCnt, aLen2);
+    }
+    else
+    {
     }
 
     return;
@@ -816,12 +1373,51 @@ LABEL_COPY_B:
     // assert(aLen1 == 1 && aLen2 > 0);
 
     /* The last element of the first run belongs at the end of the merge */
-    memmove(sArray + sDestIndex * sWidth, sArray + sCursor2 * sWidth, sWidth * aLen2);
-    COPY(sArray + (sDestIndex + aLen2) * sWidth, sTmp + sCursor1 * sWidth, sWidth);
+    memmove(aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth * aLen2);
+    TIM_PUT(aStream, aDst + (sDestIndex + aLen2) * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+    TIM_STAT_ADD(aState, mMoveCnt, aLen2 + 1);
 
     return;
 }
 
+#if TIM_HAVE_STREAM
+static __attribute__((noinline)) void timMergeLowStream(timMergeState *aState,
+                                                        uint8_t       *aDst,
+                                                        const uint8_t *aRun1,
+                                                        int32_t        aLen1,
+                                                        const uint8_t *aRun2,
+                                                        int32_t        aLen2,
+                                                        cmpFunc       *aCmpCb)
+{
+    timMergeLowCore(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb, 1);
+
+    /* the streamed stores are weakly ordered, done before the sort returns */
+    _mm_sfence();
+}
+#endif
+
+static void timMergeLow(timMergeState *aState,
+                        uint8_t       *aDst,
+                        const uint8_t *aRun1,
+                        int32_t        aLen1,
+                        const uint8_t *aRun2,
+                        int32_t        aLen2,
+                        cmpFunc       *aCmpCb)
+{
+#if TIM_HAVE_STREAM
+    if (timIsStream(aState, aLen1 + aLen2) == 1)
+    {
+        timMergeLowStream(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb);
+        return;
+    }
+    else
+    {
+    }
+#endif
+
+    timMergeLowCore(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb, 0);
+}
+
 /*
  * Just same as timMergeLow(), except that this one should be called only if
  *
@@ -830,25 +1426,27 @@ LABEL_COPY_B:
  * The first element of the first run must be greater than the first
  * element of the second run.
  *
- *      a[aBase1] > a[aBase2]
+ *      aRun1[0] > aRun2[0]
  *
  * and the last element of the first run must be greater than
  * all elements of the second run.
  *
- *      a[aBase1 + aLen1] > every a[aBase2 .. aBase2 + aLen2]
+ *      aRun1[aLen1 - 1] > every aRun2[0 .. aLen2 - 1]
  *
- *      IOW, a[aBase1 + aLen1] is the maximum.
+ *      IOW, aRun1[aLen1 - 1] is the maximum.
  *
  *      timGallopRight() and timGallopLeft() called just before
  *      timMergeLow() or timMergeHigh() is called creates this condition.
  *
  * timMergeHigh() conducts merge from right to left.
+ * Here aRun2 is out of aDst, and aRun1 is either aDst, as drawn below,
+ * or out of it as well.
  *
  *                                                 +-- sCursor2
  *                                           <- - -|
  *                                                 V
  *                                 +---------------+
- *                            sTmp |   RUN2_copy   |
+ *                           aRun2 |   RUN2_copy   |
  *                                 +---------------+
  *                                 ^
  *                                 |
@@ -862,44 +1460,37 @@ LABEL_COPY_B:
  *          ^                   ^               |
  *          |                   |               |
  *          |<----- aLen1 ----->|<--- aLen2 --->|
- *        aBase1             aBase2
+ *      aDst, aRun1
  */
-static void timMergeHigh(timMergeState *aState,
-                         int32_t        aBase1,
-                         int32_t        aLen1,
-                         int32_t        aBase2,
-                         int32_t        aLen2,
-                         cmpFunc       *aCmpCb)
+static inline __attribute__((always_inline))
+void timMergeHighCore(timMergeState *aState,
+                      uint8_t       *aDst,
+                      const uint8_t *aRun1,
+                      int32_t        aLen1,
+                      const uint8_t *aRun2,
+                      int32_t        aLen2,
+                      cmpFunc       *aCmpCb,
+                      const int32_t  aStream)
 {
-    const size_t sWidth = aState->mWidth;
-
-    uint8_t *sArray = (uint8_t *)aState->mArray;
-    uint8_t *sTmp;
+    const size_t sWidth = TIM_WIDTH(aState);
 
     uint32_t sMinGallop;
 
-    int32_t  sCursor1;    /* Indexes into original array. (run1) */
-    int32_t  sCursor2;    /* Indexes into tmp array (run2) */
-    int32_t  sDestIndex;  /* Indexes into original array. merge buffer */
-
-    /*
-     * Should always prepare temp memory with size s; s = min(len(run1), len(run2))
-     * In MergeHigh, aLen2 is always less than aLen1
-     */
-    timMergeGetMem(aState, aLen2);
+    int32_t  sCursor1;    /* Indexes into run1 */
+    int32_t  sCursor2;    /* Indexes into run2 */
+    int32_t  sDestIndex;  /* Indexes into aDst */
 
-    /* Copy second run into temp memory */
-    memcpy(aState->mMergeMem, sArray + aBase2 * sWidth, sWidth * aLen2);
-    sTmp = aState->mMergeMem;
+    // assert(aLen1 > 0 && aLen2 > 0);
 
-    sCursor1   = aBase1 + aLen1 - 1;
+    sCursor1   = aLen1 - 1;
     sCursor2   = aLen2 - 1;
-    sDestIndex = aBase2 + aLen2 - 1;
+    sDestIndex = aLen1 + aLen2 - 1;
 
     /*
      * Move last element of first run
      */
-    COPY(sArray + sDestIndex * sWidth, sArray + sCursor1 * sWidth, sWidth);
+    TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+    TIM_STAT_ADD(aState, mMoveCnt, 1);
     sDestIndex--;
     sCursor1--;
     aLen1--;
@@ -922,9 +1513,13 @@ static void timMergeHigh(timMergeState *aState,
         {
             // assert(aLen1 > 0 && aLen2 > 1);
 
-            if ((*aCmpCb)(sTmp + sCursor2 * sWidth, sArray + sCursor1 * sWidth) == -1)
+            TIM_PREFETCH(aStream, aRun1 + sCursor1 * sWidth - TIM_PREFETCH_DISTANCE);
+            TIM_PREFETCH(aStream, aRun2 + sCursor2 * sWidth - TIM_PREFETCH_DISTANCE);
+
+            if ((*aCmpCb)(aRun2 + sCursor2 * sWidth, aRun1 + sCursor1 * sWidth) < 0)
             {
-                COPY(sArray + sDestIndex * sWidth, sArray + sCursor1 * sWidth, sWidth);
+                TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+                TIM_STAT_ADD(aState, mMoveCnt, 1);
                 sDestIndex--;
                 sCursor1--;
                 aLen1--;
@@ -936,7 +1531,8 @@ static void timMergeHigh(timMergeState *aState,
             }
             else
             {
-                COPY(sArray + sDestIndex * sWidth, sTmp + sCursor2 * sWidth, sWidth);
+                TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+                TIM_STAT_ADD(aState, mMoveCnt, 1);
                 sDestIndex--;
                 sCursor2--;
                 aLen2--;
@@ -962,10 +1558,12 @@ static void timMergeHigh(timMergeState *aState,
             sMinGallop -= sMinGallop > 1;
             aState->mMinGallop = sMinGallop;
 
-            sCount1 = timGallopRight(sTmp + sCursor2 * sWidth,  /* key */
-                                     sArray,                    /* array */
+            TIM_STAT_ADD(aState, mGallopCnt, 1);
+
+            sCount1 = timGallopRight(aRun2 + sCursor2 * sWidth,  /* key */
+                                     aRun1,                     /* array */
                                      sWidth,                    /* width */
-                                     aBase1,                    /* base */
+                                     0,                         /* base */
                                      aLen1,                     /* len */
                                      aLen1 - 1,                 /* hint */
                                      aCmpCb);
@@ -977,14 +1575,16 @@ static void timMergeHigh(timMergeState *aState,
                 sDestIndex -= sCount1;
                 sCursor1   -= sCount1;
                 aLen1      -= sCount1;
-                memmove(sArray + (sDestIndex + 1) * sWidth,
-                        sArray + (sCursor1 + 1) * sWidth,
+                memmove(aDst + (sDestIndex + 1) * sWidth,
+                        aRun1 + (sCursor1 + 1) * sWidth,
                         sWidth * sCount1);
+                TIM_STAT_ADD(aState, mMoveCnt, sCount1);
 
                 if (aLen1 == 0) goto LABEL_SUCCEED;
             }
 
-            COPY(sArray + sDestIndex * sWidth, sTmp + sCursor2 * sWidth, sWidth);
+            TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+            TIM_STAT_ADD(aState, mMoveCnt, 1);
             sDestIndex--;
             sCursor2--;
             aLen2--;
@@ -993,8 +1593,10 @@ static void timMergeHigh(timMergeState *aState,
 
             /* - - - - - C u t  H e r e - - - - - */
 
-            sCount2 = timGallopLeft(sArray + sCursor1 * sWidth,     /* key */
-                                    sTmp,                           /* array */
+            TIM_STAT_ADD(aState, mGallopCnt, 1);
+
+            sCount2 = timGallopLeft(aRun1 + sCursor1 * sWidth,     /* key */
+                                    aRun2,                          /* array */
                                     sWidth,                         /* width */
                                     0,                              /* base */
                                     aLen2,                          /* len */
@@ -1008,21 +1610,24 @@ static void timMergeHigh(timMergeState *aState,
                 sDestIndex -= sCount2;
                 sCursor2   -= sCount2;
                 aLen2      -= sCount2;
-                memcpy(sArray + (sDestIndex + 1) * sWidth,
-                       sTmp + (sCursor2 + 1) * sWidth,
-                       sWidth * sCount2);
+                TIM_PUT_BLOCK(aStream,
+                              aDst + (sDestIndex + 1) * sWidth,
+                              aRun2 + (sCursor2 + 1) * sWidth,
+                              sWidth * sCount2);
+                TIM_STAT_ADD(aState, mMoveCnt, sCount2);
                 if (aLen2 == 1) goto LABEL_COPY_A;
                 if (aLen2 == 0) goto LABEL_SUCCEED;
             }
 
-            COPY(sArray + sDestIndex * sWidth, sArray + sCursor1 * sWidth, sWidth);
+            TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun1 + sCursor1 * sWidth, sWidth);
+            TIM_STAT_ADD(aState, mMoveCnt, 1);
             sDestIndex--;
             sCursor1--;
             aLen1--;
 
             if (aLen1 == 0) goto LABEL_SUCCEED;
 
-        } while (sCount1 >= TIM_MIN_GALLOP || sCount2 >= TIM_MIN_GALLOP);
+        } while (sCount1 >= aState->mConf.mMinGallop || sCount2 >= aState->mConf.mMinGallop);
 
         sMinGallop++;   /* penalize it for leaving galloping mode */
         aState->mMinGallop = sMinGallop;
@@ -1032,7 +1637,17 @@ LABEL_SUCCEED:
 
     if (aLen2 > 0)
     {
-        memcpy(sArray + (sDestIndex - (aLen2 - 1)) * sWidth, sTmp, aLen2 * sWidth);
+        TIM_PUT_BLOCK(aStream, aDst + (sDestIndex - (aLen2 - 1)) * sWidth, aRun2, aLen2 * sWidth);
+        TIM_STAT_ADD(aState, mMoveCnt, aLen2);
+    }
+    else if (aLen1 > 0 && aDst != aRun1)
+    {
+        /* run1 was not in place */
+        TIM_PUT_BLOCK(aStream, aDst, aRun1, aLen1 * sWidth);
+        TIM_STAT_ADD(aState, mMoveCnt, aLen1);
+    }
+    else
+    {
     }
 
     return;
@@ -1042,14 +1657,161 @@ LABEL_COPY_A:
 
     sDestIndex -= aLen1;
     sCursor1   -= aLen1;
-    memmove(sArray + (sDestIndex + 1) * sWidth,
-            sArray + (sCursor1 + 1) * sWidth,
+    memmove(aDst + (sDestIndex + 1) * sWidth,
+            aRun1 + (sCursor1 + 1) * sWidth,
             aLen1 * sWidth);
-    COPY(sArray + sDestIndex * sWidth, sTmp + sCursor2 * sWidth, sWidth);
+    TIM_PUT(aStream, aDst + sDestIndex * sWidth, aRun2 + sCursor2 * sWidth, sWidth);
+    TIM_STAT_ADD(aState, mMoveCnt, aLen1 + 1);
 
     return;
 }
 
+#if TIM_HAVE_STREAM
+static __attribute__((noinline)) void timMergeHighStream(timMergeState *aState,
+                                                         uint8_t       *aDst,
+                                                         const uint8_t *aRun1,
+                                                         int32_t        aLen1,
+                                                         const uint8_t *aRun2,
+                                                         int32_t        aLen2,
+                                                         cmpFunc       *aCmpCb)
+{
+    timMergeHighCore(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb, 1);
+
+    /* the streamed stores are weakly ordered, done before the sort returns */
+    _mm_sfence();
+}
+#endif
+
+static void timMergeHigh(timMergeState *aState,
+                         uint8_t       *aDst,
+                         const uint8_t *aRun1,
+                         int32_t        aLen1,
+                         const uint8_t *aRun2,
+                         int32_t        aLen2,
+                         cmpFunc       *aCmpCb)
+{
+#if TIM_HAVE_STREAM
+    if (timIsStream(aState, aLen1 + aLen2) == 1)
+    {
+        timMergeHighStream(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb);
+        return;
+    }
+    else
+    {
+    }
+#endif
+
+    timMergeHighCore(aState, aDst, aRun1, aLen1, aRun2, aLen2, aCmpCb, 0);
+}
+
+/*
+ * Ping-pong merge of run A, at aBaseA in aMemA, and run B, at aBaseB in aMemB,
+ * A's first aTrimA elements and B's last aTrimB ones being in place already.
+ * aMemA and aMemB are each the array or mAltArray.
+ *
+ * Runs in different memories are merged into one of them, the one of the
+ * longer run, which is not moved, with no copy before. Runs in the same
+ * memory are merged into the other one when that moves fewer elements than
+ * copying the shorter run there first, which is what happens otherwise.
+ * Either way galloping works as in the other merges.
+ *
+ * Returns 1 if the merged run is in mAltArray.
+ */
+static uint32_t timMergePingPong(timMergeState *aState,
+                                 uint8_t       *aMemA,
+                                 int32_t        aBaseA,
+                                 int32_t        aLenA,
+                                 int32_t        aTrimA,
+                                 uint8_t       *aMemB,
+                                 int32_t        aBaseB,
+                                 int32_t        aLenB,
+                                 int32_t        aTrimB,
+                                 cmpFunc       *aCmpCb)
+{
+    const size_t  sWidth = TIM_WIDTH(aState);
+
+    uint8_t      *sArray = (uint8_t *)aState->mArray;
+    uint8_t      *sAlt   = (uint8_t *)aState->mAltArray;
+    uint8_t      *sMemA  = aMemA;
+    uint8_t      *sMemB  = aMemB;
+    uint8_t      *sDst;
+
+    int32_t       sShorter = aLenA <= aLenB ? aLenA : aLenB;
+
+    if (aMemA == aMemB && aTrimA + aTrimB < sShorter)
+    {
+        /* both out of place, into the other memory */
+        sDst = aMemA == sArray ? sAlt : sArray;
+
+        if (aLenA <= aLenB)
+        {
+            timMergeLow(aState, sDst + aBaseA * sWidth,
+                        aMemA + aBaseA * sWidth, aLenA, aMemB + aBaseB * sWidth, aLenB, aCmpCb);
+        }
+        else
+        {
+            timMergeHigh(aState, sDst + aBaseA * sWidth,
+                         aMemA + aBaseA * sWidth, aLenA, aMemB + aBaseB * sWidth, aLenB, aCmpCb);
+        }
+    }
+    else
+    {
+        if (aMemA == aMemB)
+        {
+            /* the shorter run to the other memory, as into mMergeMem */
+            if (aLenA <= aLenB)
+            {
+                sMemA = aMemA == sArray ? sAlt : sArray;
+                memcpy(sMemA + aBaseA * sWidth, aMemA + aBaseA * sWidth, sWidth * aLenA);
+                TIM_STAT_ADD(aState, mMoveCnt, aLenA);
+            }
+            else
+            {
+                sMemB = aMemB == sArray ? sAlt : sArray;
+                memcpy(sMemB + aBaseB * sWidth, aMemB + aBaseB * sWidth, sWidth * aLenB);
+                TIM_STAT_ADD(aState, mMoveCnt, aLenB);
+            }
+        }
+        else
+        {
+        }
+
+        if (aLenA <= aLenB)
+        {
+            sDst = sMemB;
+            timMergeLow(aState, sDst + aBaseA * sWidth,
+                        sMemA + aBaseA * sWidth, aLenA, sMemB + aBaseB * sWidth, aLenB, aCmpCb);
+        }
+        else
+        {
+            sDst = sMemA;
+            timMergeHigh(aState, sDst + aBaseA * sWidth,
+                         sMemA + aBaseA * sWidth, aLenA, sMemB + aBaseB * sWidth, aLenB, aCmpCb);
+        }
+    }
+
+    /* the elements the gallops left in place, if the merged run is not there */
+    if (aTrimA > 0 && aMemA != sDst)
+    {
+        memcpy(sDst + (aBaseA - aTrimA) * sWidth, aMemA + (aBaseA - aTrimA) * sWidth, sWidth * aTrimA);
+        TIM_STAT_ADD(aState, mMoveCnt, aTrimA);
+    }
+    else
+    {
+    }
+
+    if (aTrimB > 0 && aMemB != sDst)
+    {
+        memcpy(sDst + (aBaseB + aLenB) * sWidth, aMemB + (aBaseB + aLenB) * sWidth, sWidth * aTrimB);
+        TIM_STAT_ADD(aState, mMoveCnt, aTrimB);
+    }
+    else
+    {
+    }
+
+    return sDst == sAlt;
+}
+
 /*
  * Merges the two runs at stack indices i and i + 1.
  * Run i must be the penultimate or antepenultimate run on the stack.
@@ -1060,11 +1822,16 @@ LABEL_COPY_A:
  */
 static void timMergeAt(timMergeState *aState, uint32_t aWhere, cmpFunc *aCmpCb)
 {
-    int32_t sBaseA;
-    int32_t sLenA;
-    int32_t sBaseB;
-    int32_t sLenB;
-    int32_t k;
+    const size_t  sWidth = TIM_WIDTH(aState);
+
+    uint8_t      *sMemA;
+    uint8_t      *sMemB;
+    int32_t       sBaseA;
+    int32_t       sLenA;
+    int32_t       sBaseB;
+    int32_t       sLenB;
+    int32_t       sOrgLenB;
+    int32_t       k;
 
     // assert(aState->mPendingRunCnt >= 2);
     // assert(aWhere == aState->mPendingRunCnt - 2 || aWhere == aState->mPendingRunCnt - 3);
@@ -1074,6 +1841,9 @@ static void timMergeAt(timMergeState *aState, uint32_t aWhere, cmpFunc *aCmpCb)
     sBaseB = aState->mPendingRun[aWhere + 1].mBaseIndex;
     sLenB  = aState->mPendingRun[aWhere + 1].mLen;
 
+    sMemA  = aState->mPendingRun[aWhere].mInAlt == 1 ? aState->mAltArray : aState->mArray;
+    sMemB  = aState->mPendingRun[aWhere + 1].mInAlt == 1 ? aState->mAltArray : aState->mArray;
+
     // assert(sLenA > 0 && sLenB > 0);
     // assert(sBaseA + sLenA == sBaseB);
 
@@ -1094,38 +1864,86 @@ static void timMergeAt(timMergeState *aState, uint32_t aWhere, cmpFunc *aCmpCb)
 
     aState->mPendingRunCnt--;
 
+    TIM_STAT_ADD(aState, mMergeCnt, 1);
+    TIM_STAT_ADD(aState, mGallopCnt, 1);
+
     /*
      * Find where the first element of run2 goes in run1.
      * Prior elements in run1 can be ignored (because they are already in place).
      */
-    k = timGallopRight((uint8_t *)aState->mArray + sBaseB * aState->mWidth,
-                       aState->mArray,
-                       aState->mWidth,
+    k = timGallopRight(sMemB + sBaseB * sWidth,
+                       sMemA,
+                       sWidth,
                        sBaseA,
                        sLenA,
                        0,
                        aCmpCb);
     // assert(k >= 0);
 
-    sBaseA += k;
-    sLenA  -= k;
-    if (sLenA == 0) return;
+    sBaseA  += k;
+    sLenA   -= k;
+    sOrgLenB = sLenB;
 
-    /*
-     * Find where the last element of run1 goes in run2.
-     * Subsequent elements in run2 can be ignored
-     * (because they are already in place).
-     */
-    sLenB = timGallopLeft((uint8_t *)aState->mArray + (sBaseA + sLenA - 1) * aState->mWidth,
-                          aState->mArray,
-                          aState->mWidth,
-                          sBaseB,
-                          sLenB,
-                          sLenB - 1,
-                          aCmpCb);
-    // assert(sLenB >= 0);
+    if (sLenA > 0)
+    {
+        TIM_STAT_ADD(aState, mGallopCnt, 1);
 
-    if (sLenB == 0) return;
+        /*
+         * Find where the last element of run1 goes in run2.
+         * Subsequent elements in run2 can be ignored
+         * (because they are already in place).
+         */
+        sLenB = timGallopLeft(sMemA + (sBaseA + sLenA - 1) * sWidth,
+                              sMemB,
+                              sWidth,
+                              sBaseB,
+                              sLenB,
+                              sLenB - 1,
+                              aCmpCb);
+        // assert(sLenB >= 0);
+    }
+    else
+    {
+    }
+
+    if (sLenA == 0 || sLenB == 0)
+    {
+        /* in order already : one memory for both runs, the one of the longer */
+        if (sMemA != sMemB)
+        {
+            if (k + sLenA >= sOrgLenB)
+            {
+                memcpy(sMemA + sBaseB * sWidth, sMemB + sBaseB * sWidth, sWidth * sOrgLenB);
+                TIM_STAT_ADD(aState, mMoveCnt, sOrgLenB);
+            }
+            else
+            {
+                memcpy(sMemB + (sBaseA - k) * sWidth, sMemA + (sBaseA - k) * sWidth, sWidth * (k + sLenA));
+                TIM_STAT_ADD(aState, mMoveCnt, k + sLenA);
+                aState->mPendingRun[aWhere].mInAlt = sMemB == aState->mAltArray;
+            }
+        }
+        else
+        {
+        }
+
+        return;
+    }
+    else
+    {
+    }
+
+    if (aState->mAltArray != NULL)
+    {
+        aState->mPendingRun[aWhere].mInAlt = timMergePingPong(aState,
+                                                              sMemA, sBaseA, sLenA, k,
+                                                              sMemB, sBaseB, sLenB, sOrgLenB - sLenB,
+                                                              aCmpCb);
+        return;
+    }
+    else
+    {
+    }
 
     /*
      * Merge remaining runs, using tmp array with min(sLenA, sLenB) elements
@@ -1146,11 +1964,21 @@ static void timMergeAt(timMergeState *aState, uint32_t aWhere, cmpFunc *aCmpCb)
      */
     if (sLenA <= sLenB)
     {
-        timMergeLow(aState, sBaseA, sLenA, sBaseB, sLenB, aCmpCb);
+        timMergeGetMem(aState, sLenA);
+        memcpy(aState->mMergeMem, sMemA + sBaseA * sWidth, sWidth * sLenA);
+        TIM_STAT_ADD(aState, mMoveCnt, sLenA);
+
+        timMergeLow(aState, sMemA + sBaseA * sWidth,
+                    aState->mMergeMem, sLenA, sMemB + sBaseB * sWidth, sLenB, aCmpCb);
     }
     else
     {
-        timMergeHigh(aState, sBaseA, sLenA, sBaseB, sLenB, aCmpCb);
+        timMergeGetMem(aState, sLenB);
+        memcpy(aState->mMergeMem, sMemB + sBaseB * sWidth, sWidth * sLenB);
+        TIM_STAT_ADD(aState, mMoveCnt, sLenB);
+
+        timMergeHigh(aState, sMemA + sBaseA * sWidth,
+                     sMemA + sBaseA * sWidth, sLenA, aState->mMergeMem, sLenB, aCmpCb);
     }
 }
 
@@ -1170,11 +1998,11 @@ static void timMergeCollapse(timMergeState *aState, cmpFunc *aCmpCb)
     uint32_t  n;
     timSlice *sSlice = aState->mPendingRun;
 
-    while (aState->mPendingRunCnt > 1)
+    while (aState->mPendingRunCnt > aState->mPendingRunFloor + 1)
     {
         n = aState->mPendingRunCnt - 2;
 
-        if (n > 0 && sSlice[n-1].mLen <= sSlice[n].mLen + sSlice[n+1].mLen)
+        if (n > aState->mPendingRunFloor && sSlice[n-1].mLen <= sSlice[n].mLen + sSlice[n+1].mLen)
         {
             if (sSlice[n-1].mLen < sSlice[n+1].mLen)
             {
@@ -1198,18 +2026,18 @@ static void timMergeCollapse(timMergeState *aState, cmpFunc *aCmpCb)
 }
 
 /*
- * Merges all runs on the stack until only one remains.
+ * Merges all runs on the stack above mPendingRunFloor until only one remains.
  */
 static void timMergeForceCollapse(timMergeState *aState, cmpFunc *aCmpCb)
 {
-    int32_t  n;
+    uint32_t  n;
     timSlice *sSlice = aState->mPendingRun;
 
-    while (aState->mPendingRunCnt > 1)
+    while (aState->mPendingRunCnt > aState->mPendingRunFloor + 1)
     {
         n = aState->mPendingRunCnt - 2;
 
-        if (n > 0 && sSlice[n - 1].mLen < sSlice[n + 1].mLen)
+        if (n > aState->mPendingRunFloor && sSlice[n - 1].mLen < sSlice[n + 1].mLen)
         {
             n--;
         }
@@ -1217,11 +2045,63 @@ static void timMergeForceCollapse(timMergeState *aState, cmpFunc *aCmpCb)
         {
         }
 
-        timMergeAt(aState, (uint32_t)n, aCmpCb);
+        timMergeAt(aState, n, aCmpCb);
     }
 }
 
-void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *))
+/*
+ * -----------------------------------------------------------------------------
+ *  Run Formation
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Runs shorter than a block are merged with their neighbours into a run of
+ * about mRunBlock KiB before the main stack sees them, so that the first merge
+ * levels happen while the block is in the second level cache, and the main
+ * merges start from fewer, longer runs. Natural runs at least a block long are
+ * pushed as they are.
+ *
+ * Returns the elements of a block, 0 if there is no room for two minimum runs
+ * in one, that is no formation.
+ */
+static uint32_t timCalcBlockLen(timMergeState *aState, uint32_t aMinRunLen)
+{
+    size_t sBlockLen = ((size_t)aState->mConf.mRunBlock << 10) / TIM_WIDTH(aState);
+
+    return sBlockLen >= 2 * (size_t)aMinRunLen ? (uint32_t)sBlockLen : 0;
+}
+
+/*
+ * Opens a block : the collapses see only the runs pushed from now on
+ */
+static void timMergeOpenBlock(timMergeState *aState)
+{
+    aState->mPendingRunFloor = aState->mPendingRunCnt;
+}
+
+/*
+ * Merges the runs of the block into one, and that one into the main stack
+ */
+static void timMergeCloseBlock(timMergeState *aState, cmpFunc *aCmpCb)
+{
+    timMergeForceCollapse(aState, aCmpCb);
+
+    aState->mPendingRunFloor = 0;
+
+    timMergeCollapse(aState, aCmpCb);
+}
+
+/*
+ * The build of this policy, called by timsortConf() (timdispatch.c).
+ * aConf : settings that pass timConfCheck(). With TIM_MOVE_FIXED, aWidth is TIM_MOVE_WIDTH.
+ */
+void TIM_ENGINE_NAME(timsortEngine)(void          *aArray,
+                                    size_t         aElementCnt,
+                                    size_t         aWidth,
+                                    int          (*aCmpCb)(const void *, const void *),
+                                    const timConf *aConf,
+                                    timStat       *aStat)
 {
     cmpFunc       *sCmpCb = (cmpFunc *)aCmpCb;
     timMergeState  sState;
@@ -1235,26 +2115,60 @@ void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(cons
 
     size_t         sForcedRunLen;
 
+    uint32_t       sBlockLen;
+    uint32_t       sBlockElemCnt = 0;  /* of the block being formed, 0 if none */
+
     // assert(aElementCnt <= 0x7fffffff);
 
     if (sRemaining < 2)
     {
         /* Arrays of size 1 are always sorted. */
+        if (aStat != NULL)
+        {
+            memset(aStat, 0, sizeof(*aStat));
+            aStat->mEnabled = TIM_STAT_ENABLED;
+        }
+
         return;
     }
     else
     {
     }
 
-    timMergeStateInit(&sState, aArray, aWidth);
+    timMergeStateInit(&sState, aArray, aWidth, aConf);
+
+    if (sState.mConf.mBuffer == TIM_BUFFER_PINGPONG && aElementCnt >= sState.mConf.mMinMerge)
+    {
+        /* without it, the merges use mMergeMem */
+        sState.mAltArray = timAllocBuffer(&sState, aElementCnt * TIM_WIDTH(&sState), &sState.mAltArrayMapped);
 
-    sMinRunLen = timCalcMinRunLen(aElementCnt);
+        if (sState.mAltArray != NULL)
+        {
+            TIM_MERGE_MEM_PEAK(&sState, sState.mAltArrayMapped > 0 ? (uint64_t)sState.mAltArrayMapped
+                                                                   : (uint64_t)aElementCnt * TIM_WIDTH(&sState));
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+    }
+
+    /* the shorter run of a merge */
+    sState.mMergeLenMax = aElementCnt / 2;
+
+    sMinRunLen = timCalcMinRunLen(aElementCnt, sState.mConf.mMinMerge);
+    sBlockLen  = timCalcBlockLen(&sState, sMinRunLen);
     sRemaining = aElementCnt;
 
     do
     {
         sRunLen = timCountRunAndMakeAscending(&sState, sIndexLow, sIndexHigh, sCmpCb);
 
+        TIM_STAT_ADD(&sState, mNaturalRunCnt, 1);
+        TIM_STAT_ADD(&sState, mNaturalRunElemCnt, sRunLen);
+
         if (sRunLen < sMinRunLen)
         {
             sForcedRunLen = sRemaining <= sMinRunLen ? sRemaining : sMinRunLen;
@@ -1275,12 +2189,37 @@ void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(cons
         {
         }
 
+        if (sRunLen < sBlockLen)
+        {
+            if (sBlockElemCnt == 0) timMergeOpenBlock(&sState);
+
+            sBlockElemCnt += sRunLen;
+        }
+        else if (sBlockElemCnt > 0)
+        {
+            /* a natural run as long as a block stays what it is */
+            timMergeCloseBlock(&sState, sCmpCb);
+            sBlockElemCnt = 0;
+        }
+        else
+        {
+        }
+
         /*
          * Push this run onto pending-runs stack, and maybe merge
          */
         timMergeStatePushRun(&sState, sIndexLow, sRunLen);
         timMergeCollapse(&sState, sCmpCb);
 
+        if (sBlockElemCnt >= sBlockLen && sBlockElemCnt > 0)
+        {
+            timMergeCloseBlock(&sState, sCmpCb);
+            sBlockElemCnt = 0;
+        }
+        else
+        {
+        }
+
         /*
          * Advance to find next run
          */
@@ -1291,11 +2230,149 @@ void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(cons
 
     // assert(sIndexLow == sIndexHigh);
 
+    if (sBlockElemCnt > 0) timMergeCloseBlock(&sState, sCmpCb);
+
     /*
      * Merge all remaining runs to complete sort
      */
     timMergeForceCollapse(&sState, sCmpCb);
 
     // assert(sState.mPendingRunCnt == 1);
+
+    if (sState.mPendingRun[0].mInAlt == 1)
+    {
+        memcpy(aArray, sState.mAltArray, aElementCnt * TIM_WIDTH(&sState));
+        TIM_STAT_ADD(&sState, mMoveCnt, aElementCnt);
+    }
+    else
+    {
+    }
+
+    if (aStat != NULL)
+    {
+        *aStat = sState.mStat;
+    }
+    else
+    {
+    }
+
+    timMergeStateDestroy(&sState);
 }
 
+#ifdef TIM_KERNEL
+/*
+ * -----------------------------------------------------------------------------
+ *  Kernels, see timkernel.h
+ * -----------------------------------------------------------------------------
+ */
+#include "timkernel.h"
+
+static void *timKernelCreate(size_t aWidth)
+{
+    timMergeState *sState = malloc(sizeof(timMergeState));
+
+    if (sState != NULL)
+    {
+        timMergeStateInit(sState, NULL, aWidth, timConfGet(aWidth));
+    }
+    else
+    {
+    }
+
+    return sState;
+}
+
+static void timKernelDestroy(void *aState)
+{
+    timMergeStateDestroy((timMergeState *)aState);
+    free(aState);
+}
+
+static size_t timKernelCountRun(void *aState, void *aArray, size_t aCount, timKernelCmp *aCmpCb)
+{
+    timMergeState *sState = (timMergeState *)aState;
+
+    sState->mArray = aArray;
+
+    return timCountRunAndMakeAscending(sState, 0, (int32_t)aCount, aCmpCb);
+}
+
+static void timKernelBinarySort(void *aState, void *aArray, size_t aCount, size_t aSortedCnt, timKernelCmp *aCmpCb)
+{
+    timMergeState *sState = (timMergeState *)aState;
+
+    sState->mArray = aArray;
+
+    timDoBinarySort(sState, 0, (int32_t)aCount, (int32_t)aSortedCnt, aCmpCb);
+}
+
+static int32_t timKernelGallopLeft(const void   *aKey,
+                                   const void   *aArray,
+                                   size_t        aWidth,
+                                   int32_t       aLen,
+                                   int32_t       aHint,
+                                   timKernelCmp *aCmpCb)
+{
+    return timGallopLeft(aKey, (const uint8_t *)aArray, aWidth, 0, aLen, aHint, aCmpCb);
+}
+
+static int32_t timKernelGallopRight(const void   *aKey,
+                                    const void   *aArray,
+                                    size_t        aWidth,
+                                    int32_t       aLen,
+                                    int32_t       aHint,
+                                    timKernelCmp *aCmpCb)
+{
+    return timGallopRight(aKey, (const uint8_t *)aArray, aWidth, 0, aLen, aHint, aCmpCb);
+}
+
+static void timKernelMergeLow(void *aState, void *aArray, size_t aLen1, size_t aLen2, timKernelCmp *aCmpCb)
+{
+    timMergeState *sState = (timMergeState *)aState;
+
+    uint8_t       *sArray = (uint8_t *)aArray;
+
+    sState->mArray     = aArray;
+    sState->mMinGallop = timMinGallop(&sState->mConf);
+
+    timMergeGetMem(sState, (uint32_t)aLen1);
+    memcpy(sState->mMergeMem, sArray, TIM_WIDTH(sState) * aLen1);
+
+    timMergeLow(sState, sArray, sState->mMergeMem, (int32_t)aLen1,
+                sArray + aLen1 * TIM_WIDTH(sState), (int32_t)aLen2, aCmpCb);
+}
+
+static void timKernelMergeHigh(void *aState, void *aArray, size_t aLen1, size_t aLen2, timKernelCmp *aCmpCb)
+{
+    timMergeState *sState = (timMergeState *)aState;
+
+    uint8_t       *sArray = (uint8_t *)aArray;
+
+    sState->mArray     = aArray;
+    sState->mMinGallop = timMinGallop(&sState->mConf);
+
+    timMergeGetMem(sState, (uint32_t)aLen2);
+    memcpy(sState->mMergeMem, sArray + aLen1 * TIM_WIDTH(sState), TIM_WIDTH(sState) * aLen2);
+
+    timMergeHigh(sState, sArray, sArray, (int32_t)aLen1, sState->mMergeMem, (int32_t)aLen2, aCmpCb);
+}
+
+#if TIM_ADDRESSING == TIM_ADDRESSING_INDEX
+const timKernelSet gTimKernelIndex =
+{
+    "index",
+#else
+const timKernelSet gTimKernelPointer =
+{
+    "pointer",
+#endif
+    timKernelCreate,
+    timKernelDestroy,
+    timKernelCountRun,
+    timKernelBinarySort,
+    timKernelGallopLeft,
+    timKernelGallopRight,
+    timKernelMergeLow,
+    timKernelMergeHigh
+};
+#endif
@@ -6,6 +6,16 @@
 #include <string.h>
 #include <assert.h>
 
+#include "timstat.h"
+#include "timconf.h"
+
 void timsort(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *));
+void timsortStat(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *), timStat *aStat);
+/*
+ * aConf NULL for the profile of aWidth. Returns 0, or -1 without sorting if
+ * aConf does not pass timConfCheck().
+ */
+int32_t timsortConf(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *),
+                    const timConf *aConf, timStat *aStat);
 
 #endif
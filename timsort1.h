@@ -6,6 +6,16 @@
 #include <string.h>
 #include <assert.h>
 
+#include "timstat.h"
+#include "timconf.h"
+
+/*
+ * timsort() with the policies of the former pointer based engine (pointer
+ * addressing, byte moves, galloping merges), whatever the profile says. For comparisons.
+ */
 void timsort1(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *));
+void timsort1Stat(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *), timStat *aStat);
+int32_t timsort1Conf(void *aArray, size_t aElementCnt, size_t aWidth, int (*aCmpCb)(const void *, const void *),
+                     const timConf *aConf, timStat *aStat);
 
 #endif
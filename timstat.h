@@ -0,0 +1,34 @@
+#ifndef __TIM_STAT_H__
+#define __TIM_STAT_H__
+
+#include <stdint.h>
+
+/*
+ * Work counters of one sort, reported by timsortStat() and timsort1Stat().
+ *
+ * Counting is compiled in only if the library is built with TIM_STAT defined
+ * (make stat), so that the plain build does not pay for it.
+ * mEnabled tells whether the counters were filled. mMergeMemPeak, which costs
+ * nothing but at an allocation, is filled in every build.
+ *
+ * A move is one element written into the array or into the merge memory,
+ * whether by COPY, memcpy or memmove. A swap counts as two moves.
+ * A tag sort (see timconf.h) counts the moves of the tags, then those of
+ * the elements into their places.
+ */
+typedef struct timStat
+{
+    int32_t   mEnabled;
+
+    uint64_t  mMoveCnt;
+    uint64_t  mNaturalRunCnt;       /* runs found by timCountRunAndMakeAscending() */
+    uint64_t  mNaturalRunElemCnt;   /* elements in them, before being extended to minrun */
+    uint64_t  mMergeCnt;            /* timMergeAt() calls */
+    uint64_t  mGallopCnt;           /* timGallopLeft() and timGallopRight() calls */
+    uint64_t  mMergeMemPeak;        /* bytes of the largest merge memory timMergeGetMem() held,
+                                       the preallocated array included, or of the ping-pong buffer,
+                                       plus the tags of a tag sort. Memory of huge pages
+                                       counts as mapped, rounded up to 2MB */
+} timStat;
+
+#endif
@@ -0,0 +1,831 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "timsort.h"
+#include "timsort1.h"
+#include "pattern.h"
+
+/*
+ * Finds the timConf (timconf.h) that sorts fastest on this CPU, width by width,
+ * and writes it as a profile the sorts load through TIMSORT_PROFILE.
+ *
+ * A setting is scored by the geometric mean of its times on the gendata
+ * patterns, relative to the defaults. The policies (addressing, move, merge,
+ * buffer) come first, then the numbers, one after the other, keeping the best
+ * value of the previous ones, and a value is taken only
+ * if it is more than TUNE_MIN_GAIN faster than the one it replaces, so that
+ * noise leaves the defaults alone.
+ *
+ * The stream threshold only matters to merges that do not fit in the last
+ * level cache : it is tuned apart, on random arrays of twice that cache
+ * (-L), between never, the cache and twice the cache.
+ *
+ * With -f, the section of this CPU in the file is replaced and those of
+ * other CPUs are kept, so that one profile can serve several machines.
+ */
+
+#define TUNE_MAX_WIDTH_CNT      16
+#define TUNE_MAX_PATTERN_CNT    PATTERN_MAX
+#define TUNE_DEFAULT_COUNT      100000
+#define TUNE_DEFAULT_REPEAT_CNT 5
+#define TUNE_DEFAULT_WIDTHS     "4,8,16,32,64"
+#define TUNE_DEFAULT_PATTERNS   "random,sawtooth,almost,fewunique,zipf,interleaved"
+#define TUNE_MIN_GAIN           0.01        /* 1% */
+#define TUNE_KEY_SIZE           sizeof(uint32_t)
+#define TUNE_MAX_LINE_CNT       4096        /* lines of a profile merged with -f */
+#define TUNE_STREAM_REPEAT_CNT  3           /* at most, the arrays are large */
+#define TUNE_MAX_STREAM_SIZE    4096        /* MiB, -L */
+
+typedef int  tuneCmpFunc(const void *, const void *);
+typedef int32_t tuneSortFunc(void *, size_t, size_t, tuneCmpFunc *, const timConf *, timStat *);
+
+static const struct
+{
+    const char    *mName;
+    tuneSortFunc  *mSortFunc;
+    int32_t        mTakesPolicies;  /* timsort1() has fixed policies */
+} gEngine[] =
+{
+    { "tim",  timsortConf,  1 },
+    { "tim1", timsort1Conf, 0 },
+    { NULL,   NULL,         0 }
+};
+
+/*
+ * Values tried for each parameter, in the order the parameters are tuned
+ */
+static const uint32_t gMinGallopValue[] = { 1, 2, 3, 4, 5, 7, 10, 14, 20, 32 };
+static const uint32_t gMinMergeValue[]  = { 16, 24, 32, 48, 64, 96, 128, 256 };
+static const uint32_t gTempSizeValue[]  = { 64, 256, 1024, 4096, 16384 };
+static const uint32_t gAddressingValue[] = { TIM_ADDRESSING_INDEX, TIM_ADDRESSING_POINTER };
+static const uint32_t gMoveValue[]       = { TIM_MOVE_BYTES, TIM_MOVE_BLOCK, TIM_MOVE_FIXED };
+static const uint32_t gMergeValue[]      = { TIM_MERGE_GALLOP, TIM_MERGE_LINEAR };
+static const uint32_t gRunBlockValue[]   = { 0, 64, 128, 256, 512, 1024 };
+static const uint32_t gBufferValue[]     = { TIM_BUFFER_RUN, TIM_BUFFER_PINGPONG };
+static const uint32_t gHugePageValue[]   = { 0, 1024, 4096, 16384 };
+
+#define TUNE_ARRAY_CNT(_aArray)  (sizeof(_aArray) / sizeof((_aArray)[0]))
+
+typedef struct tuneConf
+{
+    uint32_t       mCount;
+    uint32_t       mRepeatCnt;
+    uint64_t       mSeed;
+    tuneSortFunc  *mSortFunc;
+    const char    *mEngineName;
+    int32_t        mTakesPolicies;
+    const char    *mFileName;
+    uint32_t       mStreamSize;     /* KiB of the arrays stream is tuned on, 0 : not tuned */
+
+    uint32_t       mWidthCnt;
+    size_t         mWidth[TUNE_MAX_WIDTH_CNT];
+
+    uint32_t       mPatternCnt;
+    patternId      mPattern[TUNE_MAX_PATTERN_CNT];
+} tuneConf;
+
+/*
+ * Arrays of one width : the elements of every pattern, and where they are sorted
+ */
+typedef struct tuneData
+{
+    size_t    mWidth;
+    uint8_t  *mSource[TUNE_MAX_PATTERN_CNT];
+    uint8_t  *mWork;
+    double   *mSample;
+} tuneData;
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Measurement
+ * -----------------------------------------------------------------------------
+ */
+static int tuneCompare(const void *aElem1, const void *aElem2)
+{
+    uint32_t sKey1;
+    uint32_t sKey2;
+
+    /* odd widths leave the key unaligned */
+    memcpy(&sKey1, aElem1, sizeof(sKey1));
+    memcpy(&sKey2, aElem2, sizeof(sKey2));
+
+    return (sKey1 > sKey2) - (sKey1 < sKey2);
+}
+
+static int tuneCompareDouble(const void *aElem1, const void *aElem2)
+{
+    double sValue1 = *(const double *)aElem1;
+    double sValue2 = *(const double *)aElem2;
+
+    return (sValue1 > sValue2) - (sValue1 < sValue2);
+}
+
+static double tuneNowNsec(void)
+{
+    struct timespec sNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+static void *tuneAlloc(size_t aSize)
+{
+    void *sMem = malloc(aSize);
+
+    if (sMem == NULL)
+    {
+        (void)fprintf(stderr, "error : malloc fail\n");
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return sMem;
+}
+
+static void tuneDataInit(const tuneConf *aConf, size_t aWidth, tuneData *aData)
+{
+    patternGen  sGen;
+    uint32_t   *sKey = tuneAlloc(sizeof(uint32_t) * aConf->mCount);
+    uint32_t    sDefault;
+    uint32_t    sMin;
+    uint32_t    i;
+    uint32_t    j;
+
+    aData->mWidth  = aWidth;
+    aData->mWork   = tuneAlloc(aConf->mCount * aWidth);
+    aData->mSample = tuneAlloc(sizeof(double) * aConf->mRepeatCnt);
+
+    for (i = 0; i < aConf->mPatternCnt; i++)
+    {
+        (void)patternTakesParam(aConf->mPattern[i], aConf->mCount, &sDefault, &sMin);
+
+        if (patternInit(&sGen, aConf->mPattern[i], aConf->mCount, sDefault, aConf->mSeed) != 0)
+        {
+            (void)fprintf(stderr, "error : malloc fail\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        patternFill(&sGen, 0, aConf->mCount, sKey);
+        patternDestroy(&sGen);
+
+        aData->mSource[i] = tuneAlloc(aConf->mCount * aWidth);
+        memset(aData->mSource[i], 0, aConf->mCount * aWidth);
+
+        for (j = 0; j < aConf->mCount; j++)
+        {
+            memcpy(aData->mSource[i] + (size_t)j * aWidth, &sKey[j], TUNE_KEY_SIZE);
+        }
+    }
+
+    free(sKey);
+}
+
+static void tuneDataDestroy(const tuneConf *aConf, tuneData *aData)
+{
+    uint32_t i;
+
+    for (i = 0; i < aConf->mPatternCnt; i++)
+    {
+        free(aData->mSource[i]);
+    }
+
+    free(aData->mWork);
+    free(aData->mSample);
+}
+
+/*
+ * Sum of the logs of the median times over the patterns, in ns.
+ * Lower is faster; a difference of d is a ratio of exp(d / patterns) in geometric mean.
+ */
+static double tuneScore(const tuneConf *aConf, tuneData *aData, const timConf *aSetting)
+{
+    size_t   sSize  = aConf->mCount * aData->mWidth;
+    double   sScore = 0;
+    double   sStart;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < aConf->mPatternCnt; i++)
+    {
+        /* warmup, not measured */
+        memcpy(aData->mWork, aData->mSource[i], sSize);
+        if ((*aConf->mSortFunc)(aData->mWork, aConf->mCount, aData->mWidth, tuneCompare, aSetting, NULL) != 0)
+        {
+            (void)fprintf(stderr, "error : candidate refused, %s.\n", timConfCheck(aSetting));
+            exit(1);
+        }
+        else
+        {
+        }
+
+        for (j = 0; j < aConf->mRepeatCnt; j++)
+        {
+            memcpy(aData->mWork, aData->mSource[i], sSize);
+
+            sStart = tuneNowNsec();
+            (void)(*aConf->mSortFunc)(aData->mWork, aConf->mCount, aData->mWidth, tuneCompare, aSetting, NULL);
+            aData->mSample[j] = tuneNowNsec() - sStart;
+        }
+
+        qsort(aData->mSample, aConf->mRepeatCnt, sizeof(double), tuneCompareDouble);
+
+        sScore += log(aData->mSample[aConf->mRepeatCnt / 2]);
+    }
+
+    return sScore;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Tuning
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Tries every value of one parameter of aBest, keeps the fastest.
+ * aValueName : names of the values of a policy, NULL for numbers
+ */
+static void tuneParameter(const tuneConf *aConf,
+                          tuneData       *aData,
+                          const char     *aName,
+                          uint32_t       *aParam,
+                          const uint32_t *aValue,
+                          uint32_t        aValueCnt,
+                          const char   *(*aValueName)(uint32_t),
+                          timConf        *aBest,
+                          double         *aBestScore,
+                          double          aDefaultScore)
+{
+    uint32_t sBestValue = *aParam;
+    double   sScore;
+    char     sValue[16];
+    uint32_t i;
+
+    for (i = 0; i < aValueCnt; i++)
+    {
+        if (aValue[i] == sBestValue) continue;
+
+        *aParam = aValue[i];
+        sScore  = tuneScore(aConf, aData, aBest);
+
+        if (aValueName != NULL)
+        {
+            (void)snprintf(sValue, sizeof(sValue), "%s", (*aValueName)(aValue[i]));
+        }
+        else
+        {
+            (void)snprintf(sValue, sizeof(sValue), "%u", aValue[i]);
+        }
+
+        (void)fprintf(stderr, "  width %3zu  %-10s %7s : %+6.1f%%\n",
+                      aData->mWidth, aName, sValue,
+                      (exp((sScore - aDefaultScore) / aConf->mPatternCnt) - 1) * 100);
+
+        if (exp((*aBestScore - sScore) / aConf->mPatternCnt) > 1 + TUNE_MIN_GAIN)
+        {
+            sBestValue  = aValue[i];
+            *aBestScore = sScore;
+        }
+        else
+        {
+        }
+    }
+
+    *aParam = sBestValue;
+}
+
+/*
+ * Whether aBest runs a build with streaming stores for aWidth, see timsort.c
+ */
+static int32_t tuneHasStream(const timConf *aBest, size_t aWidth)
+{
+#if defined(__x86_64__)
+    return aBest->mMove == TIM_MOVE_FIXED && (aWidth == 4 || aWidth == 8 || aWidth == 16);
+#else
+    (void)aBest;
+    (void)aWidth;
+
+    return 0;
+#endif
+}
+
+/*
+ * The stream threshold, on random arrays of mStreamSize KiB : never, half of them and all of them
+ */
+static void tuneStream(const tuneConf *aConf, size_t aWidth, timConf *aBest)
+{
+    tuneConf sConf = *aConf;
+    tuneData sData;
+    uint32_t sValue[3] = { 0, aConf->mStreamSize / 2, aConf->mStreamSize };
+    double   sDefaultScore;
+    double   sBestScore;
+
+    sConf.mCount      = (uint32_t)(((uint64_t)aConf->mStreamSize << 10) / aWidth);
+    sConf.mRepeatCnt  = aConf->mRepeatCnt < TUNE_STREAM_REPEAT_CNT ? aConf->mRepeatCnt : TUNE_STREAM_REPEAT_CNT;
+    sConf.mPatternCnt = 1;
+    sConf.mPattern[0] = PATTERN_RANDOM;
+
+    tuneDataInit(&sConf, aWidth, &sData);
+
+    sDefaultScore = tuneScore(&sConf, &sData, aBest);
+    sBestScore    = sDefaultScore;
+
+    tuneParameter(&sConf, &sData, "stream", &aBest->mStream, sValue,
+                  TUNE_ARRAY_CNT(sValue), NULL, aBest, &sBestScore, sDefaultScore);
+
+    tuneDataDestroy(&sConf, &sData);
+}
+
+static void tuneWidth(const tuneConf *aConf, size_t aWidth, timConf *aBest)
+{
+    tuneData sData;
+    double   sDefaultScore;
+    double   sBestScore;
+    uint32_t sTagValue[2] = { 0, (uint32_t)aWidth };   /* never, or this width and up */
+
+    tuneDataInit(aConf, aWidth, &sData);
+
+    timConfDefault(aBest);
+
+    sDefaultScore = tuneScore(aConf, &sData, aBest);
+    sBestScore    = sDefaultScore;
+
+    if (aConf->mTakesPolicies == 1)
+    {
+        tuneParameter(aConf, &sData, "addressing", &aBest->mAddressing, gAddressingValue,
+                      TUNE_ARRAY_CNT(gAddressingValue), timConfAddressingName, aBest, &sBestScore, sDefaultScore);
+        tuneParameter(aConf, &sData, "move", &aBest->mMove, gMoveValue,
+                      TUNE_ARRAY_CNT(gMoveValue), timConfMoveName, aBest, &sBestScore, sDefaultScore);
+        tuneParameter(aConf, &sData, "merge", &aBest->mMerge, gMergeValue,
+                      TUNE_ARRAY_CNT(gMergeValue), timConfMergeName, aBest, &sBestScore, sDefaultScore);
+        tuneParameter(aConf, &sData, "buffer", &aBest->mBuffer, gBufferValue,
+                      TUNE_ARRAY_CNT(gBufferValue), timConfBufferName, aBest, &sBestScore, sDefaultScore);
+    }
+    else
+    {
+    }
+
+    /* linear merges never gallop */
+    if (aBest->mMerge == TIM_MERGE_GALLOP)
+    {
+        tuneParameter(aConf, &sData, "mingallop", &aBest->mMinGallop, gMinGallopValue,
+                      TUNE_ARRAY_CNT(gMinGallopValue), NULL, aBest, &sBestScore, sDefaultScore);
+    }
+    else
+    {
+    }
+
+    tuneParameter(aConf, &sData, "minmerge", &aBest->mMinMerge, gMinMergeValue,
+                  TUNE_ARRAY_CNT(gMinMergeValue), NULL, aBest, &sBestScore, sDefaultScore);
+    tuneParameter(aConf, &sData, "tempsize", &aBest->mTempSize, gTempSizeValue,
+                  TUNE_ARRAY_CNT(gTempSizeValue), NULL, aBest, &sBestScore, sDefaultScore);
+
+    /* after minmerge, which sets the length of the runs blocks are formed of */
+    if (aConf->mTakesPolicies == 1)
+    {
+        tuneParameter(aConf, &sData, "runblock", &aBest->mRunBlock, gRunBlockValue,
+                      TUNE_ARRAY_CNT(gRunBlockValue), NULL, aBest, &sBestScore, sDefaultScore);
+        tuneParameter(aConf, &sData, "hugepage", &aBest->mHugePage, gHugePageValue,
+                      TUNE_ARRAY_CNT(gHugePageValue), NULL, aBest, &sBestScore, sDefaultScore);
+        tuneParameter(aConf, &sData, "tag", &aBest->mTag, sTagValue,
+                      TUNE_ARRAY_CNT(sTagValue), NULL, aBest, &sBestScore, sDefaultScore);
+    }
+    else
+    {
+    }
+
+    /* last, its arrays are of their own */
+    if (aConf->mTakesPolicies == 1 && aConf->mStreamSize > 0 && tuneHasStream(aBest, aWidth) == 1)
+    {
+        tuneStream(aConf, aWidth, aBest);
+    }
+    else
+    {
+    }
+
+    (void)fprintf(stderr, "width %zu : minmerge %u mingallop %u tempsize %u addressing %s move %s merge %s "
+                          "runblock %u buffer %s hugepage %u hugetlb %u stream %u tag %u, %.1f%% faster than the defaults\n",
+                  aWidth, aBest->mMinMerge, aBest->mMinGallop, aBest->mTempSize,
+                  timConfAddressingName(aBest->mAddressing), timConfMoveName(aBest->mMove),
+                  timConfMergeName(aBest->mMerge), aBest->mRunBlock, timConfBufferName(aBest->mBuffer),
+                  aBest->mHugePage, aBest->mHugeTlb, aBest->mStream, aBest->mTag,
+                  (1 - exp((sBestScore - sDefaultScore) / aConf->mPatternCnt)) * 100);
+
+    tuneDataDestroy(aConf, &sData);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Profile
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * The lines of aFileName but the section of aCpuName, to be written again
+ * before the new one. Nothing if there is no such file yet.
+ */
+static uint32_t tuneReadOtherCpus(const char *aFileName, const char *aCpuName, char **aLine)
+{
+    FILE     *sFile = fopen(aFileName, "r");
+    char      sLine[256];
+    int32_t   sSkip = 0;
+    uint32_t  sLineCnt = 0;
+    uint32_t  sLineNo = 0;
+
+    if (sFile == NULL)
+    {
+        if (errno == ENOENT) return 0;
+
+        (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n", aFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    while (fgets(sLine, sizeof(sLine), sFile) != NULL)
+    {
+        sLineNo++;
+        sLine[strcspn(sLine, "\r\n")] = '\0';
+
+        if (sLineNo == 1)
+        {
+            if (strcmp(sLine, TIM_PROFILE_MAGIC) != 0)
+            {
+                (void)fprintf(stderr, "error : '%s' is not a timsort profile, not overwriting it.\n", aFileName);
+                exit(1);
+            }
+            else
+            {
+            }
+
+            continue;
+        }
+        else if (strncmp(sLine, "cpu ", 4) == 0)
+        {
+            sSkip = strcmp(sLine + 4, aCpuName) == 0;
+        }
+        else
+        {
+        }
+
+        if (sSkip == 1) continue;
+
+        if (sLineCnt >= TUNE_MAX_LINE_CNT)
+        {
+            (void)fprintf(stderr, "error : '%s' has too many lines.\n", aFileName);
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aLine[sLineCnt] = strdup(sLine);
+        sLineCnt++;
+    }
+
+    (void)fclose(sFile);
+
+    return sLineCnt;
+}
+
+static void tuneWriteProfile(const tuneConf *aConf, const char *aCpuName, const timConf *aBest)
+{
+    char     **sLine = tuneAlloc(sizeof(char *) * TUNE_MAX_LINE_CNT);
+    uint32_t   sLineCnt = 0;
+    FILE      *sFile = stdout;
+    uint32_t   i;
+
+    if (aConf->mFileName != NULL)
+    {
+        sLineCnt = tuneReadOtherCpus(aConf->mFileName, aCpuName, sLine);
+        sFile    = fopen(aConf->mFileName, "w");
+
+        if (sFile == NULL)
+        {
+            (void)fprintf(stderr, "error : cannot open '%s'. %s (errno %d)\n",
+                          aConf->mFileName, strerror(errno), errno);
+            exit(1);
+        }
+        else
+        {
+        }
+    }
+    else
+    {
+    }
+
+    (void)fprintf(sFile, "%s\n", TIM_PROFILE_MAGIC);
+
+    for (i = 0; i < sLineCnt; i++)
+    {
+        (void)fprintf(sFile, "%s\n", sLine[i]);
+        free(sLine[i]);
+    }
+
+    (void)fprintf(sFile, "cpu %s\n", aCpuName);
+    (void)fprintf(sFile, "# %s, %u elements, median of %u\n", aConf->mEngineName, aConf->mCount, aConf->mRepeatCnt);
+
+    for (i = 0; i < aConf->mWidthCnt; i++)
+    {
+        (void)fprintf(sFile, "width %zu minmerge %u mingallop %u tempsize %u addressing %s move %s merge %s "
+                             "runblock %u buffer %s hugepage %u hugetlb %u stream %u tag %u\n",
+                      aConf->mWidth[i], aBest[i].mMinMerge, aBest[i].mMinGallop, aBest[i].mTempSize,
+                      timConfAddressingName(aBest[i].mAddressing), timConfMoveName(aBest[i].mMove),
+                      timConfMergeName(aBest[i].mMerge), aBest[i].mRunBlock, timConfBufferName(aBest[i].mBuffer),
+                      aBest[i].mHugePage, aBest[i].mHugeTlb, aBest[i].mStream, aBest[i].mTag);
+    }
+
+    if (sFile != stdout && fclose(sFile) != 0)
+    {
+        (void)fprintf(stderr, "error : cannot write '%s'. %s (errno %d)\n",
+                      aConf->mFileName, strerror(errno), errno);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    free(sLine);
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ *  Arguments
+ * -----------------------------------------------------------------------------
+ */
+static void printUsageAndExit(char *aProgramName)
+{
+    uint32_t i;
+
+    (void)fprintf(stderr, "Usage : %s [ options ]\n"
+                          "  -f FILE     write the profile to FILE, keeping the other CPUs it has\n"
+                          "              (default : stdout)\n"
+                          "  -W LIST     comma separated element widths to tune (default %s)\n"
+                          "  -g LIST     comma separated patterns to tune on (default %s)\n"
+                          "  -n NUM      elements of each sort (default %d)\n"
+                          "  -r NUM      measured repetitions, the median is taken (default %d)\n"
+                          "  -s NUM      seed of the keys (default 0)\n"
+                          "  -e ENGINE   tim or tim1 (default tim), tim1 tunes the numbers only\n"
+                          "  -L MIB      size of the random arrays the stream threshold is tuned on,\n"
+                          "              widths 4, 8 and 16 of fixed moves, 0 : not tuned\n"
+                          "              (default : twice the last level cache, at most an eighth of the memory)\n"
+                          "  Patterns :\n",
+                          aProgramName, TUNE_DEFAULT_WIDTHS, TUNE_DEFAULT_PATTERNS,
+                          TUNE_DEFAULT_COUNT, TUNE_DEFAULT_REPEAT_CNT);
+
+    for (i = PATTERN_NONE + 1; i < PATTERN_MAX; i++)
+    {
+        (void)fprintf(stderr, "        %-11s : %s\n", patternName(i), patternDesc(i));
+    }
+
+    exit(1);
+}
+
+static int32_t processArgGetInteger(char *aProgramName, char *aOption, char *aValue, int32_t aMin)
+{
+    long  sValue;
+    char *sEndPtr = NULL;
+
+    if (aValue == NULL)
+    {
+        (void)fprintf(stderr, "error : option '%s' needs to be provided with a value.\n", aOption);
+        printUsageAndExit(aProgramName);
+    }
+    else
+    {
+    }
+
+    errno  = 0;
+    sValue = strtol(aValue, &sEndPtr, 10);
+
+    if (errno == ERANGE || sValue > INT32_MAX || sValue < aMin || *sEndPtr != '\0' || sEndPtr == aValue)
+    {
+        (void)fprintf(stderr, "error : option '%s' accepts an integer of at least %d.\n", aOption, aMin);
+        exit(1);
+    }
+    else
+    {
+    }
+
+    return (int32_t)sValue;
+}
+
+static void processArgDetermineWidths(char *aProgramName, char *aList, tuneConf *aConf)
+{
+    char *sValue;
+    char *sSavePtr = NULL;
+
+    aConf->mWidthCnt = 0;
+
+    for (sValue = strtok_r(aList, ",", &sSavePtr); sValue != NULL; sValue = strtok_r(NULL, ",", &sSavePtr))
+    {
+        if (aConf->mWidthCnt >= TUNE_MAX_WIDTH_CNT)
+        {
+            (void)fprintf(stderr, "error : too many widths.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aConf->mWidth[aConf->mWidthCnt++] = processArgGetInteger(aProgramName, "-W", sValue, TUNE_KEY_SIZE);
+    }
+}
+
+static void processArgDeterminePatterns(char *aProgramName, char *aList, tuneConf *aConf)
+{
+    char      *sName;
+    char      *sSavePtr = NULL;
+    patternId  sPattern;
+
+    aConf->mPatternCnt = 0;
+
+    for (sName = strtok_r(aList, ",", &sSavePtr); sName != NULL; sName = strtok_r(NULL, ",", &sSavePtr))
+    {
+        sPattern = patternFind(sName);
+
+        if (sPattern == PATTERN_NONE)
+        {
+            (void)fprintf(stderr, "error : unknown pattern '%s'.\n", sName);
+            printUsageAndExit(aProgramName);
+        }
+        else
+        {
+        }
+
+        if (aConf->mPatternCnt >= TUNE_MAX_PATTERN_CNT)
+        {
+            (void)fprintf(stderr, "error : too many patterns.\n");
+            exit(1);
+        }
+        else
+        {
+        }
+
+        aConf->mPattern[aConf->mPatternCnt++] = sPattern;
+    }
+}
+
+/*
+ * KiB : twice the last level cache, at most an eighth of the memory, as the
+ * sort needs the array, its copy and merge memory. 0 if either is unknown.
+ */
+static uint32_t tuneDefaultStreamSize(void)
+{
+    long     sCache    = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    long     sPageCnt  = sysconf(_SC_PHYS_PAGES);
+    long     sPageSize = sysconf(_SC_PAGESIZE);
+    uint64_t sMemory;
+    uint64_t sSize;
+
+    if (sCache <= 0) sCache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+    if (sCache <= 0 || sPageCnt <= 0 || sPageSize <= 0) return 0;
+
+    sSize   = ((uint64_t)sCache * 2) >> 10;
+    sMemory = ((uint64_t)sPageCnt * sPageSize / 8) >> 10;
+
+    if (sSize > sMemory) sSize = sMemory;
+    if (sSize > (TUNE_MAX_STREAM_SIZE << 10)) sSize = TUNE_MAX_STREAM_SIZE << 10;
+
+    return (uint32_t)sSize;
+}
+
+static void processArg(int32_t aArgc, char *aArgv[], tuneConf *aConf)
+{
+    static char sDefaultWidths[]   = TUNE_DEFAULT_WIDTHS;
+    static char sDefaultPatterns[] = TUNE_DEFAULT_PATTERNS;
+
+    int32_t     i;
+    uint32_t    j;
+
+    aConf->mCount      = TUNE_DEFAULT_COUNT;
+    aConf->mRepeatCnt  = TUNE_DEFAULT_REPEAT_CNT;
+    aConf->mSeed       = 0;
+    aConf->mSortFunc   = gEngine[0].mSortFunc;
+    aConf->mEngineName = gEngine[0].mName;
+    aConf->mFileName   = NULL;
+    aConf->mStreamSize = tuneDefaultStreamSize();
+
+    aConf->mTakesPolicies = gEngine[0].mTakesPolicies;
+
+    processArgDetermineWidths(aArgv[0], sDefaultWidths, aConf);
+    processArgDeterminePatterns(aArgv[0], sDefaultPatterns, aConf);
+
+    for (i = 1; i < aArgc; i++)
+    {
+        char *sValue = (i + 1 < aArgc) ? aArgv[i + 1] : NULL;
+
+        if (strcmp(aArgv[i], "-f") == 0 && sValue != NULL)
+        {
+            aConf->mFileName = sValue;
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-W") == 0 && sValue != NULL)
+        {
+            processArgDetermineWidths(aArgv[0], sValue, aConf);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-g") == 0 && sValue != NULL)
+        {
+            processArgDeterminePatterns(aArgv[0], sValue, aConf);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-n") == 0)
+        {
+            aConf->mCount = processArgGetInteger(aArgv[0], aArgv[i], sValue, 2);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-r") == 0)
+        {
+            aConf->mRepeatCnt = processArgGetInteger(aArgv[0], aArgv[i], sValue, 1);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-s") == 0)
+        {
+            aConf->mSeed = processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-L") == 0)
+        {
+            aConf->mStreamSize = (uint32_t)processArgGetInteger(aArgv[0], aArgv[i], sValue, 0);
+
+            if (aConf->mStreamSize > TUNE_MAX_STREAM_SIZE)
+            {
+                (void)fprintf(stderr, "error : option '-L' accepts at most %d MiB.\n", TUNE_MAX_STREAM_SIZE);
+                exit(1);
+            }
+            else
+            {
+            }
+
+            aConf->mStreamSize <<= 10;
+            i++;
+        }
+        else if (strcmp(aArgv[i], "-e") == 0 && sValue != NULL)
+        {
+            for (j = 0; gEngine[j].mName != NULL; j++)
+            {
+                if (strcmp(sValue, gEngine[j].mName) == 0) break;
+            }
+
+            if (gEngine[j].mName == NULL)
+            {
+                (void)fprintf(stderr, "error : unknown engine '%s'.\n", sValue);
+                printUsageAndExit(aArgv[0]);
+            }
+            else
+            {
+            }
+
+            aConf->mSortFunc   = gEngine[j].mSortFunc;
+            aConf->mEngineName = gEngine[j].mName;
+
+            aConf->mTakesPolicies = gEngine[j].mTakesPolicies;
+            i++;
+        }
+        else
+        {
+            printUsageAndExit(aArgv[0]);
+        }
+    }
+}
+
+int32_t main(int32_t aArgc, char *aArgv[])
+{
+    tuneConf  sConf;
+    timConf   sBest[TUNE_MAX_WIDTH_CNT];
+    char      sCpuName[TIM_CPU_NAME_LEN];
+    uint32_t  i;
+
+    processArg(aArgc, aArgv, &sConf);
+
+    timConfCpuName(sCpuName, sizeof(sCpuName));
+
+    (void)fprintf(stderr, "Tuning %s on %s, %u elements, change from the defaults :\n",
+                  sConf.mEngineName, sCpuName, sConf.mCount);
+
+    for (i = 0; i < sConf.mWidthCnt; i++)
+    {
+        tuneWidth(&sConf, sConf.mWidth[i], &sBest[i]);
+    }
+
+    tuneWriteProfile(&sConf, sCpuName, sBest);
+
+    return 0;
+}